@@ -0,0 +1,246 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_CAPABILITIES_HXX
+#define SD_WMIPP_CAPABILITIES_HXX
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+#include "casefold.hxx"
+
+namespace wmipp
+{
+	/**
+	 * \brief Remembers which namespaces and classes are missing on this machine, so that probing for
+	 * optional features only pays for a failed connection or query once per time-to-live.
+	 * Entries expire on the system clock, so that they can be persisted across restarts with Save and Load.
+	 */
+	class CapabilityCache {
+	public:
+		explicit CapabilityCache(const std::chrono::seconds ttl = std::chrono::hours(24)) : ttl_(ttl) {}
+
+		/**
+		 * \brief Returns the process-wide cache consulted by every Interface.
+		 */
+		static CapabilityCache& Global() {
+			static CapabilityCache cache;
+			return cache;
+		}
+
+		/**
+		 * \brief Sets how long missing namespaces and classes are remembered. Existing entries keep their expiry.
+		 */
+		void SetTtl(const std::chrono::seconds ttl) {
+			const std::lock_guard lock(mutex_);
+			ttl_ = ttl;
+		}
+
+		/**
+		 * \param name The full namespace path, such as root\SecurityCenter2. Names are case-insensitive.
+		 */
+		void RecordMissingNamespace(const std::wstring_view name) {
+			Record(Key(name, {}));
+		}
+
+		void RecordMissingClass(const std::wstring_view name, const std::wstring_view class_name) {
+			Record(Key(name, class_name));
+		}
+
+		[[nodiscard]] bool IsNamespaceMissing(const std::wstring_view name) const {
+			return IsMissing(Key(name, {}));
+		}
+
+		/**
+		 * \brief Returns true if the class, or the namespace that would contain it, is known to be missing.
+		 */
+		[[nodiscard]] bool IsClassMissing(const std::wstring_view name, const std::wstring_view class_name) const {
+			return IsMissing(Key(name, class_name)) || IsMissing(Key(name, {}));
+		}
+
+		/**
+		 * \brief Returns true if nothing is known to be missing, which lets callers skip building keys.
+		 */
+		[[nodiscard]] bool empty() const {
+			return size_.load(std::memory_order_relaxed) == 0;
+		}
+
+		/**
+		 * \brief Forgets every missing namespace and class, for instance after installing a feature.
+		 */
+		void Clear() {
+			const std::lock_guard lock(mutex_);
+			expiries_.clear();
+			size_.store(0, std::memory_order_relaxed);
+		}
+
+		/**
+		 * \brief Writes the unexpired entries to a file, replacing it atomically.
+		 * \return false if the file could not be written.
+		 */
+		bool Save(const std::filesystem::path& path) const {
+			auto temporary = path;
+			temporary += ".tmp";
+			{
+				std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+				if (!file) return false;
+
+				file << kHeader << '\n';
+				const auto now = std::chrono::system_clock::now();
+				const std::lock_guard lock(mutex_);
+				for (const auto& [key, expiry] : expiries_) {
+					if (expiry <= now) continue;
+					file << std::chrono::duration_cast<std::chrono::seconds>(expiry.time_since_epoch()).count()
+						<< ' ' << Escape(key) << '\n';
+				}
+
+				if (!file.flush()) return false;
+			}
+
+			std::error_code error;
+			std::filesystem::rename(temporary, path, error);
+			return !error;
+		}
+
+		/**
+		 * \brief Adds the unexpired entries of a file written by Save. Malformed lines are ignored.
+		 * \return false if the file could not be read, or was not written by Save.
+		 */
+		bool Load(const std::filesystem::path& path) {
+			std::ifstream file(path, std::ios::binary);
+			std::string line;
+			if (!file || !std::getline(file, line) || line != kHeader) return false;
+
+			const auto now = std::chrono::system_clock::now();
+			const std::lock_guard lock(mutex_);
+			while (std::getline(file, line)) {
+				const auto space = line.find(' ');
+				if (space == std::string::npos || space == 0) continue;
+
+				std::int64_t seconds = 0;
+				auto valid = space <= 18;
+				for (std::size_t i = 0; i < space; ++i) {
+					valid &= line[i] >= '0' && line[i] <= '9';
+					seconds = seconds * 10 + (line[i] - '0');
+				}
+
+				const auto key = Unescape(std::string_view(line).substr(space + 1));
+				const std::chrono::system_clock::time_point expiry{std::chrono::seconds(seconds)};
+				if (!valid || !key || key->empty() || expiry <= now) continue;
+
+				auto& slot = expiries_[*key];
+				slot = (std::max)(slot, expiry);
+			}
+
+			size_.store(expiries_.size(), std::memory_order_relaxed);
+			return true;
+		}
+
+	private:
+		static constexpr const char* kHeader = "wmipp-capabilities 1";
+
+		mutable std::mutex mutex_;
+		mutable std::unordered_map<std::wstring, std::chrono::system_clock::time_point> expiries_;
+		mutable std::atomic<std::size_t> size_ = 0;
+		std::chrono::seconds ttl_;
+
+		/**
+		 * \brief Namespaces are keyed by their lower-case path, and classes by their lower-case path and
+		 * name separated by a colon, which namespace names cannot contain. Keys are folded with text::Fold,
+		 * which does not depend on the locale, so that a saved cache matches in any process.
+		 */
+		static std::wstring Key(const std::wstring_view name, const std::wstring_view class_name) {
+			std::wstring key(name);
+			if (!class_name.empty()) {
+				key += L':';
+				key += class_name;
+			}
+
+			std::transform(key.begin(), key.end(), key.begin(), [](const wchar_t c) {
+				return text::Fold(c);
+			});
+			return key;
+		}
+
+		void Record(std::wstring key) {
+			const std::lock_guard lock(mutex_);
+			expiries_[std::move(key)] = std::chrono::system_clock::now() + ttl_;
+			size_.store(expiries_.size(), std::memory_order_relaxed);
+		}
+
+		bool IsMissing(const std::wstring& key) const {
+			if (empty()) return false;
+
+			const std::lock_guard lock(mutex_);
+			const auto it = expiries_.find(key);
+			if (it == expiries_.end()) return false;
+			if (it->second > std::chrono::system_clock::now()) return true;
+
+			expiries_.erase(it);
+			size_.store(expiries_.size(), std::memory_order_relaxed);
+			return false;
+		}
+
+		/**
+		 * \brief Writes a key as printable ASCII, escaping backslashes and other characters as \uXXXX.
+		 */
+		static std::string Escape(const std::wstring_view key) {
+			std::string result;
+			for (const auto c : key) {
+				if (c > L' ' && c < 0x7F && c != L'\\') {
+					result += static_cast<char>(c);
+					continue;
+				}
+
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c) & 0xFFFF);
+				result += escaped;
+			}
+
+			return result;
+		}
+
+		static std::optional<std::wstring> Unescape(const std::string_view text) {
+			std::wstring result;
+			for (std::size_t i = 0; i < text.size(); ++i) {
+				if (text[i] != '\\') {
+					result += static_cast<wchar_t>(static_cast<unsigned char>(text[i]));
+					continue;
+				}
+
+				if (i + 6 > text.size() || text[i + 1] != 'u') return std::nullopt;
+
+				unsigned value = 0;
+				for (std::size_t j = i + 2; j < i + 6; ++j) {
+					const auto c = text[j];
+					const auto digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+					if (digit < 0) return std::nullopt;
+					value = value * 16 + static_cast<unsigned>(digit);
+				}
+
+				result += static_cast<wchar_t>(value);
+				i += 5;
+			}
+
+			return result;
+		}
+	};
+} // namespace wmipp
+
+#endif // SD_WMIPP_CAPABILITIES_HXX
@@ -0,0 +1,417 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_CASEFOLD_HXX
+#define SD_WMIPP_CASEFOLD_HXX
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The kernels process eight UTF-16 code units at a time with SSE2, which every x64 processor supports.
+// Define SD_WMIPP_NO_SIMD to use the scalar loops only.
+#if !defined(SD_WMIPP_NO_SIMD) && (defined(_M_X64) || defined(__SSE2__))
+#define SD_WMIPP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace wmipp::text
+{
+	namespace detail
+	{
+		/**
+		 * \brief Folds a non-ASCII code unit of the Latin-1, Latin Extended-A, Greek, Cyrillic or fullwidth Latin
+		 * blocks to its simple lower-case mapping. Other units are returned unchanged.
+		 */
+		constexpr char32_t FoldNonAscii(const char32_t c) {
+			// Latin-1 Supplement, except the multiplication sign.
+			if (c >= 0xC0 && c <= 0xDE) return c == 0xD7 ? c : c + 0x20;
+
+			// Latin Extended-A pairs upper and lower case, on even or odd code points depending on the range.
+			if (c == 0x0130) return U'i';
+			if (c == 0x0178) return 0xFF;
+			if ((c >= 0x0100 && c <= 0x012F) || (c >= 0x0132 && c <= 0x0137) || (c >= 0x014A && c <= 0x0177)) return c | 1;
+			if ((c >= 0x0139 && c <= 0x0148) || (c >= 0x0179 && c <= 0x017E)) return (c & 1) != 0 ? c + 1 : c;
+
+			// Greek, with the accented capitals placed apart from the others.
+			if (c == 0x0386) return 0x03AC;
+			if (c >= 0x0388 && c <= 0x038A) return c + 0x25;
+			if (c == 0x038C) return 0x03CC;
+			if (c == 0x038E || c == 0x038F) return c + 0x3F;
+			if (c >= 0x0391 && c <= 0x03AB) return c == 0x03A2 ? c : c + 0x20;
+
+			// Cyrillic.
+			if (c >= 0x0400 && c <= 0x040F) return c + 0x50;
+			if (c >= 0x0410 && c <= 0x042F) return c + 0x20;
+			if ((c >= 0x0460 && c <= 0x0481) || (c >= 0x048A && c <= 0x04BF) || (c >= 0x04D0 && c <= 0x052F)) return c | 1;
+			if (c == 0x04C0) return 0x04CF;
+			if (c >= 0x04C1 && c <= 0x04CE) return (c & 1) != 0 ? c + 1 : c;
+
+			// Fullwidth Latin capitals.
+			if (c >= 0xFF21 && c <= 0xFF3A) return c + 0x20;
+			return c;
+		}
+	} // namespace detail
+
+	/**
+	 * \brief Folds a character to lower case, as WQL does to compare strings.
+	 * The folding does not depend on the locale, so that strings compare the same way in every process.
+	 * ASCII characters are folded on a fast path, and the letters of other scripts than those of
+	 * detail::FoldNonAscii are compared as they are.
+	 */
+	template <typename Char>
+	[[nodiscard]] inline Char Fold(const Char c) {
+		const auto unit = static_cast<std::make_unsigned_t<Char>>(c);
+		if (unit < 0x80) {
+			return c >= Char('A') && c <= Char('Z') ? static_cast<Char>(c | 0x20) : c;
+		}
+
+		return static_cast<Char>(detail::FoldNonAscii(static_cast<char32_t>(unit)));
+	}
+
+	namespace detail
+	{
+#if defined(SD_WMIPP_SSE2)
+		template <typename Char>
+		constexpr bool kSimd = sizeof(Char) == 2;
+
+		inline __m128i Load(const void* data) {
+			return _mm_loadu_si128(static_cast<const __m128i*>(data));
+		}
+
+		/**
+		 * \brief Folds the ASCII upper-case letters of eight code units, leaving the others unchanged.
+		 * Units above 0x7FFF are negative as signed integers, and thus outside of the range.
+		 */
+		inline __m128i FoldAscii(const __m128i units) {
+			const auto upper = _mm_and_si128(
+				_mm_cmpgt_epi16(units, _mm_set1_epi16('A' - 1)),
+				_mm_cmplt_epi16(units, _mm_set1_epi16('Z' + 1)));
+			return _mm_or_si128(units, _mm_and_si128(upper, _mm_set1_epi16(0x20)));
+		}
+
+		/**
+		 * \brief Returns a byte mask of the lanes that differ once folded.
+		 */
+		inline int FoldedDifferences(const __m128i a, const __m128i b) {
+			return ~_mm_movemask_epi8(_mm_cmpeq_epi16(FoldAscii(a), FoldAscii(b))) & 0xFFFF;
+		}
+
+		/**
+		 * \brief Returns a byte mask of the lanes holding a non-ASCII unit, which must be folded one by one.
+		 */
+		inline int NonAscii(const __m128i units) {
+			const auto high = _mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xFF80)));
+			return ~_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) & 0xFFFF;
+		}
+#else
+		template <typename Char>
+		constexpr bool kSimd = false;
+#endif
+
+		template <typename Char>
+		[[nodiscard]] bool EqualsIgnoreCase(const Char* a, const Char* b, const std::size_t size) {
+			std::size_t i = 0;
+#if defined(SD_WMIPP_SSE2)
+			if constexpr (kSimd<Char>) {
+				for (; i + 8 <= size; i += 8) {
+					const auto x = Load(a + i), y = Load(b + i);
+					const auto differences = FoldedDifferences(x, y);
+					if (differences == 0) continue;
+
+					// ASCII lanes that differ once folded differ for good, others need the full fold.
+					if ((differences & ~NonAscii(_mm_or_si128(x, y))) != 0) return false;
+					for (std::size_t j = i; j < i + 8; ++j) {
+						if (Fold(a[j]) != Fold(b[j])) return false;
+					}
+				}
+			}
+#endif
+
+			for (; i < size; ++i) {
+				if (Fold(a[i]) != Fold(b[i])) return false;
+			}
+
+			return true;
+		}
+
+		template <typename Char>
+		[[nodiscard]] int CompareIgnoreCase(const Char* a, const Char* b, const std::size_t size) {
+			std::size_t i = 0;
+#if defined(SD_WMIPP_SSE2)
+			if constexpr (kSimd<Char>) {
+				// Skip the blocks that are equal once folded, and compare the first other block unit by unit.
+				while (i + 8 <= size && FoldedDifferences(Load(a + i), Load(b + i)) == 0) i += 8;
+			}
+#endif
+
+			for (; i < size; ++i) {
+				const auto x = Fold(a[i]), y = Fold(b[i]);
+				if (x != y) return x < y ? -1 : 1;
+			}
+
+			return 0;
+		}
+
+		/**
+		 * \brief Finds the first occurrence of a needle in a text, case-insensitively.
+		 * Candidates are found by comparing the first unit of the needle with eight units of the text at once.
+		 */
+		template <typename Char>
+		[[nodiscard]] std::size_t FindIgnoreCase(const Char* text, const std::size_t size, const Char* needle, const std::size_t length) {
+			if (length == 0) return 0;
+			if (length > size) return std::wstring_view::npos;
+
+			const auto first = Fold(needle[0]);
+			const auto last = size - length;
+			std::size_t i = 0;
+#if defined(SD_WMIPP_SSE2)
+			if constexpr (kSimd<Char>) {
+				if (static_cast<std::make_unsigned_t<Char>>(first) < 0x80) {
+					const auto target = _mm_set1_epi16(static_cast<short>(first));
+					for (; i + 8 <= last + 1; i += 8) {
+						const auto units = Load(text + i);
+						auto candidates = _mm_movemask_epi8(_mm_cmpeq_epi16(FoldAscii(units), target)) | NonAscii(units);
+						for (std::size_t lane = 0; candidates != 0; ++lane, candidates >>= 2) {
+							if ((candidates & 1) != 0 && EqualsIgnoreCase(text + i + lane, needle, length)) return i + lane;
+						}
+					}
+				}
+			}
+#endif
+
+			for (; i <= last; ++i) {
+				if (Fold(text[i]) == first && EqualsIgnoreCase(text + i, needle, length)) return i;
+			}
+
+			return std::wstring_view::npos;
+		}
+	} // namespace detail
+
+	/**
+	 * \brief Compares two strings case-insensitively, as WQL does for strings, keywords and names.
+	 */
+	[[nodiscard]] inline bool EqualsIgnoreCase(const std::wstring_view a, const std::wstring_view b) {
+		return a.size() == b.size() && detail::EqualsIgnoreCase(a.data(), b.data(), a.size());
+	}
+
+	/**
+	 * \brief Orders two strings case-insensitively.
+	 * \return A negative number, zero or a positive number if a sorts before, with or after b.
+	 */
+	[[nodiscard]] inline int CompareIgnoreCase(const std::wstring_view a, const std::wstring_view b) {
+		if (const auto order = detail::CompareIgnoreCase(a.data(), b.data(), (std::min)(a.size(), b.size()))) return order;
+		return (a.size() > b.size()) - (a.size() < b.size());
+	}
+
+	[[nodiscard]] inline bool StartsWithIgnoreCase(const std::wstring_view text, const std::wstring_view prefix) {
+		return text.size() >= prefix.size() && detail::EqualsIgnoreCase(text.data(), prefix.data(), prefix.size());
+	}
+
+	[[nodiscard]] inline bool EndsWithIgnoreCase(const std::wstring_view text, const std::wstring_view suffix) {
+		return text.size() >= suffix.size()
+			&& detail::EqualsIgnoreCase(text.data() + text.size() - suffix.size(), suffix.data(), suffix.size());
+	}
+
+	/**
+	 * \return The position of the first occurrence of the needle, or std::wstring_view::npos.
+	 */
+	[[nodiscard]] inline std::size_t FindIgnoreCase(const std::wstring_view text, const std::wstring_view needle) {
+		return detail::FindIgnoreCase(text.data(), text.size(), needle.data(), needle.size());
+	}
+
+	[[nodiscard]] inline bool ContainsIgnoreCase(const std::wstring_view text, const std::wstring_view needle) {
+		return FindIgnoreCase(text, needle) != std::wstring_view::npos;
+	}
+
+	/**
+	 * \brief A WQL LIKE pattern compiled for matching many strings, case-insensitively.
+	 * The pattern supports % (any sequence), _ (any character), [abc] and [a-z] (any character in
+	 * the set) and [^abc] (any character not in the set). Malformed sets match nothing.
+	 *
+	 * The pattern is split on % into pieces that each match a fixed number of characters. The first and
+	 * last pieces are anchored to the ends of the text, and the others are searched for from left to right,
+	 * so that svc%, %svc and %svc% reduce to a single prefix, suffix or substring search.
+	 */
+	class LikePattern {
+	public:
+		explicit LikePattern(const std::wstring_view pattern) {
+			pieces_.emplace_back();
+			for (std::size_t p = 0; p < pattern.size(); ++p) {
+				auto& piece = pieces_.back();
+				const auto c = pattern[p];
+				if (c == L'%') {
+					// Empty pieces between two % match anywhere, and are merged.
+					if (pieces_.size() == 1 || piece.length != 0) pieces_.emplace_back();
+					wildcard_ = true;
+				}
+				else if (c == L'_') {
+					piece.elements.push_back({Kind::Any, 0, 1, false});
+					++piece.length;
+				}
+				else if (c == L'[') {
+					p = ParseSet(pattern, p + 1, piece);
+					if (p == std::wstring_view::npos) {
+						valid_ = false;
+						return;
+					}
+				}
+				else {
+					if (piece.elements.empty() || piece.elements.back().kind != Kind::Literal) {
+						piece.elements.push_back({Kind::Literal, piece.text.size(), 0, false});
+					}
+
+					piece.text += Fold(c);
+					++piece.elements.back().length;
+					++piece.length;
+				}
+			}
+
+			for (auto& piece : pieces_) {
+				piece.literal = piece.elements.size() <= 1 && (piece.elements.empty() || piece.elements[0].kind == Kind::Literal);
+			}
+		}
+
+		/**
+		 * \return true if the whole text matches the pattern.
+		 */
+		[[nodiscard]] bool Matches(const std::wstring_view text) const {
+			if (!valid_) return false;
+
+			const auto& first = pieces_.front();
+			if (!wildcard_) return text.size() == first.length && MatchesAt(first, text.data());
+
+			const auto& last = pieces_.back();
+			if (first.length + last.length > text.size()) return false;
+			if (!MatchesAt(first, text.data()) || !MatchesAt(last, text.data() + text.size() - last.length)) return false;
+
+			auto begin = first.length;
+			const auto end = text.size() - last.length;
+			for (std::size_t i = 1; i + 1 < pieces_.size(); ++i) {
+				const auto position = Find(pieces_[i], text.data() + begin, end - begin);
+				if (position == std::wstring_view::npos) return false;
+				begin += position + pieces_[i].length;
+			}
+
+			return true;
+		}
+
+	private:
+		enum class Kind {
+			Literal,
+			Any,
+			Set,
+		};
+
+		/**
+		 * \brief A literal run (indexing the text of its piece), a _, or a set (indexing ranges_).
+		 */
+		struct Element {
+			Kind kind;
+			std::size_t begin;
+			std::size_t length;
+			bool negated;
+		};
+
+		struct Piece {
+			std::vector<Element> elements;
+
+			/**
+			 * \brief The folded characters of the literal runs.
+			 */
+			std::wstring text;
+
+			/**
+			 * \brief The number of characters matched by the piece.
+			 */
+			std::size_t length = 0;
+
+			/**
+			 * \brief Whether the piece only holds literal characters, and can be searched for as a string.
+			 */
+			bool literal = true;
+		};
+
+		std::vector<Piece> pieces_;
+		std::vector<std::pair<wchar_t, wchar_t>> ranges_;
+		bool wildcard_ = false;
+		bool valid_ = true;
+
+		/**
+		 * \brief Parses the set starting at pattern[p] (after the '['), and returns the index of the closing ']',
+		 * or npos if the set is malformed.
+		 */
+		std::size_t ParseSet(const std::wstring_view pattern, std::size_t p, Piece& piece) {
+			const auto negated = p < pattern.size() && pattern[p] == L'^';
+			if (negated) ++p;
+
+			const auto begin = ranges_.size();
+			for (; p < pattern.size() && pattern[p] != L']'; ++p) {
+				if (p + 2 < pattern.size() && pattern[p + 1] == L'-' && pattern[p + 2] != L']') {
+					ranges_.emplace_back(Fold(pattern[p]), Fold(pattern[p + 2]));
+					p += 2;
+				}
+				else {
+					ranges_.emplace_back(Fold(pattern[p]), Fold(pattern[p]));
+				}
+			}
+
+			if (p >= pattern.size()) return std::wstring_view::npos;
+
+			piece.elements.push_back({Kind::Set, begin, ranges_.size() - begin, negated});
+			++piece.length;
+			return p;
+		}
+
+		[[nodiscard]] bool MatchesAt(const Piece& piece, const wchar_t* text) const {
+			if (piece.literal) return detail::EqualsIgnoreCase(text, piece.text.data(), piece.length);
+
+			for (const auto& element : piece.elements) {
+				if (element.kind == Kind::Literal) {
+					if (!detail::EqualsIgnoreCase(text, piece.text.data() + element.begin, element.length)) return false;
+					text += element.length;
+					continue;
+				}
+
+				if (element.kind == Kind::Set) {
+					const auto c = Fold(*text);
+					auto matched = false;
+					for (auto i = element.begin; i < element.begin + element.length; ++i) {
+						matched |= c >= ranges_[i].first && c <= ranges_[i].second;
+					}
+
+					if (matched == element.negated) return false;
+				}
+
+				++text;
+			}
+
+			return true;
+		}
+
+		/**
+		 * \return The position of the leftmost match of a piece, or npos.
+		 */
+		[[nodiscard]] std::size_t Find(const Piece& piece, const wchar_t* text, const std::size_t size) const {
+			if (piece.literal) return detail::FindIgnoreCase(text, size, piece.text.data(), piece.length);
+			if (piece.length > size) return std::wstring_view::npos;
+
+			for (std::size_t i = 0; i + piece.length <= size; ++i) {
+				if (MatchesAt(piece, text + i)) return i;
+			}
+
+			return std::wstring_view::npos;
+		}
+	};
+} // namespace wmipp::text
+
+#endif // SD_WMIPP_CASEFOLD_HXX
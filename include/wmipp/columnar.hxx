@@ -0,0 +1,671 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_COLUMNAR_HXX
+#define SD_WMIPP_COLUMNAR_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "value.hxx"
+#include "wql.hxx"
+
+// The structures of the Arrow C data interface, as specified at
+// https://arrow.apache.org/docs/format/CDataInterface.html. The guard is shared with Arrow's own
+// headers, so that the definitions do not clash when both are included.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+	struct ArrowSchema {
+		const char* format;
+		const char* name;
+		const char* metadata;
+		int64_t flags;
+		int64_t n_children;
+		struct ArrowSchema** children;
+		struct ArrowSchema* dictionary;
+		void (*release)(struct ArrowSchema*);
+		void* private_data;
+	};
+
+	struct ArrowArray {
+		int64_t length;
+		int64_t null_count;
+		int64_t offset;
+		int64_t n_buffers;
+		int64_t n_children;
+		const void** buffers;
+		struct ArrowArray** children;
+		struct ArrowArray* dictionary;
+		void (*release)(struct ArrowArray*);
+		void* private_data;
+	};
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace wmipp
+{
+	namespace detail
+	{
+		/**
+		 * \brief Appends the UTF-8 encoding of a UTF-16 (or, where wchar_t is 32-bit, UTF-32) string.
+		 * Unpaired surrogates are replaced with U+FFFD.
+		 */
+		inline void AppendUtf8(std::string& output, const std::wstring_view text) {
+			for (std::size_t i = 0; i < text.size(); ++i) {
+				auto code_point = static_cast<std::uint32_t>(text[i]);
+				if constexpr (sizeof(wchar_t) == 2) {
+					if (code_point >= 0xD800 && code_point <= 0xDBFF && i + 1 < text.size() &&
+						text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+						code_point = 0x10000 + ((code_point - 0xD800) << 10) + (static_cast<std::uint32_t>(text[++i]) - 0xDC00);
+					}
+				}
+
+				if ((code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF) code_point = 0xFFFD;
+
+				if (code_point < 0x80) {
+					output += static_cast<char>(code_point);
+				}
+				else if (code_point < 0x800) {
+					output += static_cast<char>(0xC0 | (code_point >> 6));
+					output += static_cast<char>(0x80 | (code_point & 0x3F));
+				}
+				else if (code_point < 0x10000) {
+					output += static_cast<char>(0xE0 | (code_point >> 12));
+					output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+					output += static_cast<char>(0x80 | (code_point & 0x3F));
+				}
+				else {
+					output += static_cast<char>(0xF0 | (code_point >> 18));
+					output += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+					output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+					output += static_cast<char>(0x80 | (code_point & 0x3F));
+				}
+			}
+		}
+
+		/**
+		 * \brief Decodes a UTF-8 string produced by AppendUtf8.
+		 */
+		inline std::wstring FromUtf8(const std::string_view text) {
+			std::wstring result;
+			result.reserve(text.size());
+			for (std::size_t i = 0; i < text.size();) {
+				const auto lead = static_cast<unsigned char>(text[i]);
+				const auto length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+				std::uint32_t code_point = length == 1 ? lead : lead & (0xFF >> (length + 1));
+				for (auto j = 1; j < length && i + j < text.size(); ++j) {
+					code_point = (code_point << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+				}
+
+				i += length;
+				if (sizeof(wchar_t) == 2 && code_point >= 0x10000) {
+					code_point -= 0x10000;
+					result += static_cast<wchar_t>(0xD800 + (code_point >> 10));
+					result += static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF));
+				}
+				else {
+					result += static_cast<wchar_t>(code_point);
+				}
+			}
+
+			return result;
+		}
+
+		/**
+		 * \brief Formats a real with the fewest significant digits that parse back to the same value, so that
+		 * distinct reals get distinct text (std::to_wstring keeps six decimals).
+		 */
+		inline std::wstring FormatReal(const double real) {
+			wchar_t text[32];
+			for (auto precision = 15; precision < 17; ++precision) {
+				std::swprintf(text, std::size(text), L"%.*g", precision, real);
+				if (std::wcstod(text, nullptr) == real) return text;
+			}
+
+			std::swprintf(text, std::size(text), L"%.17g", real);
+			return text;
+		}
+
+		/**
+		 * \brief Formats a single-precision real with the fewest significant digits that parse back to it.
+		 */
+		inline std::wstring FormatReal(const float real) {
+			wchar_t text[32];
+			for (auto precision = 6; precision < 9; ++precision) {
+				std::swprintf(text, std::size(text), L"%.*g", precision, static_cast<double>(real));
+				if (std::wcstof(text, nullptr) == real) return text;
+			}
+
+			std::swprintf(text, std::size(text), L"%.9g", static_cast<double>(real));
+			return text;
+		}
+
+		struct ArrowSchemaHolder {
+			std::string format;
+			std::string name;
+			std::vector<std::unique_ptr<ArrowSchema>> children;
+			std::vector<ArrowSchema*> child_pointers;
+			std::unique_ptr<ArrowSchema> dictionary;
+		};
+
+		struct ArrowArrayHolder {
+			std::vector<std::vector<std::uint8_t>> storage;
+			std::vector<const void*> buffers;
+			std::vector<std::unique_ptr<ArrowArray>> children;
+			std::vector<ArrowArray*> child_pointers;
+			std::unique_ptr<ArrowArray> dictionary;
+		};
+
+		/**
+		 * \brief Releases an exported schema along with the children and dictionary that were not moved out.
+		 */
+		inline void ReleaseArrowSchema(ArrowSchema* schema) {
+			auto* holder = static_cast<ArrowSchemaHolder*>(schema->private_data);
+			for (auto* child : holder->child_pointers) {
+				if (child->release != nullptr) child->release(child);
+			}
+
+			if (holder->dictionary != nullptr && holder->dictionary->release != nullptr) {
+				holder->dictionary->release(holder->dictionary.get());
+			}
+
+			delete holder;
+			schema->release = nullptr;
+		}
+
+		/**
+		 * \brief Releases an exported array along with the children and dictionary that were not moved out.
+		 */
+		inline void ReleaseArrowArray(ArrowArray* array) {
+			auto* holder = static_cast<ArrowArrayHolder*>(array->private_data);
+			for (auto* child : holder->child_pointers) {
+				if (child->release != nullptr) child->release(child);
+			}
+
+			if (holder->dictionary != nullptr && holder->dictionary->release != nullptr) {
+				holder->dictionary->release(holder->dictionary.get());
+			}
+
+			delete holder;
+			array->release = nullptr;
+		}
+
+		inline void InitializeArrowSchema(ArrowSchema* schema, std::unique_ptr<ArrowSchemaHolder> holder, const std::int64_t flags) {
+			schema->format = holder->format.c_str();
+			schema->name = holder->name.c_str();
+			schema->metadata = nullptr;
+			schema->flags = flags;
+			schema->n_children = static_cast<std::int64_t>(holder->child_pointers.size());
+			schema->children = holder->child_pointers.empty() ? nullptr : holder->child_pointers.data();
+			schema->dictionary = holder->dictionary.get();
+			schema->release = &ReleaseArrowSchema;
+			schema->private_data = holder.release();
+		}
+
+		inline void InitializeArrowArray(
+			ArrowArray* array,
+			std::unique_ptr<ArrowArrayHolder> holder,
+			const std::int64_t length,
+			const std::int64_t null_count) {
+			array->length = length;
+			array->null_count = null_count;
+			array->offset = 0;
+			array->n_buffers = static_cast<std::int64_t>(holder->buffers.size());
+			array->n_children = static_cast<std::int64_t>(holder->child_pointers.size());
+			array->buffers = holder->buffers.empty() ? nullptr : holder->buffers.data();
+			array->children = holder->child_pointers.empty() ? nullptr : holder->child_pointers.data();
+			array->dictionary = holder->dictionary.get();
+			array->release = &ReleaseArrowArray;
+			array->private_data = holder.release();
+		}
+	} // namespace detail
+
+	/**
+	 * \brief A single typed column of a ColumnarTable.
+	 * The type of the column is the CIM type of its first non-null value, and later values are converted
+	 * to it, or stored as nulls if they cannot be. Strings are dictionary-encoded as UTF-8, so that columns
+	 * with repeated values (such as a status or a vendor name) store every distinct string once.
+	 * Arrays and embedded objects are stored as nulls.
+	 */
+	class Column {
+		friend class ColumnarTable;
+
+	public:
+		explicit Column(std::wstring name) : name_(std::move(name)) {}
+
+		[[nodiscard]] const std::wstring& GetName() const {
+			return name_;
+		}
+
+		/**
+		 * \brief Returns the CIM type of the column, or CimType::Empty if it only holds nulls so far.
+		 */
+		[[nodiscard]] CimType GetType() const {
+			return type_;
+		}
+
+		[[nodiscard]] std::size_t size() const {
+			return length_;
+		}
+
+		[[nodiscard]] std::size_t NullCount() const {
+			return null_count_;
+		}
+
+		/**
+		 * \brief Returns the number of distinct strings of a string column.
+		 */
+		[[nodiscard]] std::size_t DictionarySize() const {
+			return lookup_.size();
+		}
+
+		[[nodiscard]] bool IsNull(const std::size_t index) const {
+			return index >= length_ || (validity_[index / 8] & (1u << (index % 8))) == 0;
+		}
+
+		/**
+		 * \brief Reads the value at the given row. Strings are copied out of the dictionary.
+		 */
+		[[nodiscard]] Value GetAt(const std::size_t index) const {
+			if (IsNull(index)) return Value::Null(type_);
+
+			switch (type_) {
+			case CimType::Boolean: return (values_[index / 8] & (1u << (index % 8))) != 0;
+			case CimType::SInt8: return Load<std::int8_t>(index);
+			case CimType::UInt8: return Load<std::uint8_t>(index);
+			case CimType::SInt16: return Load<std::int16_t>(index);
+			case CimType::UInt16:
+			case CimType::Char16: return Load<std::uint16_t>(index);
+			case CimType::SInt32: return Load<std::int32_t>(index);
+			case CimType::UInt32: return Load<std::uint32_t>(index);
+			case CimType::SInt64: return Load<std::int64_t>(index);
+			case CimType::UInt64: return Load<std::uint64_t>(index);
+			case CimType::Real32: return Load<float>(index);
+			case CimType::Real64: return Load<double>(index);
+			default: break;
+			}
+
+			return Value(detail::FromUtf8(GetDictionaryEntry(static_cast<std::size_t>(Load<std::int32_t>(index)))), type_);
+		}
+
+		/**
+		 * \brief Returns the index in the dictionary of the string at the given row, so that work done
+		 * on every distinct string can be reused for the rows that repeat it.
+		 * \return The index, or std::nullopt for nulls and columns that do not hold strings.
+		 */
+		[[nodiscard]] std::optional<std::size_t> GetDictionaryIndex(const std::size_t index) const {
+			if (!IsDictionary(type_) || IsNull(index)) return std::nullopt;
+			return static_cast<std::size_t>(Load<std::int32_t>(index));
+		}
+
+		/**
+		 * \brief Returns a distinct string of a string column, as UTF-8.
+		 * \param entry An index below DictionarySize.
+		 */
+		[[nodiscard]] std::string_view GetDictionaryEntry(const std::size_t entry) const {
+			const auto begin = LoadOffset(entry);
+			const auto end = LoadOffset(entry + 1);
+			return std::string_view(reinterpret_cast<const char*>(dictionary_.data()) + begin, end - begin);
+		}
+
+		/**
+		 * \brief Appends a value to the column, converting it to the type of the column.
+		 */
+		void Append(const Value& value) {
+			if (value.IsNull() || value.IsArray()) return AppendNull();
+
+			if (type_ == CimType::Empty) {
+				const auto type = value.GetElementType();
+				if (Width(type) == 0 && !IsDictionary(type)) return AppendNull();
+
+				// Back-fill the values of the leading nulls now that their width is known.
+				type_ = type;
+				if (IsDictionary(type_)) PushOffset(0);
+				const auto nulls = length_;
+				for (length_ = 0; length_ < nulls; ++length_) StorePlaceholder();
+			}
+
+			if (!StoreValue(value)) return AppendNull();
+
+			SetValidity(true);
+			++length_;
+		}
+
+		void AppendNull() {
+			if (type_ != CimType::Empty) StorePlaceholder();
+			SetValidity(false);
+			++null_count_;
+			++length_;
+		}
+
+	private:
+		std::wstring name_;
+		CimType type_ = CimType::Empty;
+		std::size_t length_ = 0;
+		std::size_t null_count_ = 0;
+
+		/**
+		 * \brief The validity bitmap, with one bit per row that is set for non-null values.
+		 */
+		std::vector<std::uint8_t> validity_;
+
+		/**
+		 * \brief The fixed-width values, the bits of a boolean column, or the dictionary indices of a string column.
+		 */
+		std::vector<std::uint8_t> values_;
+
+		/**
+		 * \brief The int32 offsets and the UTF-8 bytes of the distinct strings of a string column.
+		 */
+		std::vector<std::uint8_t> offsets_;
+		std::vector<std::uint8_t> dictionary_;
+		std::unordered_map<std::string, std::int32_t> lookup_;
+
+		[[nodiscard]] static std::size_t Width(const CimType type) {
+			switch (type) {
+			case CimType::SInt8:
+			case CimType::UInt8: return 1;
+			case CimType::SInt16:
+			case CimType::UInt16:
+			case CimType::Char16: return 2;
+			case CimType::SInt32:
+			case CimType::UInt32:
+			case CimType::Real32: return 4;
+			case CimType::SInt64:
+			case CimType::UInt64:
+			case CimType::Real64: return 8;
+			default: return type == CimType::Boolean ? 1 : 0;
+			}
+		}
+
+		[[nodiscard]] static bool IsDictionary(const CimType type) {
+			return type == CimType::String || type == CimType::DateTime || type == CimType::Reference;
+		}
+
+		/**
+		 * \brief Returns the Arrow format string of the values of a column of the given type.
+		 */
+		[[nodiscard]] static const char* ArrowFormat(const CimType type) {
+			switch (type) {
+			case CimType::Boolean: return "b";
+			case CimType::SInt8: return "c";
+			case CimType::UInt8: return "C";
+			case CimType::SInt16: return "s";
+			case CimType::UInt16:
+			case CimType::Char16: return "S";
+			case CimType::SInt32: return "i";
+			case CimType::UInt32: return "I";
+			case CimType::SInt64: return "l";
+			case CimType::UInt64: return "L";
+			case CimType::Real32: return "f";
+			case CimType::Real64: return "g";
+			case CimType::Empty: return "n";
+			default: return "i";
+			}
+		}
+
+		void PushOffset(const std::int32_t offset) {
+			const auto size = offsets_.size();
+			offsets_.resize(size + sizeof(offset));
+			std::memcpy(offsets_.data() + size, &offset, sizeof(offset));
+		}
+
+		template <typename T>
+		void Push(const T value) {
+			const auto size = values_.size();
+			values_.resize(size + sizeof(T));
+			std::memcpy(values_.data() + size, &value, sizeof(T));
+		}
+
+		template <typename T>
+		[[nodiscard]] T Load(const std::size_t index) const {
+			T value;
+			std::memcpy(&value, values_.data() + index * sizeof(T), sizeof(T));
+			return value;
+		}
+
+		[[nodiscard]] std::size_t LoadOffset(const std::size_t index) const {
+			std::int32_t offset;
+			std::memcpy(&offset, offsets_.data() + index * sizeof(offset), sizeof(offset));
+			return static_cast<std::size_t>(offset);
+		}
+
+		void SetBit(std::vector<std::uint8_t>& bitmap, const bool bit) const {
+			if (length_ % 8 == 0) bitmap.push_back(0);
+			if (bit) bitmap.back() |= static_cast<std::uint8_t>(1u << (length_ % 8));
+		}
+
+		void SetValidity(const bool valid) {
+			SetBit(validity_, valid);
+		}
+
+		/**
+		 * \brief Appends the value stored for a null row.
+		 */
+		void StorePlaceholder() {
+			if (type_ == CimType::Boolean) SetBit(values_, false);
+			else if (IsDictionary(type_)) Push<std::int32_t>(0);
+			else values_.resize(values_.size() + Width(type_));
+		}
+
+		template <typename T, typename S>
+		bool PushInteger(const std::optional<S> value) {
+			if (!value || *value < (std::numeric_limits<T>::min)() || *value > (std::numeric_limits<T>::max)()) {
+				return false;
+			}
+
+			Push(static_cast<T>(*value));
+			return true;
+		}
+
+		bool StoreValue(const Value& value) {
+			switch (type_) {
+			case CimType::Boolean: {
+				const auto bit = value.AsBool();
+				if (!bit) return false;
+				SetBit(values_, *bit);
+				return true;
+			}
+			case CimType::SInt8: return PushInteger<std::int8_t>(value.AsInt64());
+			case CimType::SInt16: return PushInteger<std::int16_t>(value.AsInt64());
+			case CimType::SInt32: return PushInteger<std::int32_t>(value.AsInt64());
+			case CimType::SInt64: return PushInteger<std::int64_t>(value.AsInt64());
+			case CimType::UInt8: return PushInteger<std::uint8_t>(value.AsUInt64());
+			case CimType::UInt16:
+			case CimType::Char16: return PushInteger<std::uint16_t>(value.AsUInt64());
+			case CimType::UInt32: return PushInteger<std::uint32_t>(value.AsUInt64());
+			case CimType::UInt64: return PushInteger<std::uint64_t>(value.AsUInt64());
+			case CimType::Real32:
+			case CimType::Real64: {
+				const auto number = value.AsDouble();
+				if (!number) return false;
+				if (type_ == CimType::Real32) Push(static_cast<float>(*number));
+				else Push(*number);
+				return true;
+			}
+			default: break;
+			}
+
+			const auto text = value.AsString();
+			if (!text) return false;
+
+			std::string utf8;
+			detail::AppendUtf8(utf8, *text);
+			const auto [it, inserted] = lookup_.try_emplace(std::move(utf8), static_cast<std::int32_t>(lookup_.size()));
+			if (inserted) {
+				if (dictionary_.size() + it->first.size() > static_cast<std::size_t>((std::numeric_limits<std::int32_t>::max)())) {
+					lookup_.erase(it);
+					return false;
+				}
+
+				dictionary_.insert(dictionary_.end(), it->first.begin(), it->first.end());
+				PushOffset(static_cast<std::int32_t>(dictionary_.size()));
+			}
+
+			Push(it->second);
+			return true;
+		}
+	};
+
+	/**
+	 * \brief A result stored column by column, which can be exported through the Arrow C data interface.
+	 */
+	class ColumnarTable {
+	public:
+		ColumnarTable() = default;
+
+		explicit ColumnarTable(const std::vector<std::wstring>& names) {
+			columns_.reserve(names.size());
+			for (const auto& name : names) columns_.emplace_back(name);
+		}
+
+		[[nodiscard]] std::size_t RowCount() const {
+			return rows_;
+		}
+
+		[[nodiscard]] std::size_t ColumnCount() const {
+			return columns_.size();
+		}
+
+		/**
+		 * \throws std::out_of_range if the index is out of range.
+		 */
+		[[nodiscard]] const Column& GetColumn(const std::size_t index) const {
+			return columns_.at(index);
+		}
+
+		/**
+		 * \brief Finds a column by name, case-insensitively.
+		 */
+		[[nodiscard]] const Column* FindColumn(const std::wstring_view name) const {
+			for (const auto& column : columns_) {
+				if (wql::EqualsIgnoreCase(column.GetName(), name)) return &column;
+			}
+
+			return nullptr;
+		}
+
+		/**
+		 * \brief Appends a row, holding one value per column in column order. Missing values are nulls.
+		 */
+		void AppendRow(const std::vector<Value>& row) {
+			for (std::size_t i = 0; i < columns_.size(); ++i) {
+				if (i < row.size()) columns_[i].Append(row[i]);
+				else columns_[i].AppendNull();
+			}
+
+			++rows_;
+		}
+
+		/**
+		 * \brief Exports the table as an Arrow struct array, with one child per column.
+		 * The buffers of the columns are handed over without being copied, and are freed by the release
+		 * callbacks of the exported structures. The table is left empty.
+		 * Numeric and boolean columns are exported as their Arrow types, string columns as dictionary
+		 * arrays with int32 indices and utf8 values, and columns that only hold nulls as the null type.
+		 * \param schema Receives the schema of the table.
+		 * \param array Receives the data of the table.
+		 */
+		void ExportArrow(ArrowSchema* schema, ArrowArray* array) {
+			auto schema_holder = std::make_unique<detail::ArrowSchemaHolder>();
+			auto array_holder = std::make_unique<detail::ArrowArrayHolder>();
+			schema_holder->format = "+s";
+			array_holder->buffers.push_back(nullptr);
+
+			for (auto& column : columns_) {
+				schema_holder->children.push_back(std::make_unique<ArrowSchema>());
+				schema_holder->child_pointers.push_back(schema_holder->children.back().get());
+				array_holder->children.push_back(std::make_unique<ArrowArray>());
+				array_holder->child_pointers.push_back(array_holder->children.back().get());
+				ExportColumn(column, schema_holder->child_pointers.back(), array_holder->child_pointers.back());
+			}
+
+			const auto rows = static_cast<std::int64_t>(rows_);
+			detail::InitializeArrowSchema(schema, std::move(schema_holder), 0);
+			detail::InitializeArrowArray(array, std::move(array_holder), rows, 0);
+
+			columns_.clear();
+			rows_ = 0;
+		}
+
+	private:
+		std::vector<Column> columns_;
+		std::size_t rows_ = 0;
+
+		static void ExportColumn(Column& column, ArrowSchema* schema, ArrowArray* array) {
+			// Buffers of empty columns must still point somewhere.
+			static constexpr std::uint64_t kEmpty = 0;
+			const auto pointer = [](const std::vector<std::uint8_t>& buffer) -> const void* {
+				return buffer.empty() ? static_cast<const void*>(&kEmpty) : buffer.data();
+			};
+
+			auto schema_holder = std::make_unique<detail::ArrowSchemaHolder>();
+			schema_holder->format = Column::ArrowFormat(column.type_);
+			std::string name;
+			detail::AppendUtf8(name, column.name_);
+			schema_holder->name = std::move(name);
+
+			auto array_holder = std::make_unique<detail::ArrowArrayHolder>();
+			if (column.type_ != CimType::Empty) {
+				array_holder->storage.push_back(std::move(column.validity_));
+				array_holder->storage.push_back(std::move(column.values_));
+				array_holder->buffers.push_back(column.null_count_ == 0 ? nullptr : pointer(array_holder->storage[0]));
+				array_holder->buffers.push_back(pointer(array_holder->storage[1]));
+			}
+
+			if (Column::IsDictionary(column.type_)) {
+				auto dictionary_schema = std::make_unique<detail::ArrowSchemaHolder>();
+				dictionary_schema->format = "u";
+				schema_holder->dictionary = std::make_unique<ArrowSchema>();
+				detail::InitializeArrowSchema(schema_holder->dictionary.get(), std::move(dictionary_schema), 0);
+
+				auto dictionary_array = std::make_unique<detail::ArrowArrayHolder>();
+				dictionary_array->storage.push_back(std::move(column.offsets_));
+				dictionary_array->storage.push_back(std::move(column.dictionary_));
+				dictionary_array->buffers.push_back(nullptr);
+				dictionary_array->buffers.push_back(pointer(dictionary_array->storage[0]));
+				dictionary_array->buffers.push_back(pointer(dictionary_array->storage[1]));
+				array_holder->dictionary = std::make_unique<ArrowArray>();
+				detail::InitializeArrowArray(
+					array_holder->dictionary.get(),
+					std::move(dictionary_array),
+					static_cast<std::int64_t>(column.lookup_.size()),
+					0);
+				column.lookup_.clear();
+			}
+
+			detail::InitializeArrowSchema(schema, std::move(schema_holder), ARROW_FLAG_NULLABLE);
+			detail::InitializeArrowArray(
+				array,
+				std::move(array_holder),
+				static_cast<std::int64_t>(column.length_),
+				static_cast<std::int64_t>(column.null_count_));
+		}
+	};
+} // namespace wmipp
+
+#endif // SD_WMIPP_COLUMNAR_HXX
@@ -0,0 +1,222 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_FINGERPRINT_HXX
+#define SD_WMIPP_FINGERPRINT_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace wmipp
+{
+	/**
+	 * \brief A 128-bit digest of the property values of an object or a result.
+	 * Fingerprints are not cryptographic: they detect changes, not tampering.
+	 */
+	struct Fingerprint {
+		std::uint64_t high = 0;
+		std::uint64_t low = 0;
+
+		bool operator==(const Fingerprint& other) const {
+			return high == other.high && low == other.low;
+		}
+
+		bool operator!=(const Fingerprint& other) const {
+			return !(*this == other);
+		}
+
+		/**
+		 * \brief Formats the fingerprint as 32 lower-case hexadecimal digits.
+		 * Wrapped in double quotes, the text is a valid HTTP entity tag.
+		 */
+		[[nodiscard]] std::wstring ToString() const {
+			static constexpr wchar_t kDigits[] = L"0123456789abcdef";
+			std::wstring result(32, L'0');
+			for (std::size_t i = 0; i < 16; ++i) {
+				result[15 - i] = kDigits[(high >> (i * 4)) & 0xF];
+				result[31 - i] = kDigits[(low >> (i * 4)) & 0xF];
+			}
+
+			return result;
+		}
+
+		/**
+		 * \brief Parses a fingerprint formatted by ToString, optionally wrapped in double quotes.
+		 * \return The fingerprint, or std::nullopt if the text is not 32 hexadecimal digits.
+		 */
+		[[nodiscard]] static std::optional<Fingerprint> Parse(std::wstring_view text) {
+			if (text.size() == 34 && text.front() == L'"' && text.back() == L'"') {
+				text = text.substr(1, 32);
+			}
+
+			if (text.size() != 32) return std::nullopt;
+
+			Fingerprint result;
+			for (std::size_t i = 0; i < 32; ++i) {
+				const auto c = text[i];
+				std::uint64_t digit;
+				if (c >= L'0' && c <= L'9') digit = c - L'0';
+				else if (c >= L'a' && c <= L'f') digit = c - L'a' + 10;
+				else if (c >= L'A' && c <= L'F') digit = c - L'A' + 10;
+				else return std::nullopt;
+
+				auto& half = i < 16 ? result.high : result.low;
+				half = (half << 4) | digit;
+			}
+
+			return result;
+		}
+	};
+
+	namespace detail
+	{
+		/**
+		 * \brief Computes a Fingerprint over a sequence of values.
+		 * Every call to Update is a separate field, so variable-length data should be preceded by its length.
+		 */
+		class Hasher {
+		public:
+			void Update(const std::uint64_t value) {
+				Mix(value);
+				++fields_;
+			}
+
+			void Update(const void* data, const std::size_t size) {
+				const auto* bytes = static_cast<const unsigned char*>(data);
+				std::size_t i = 0;
+				for (; i + 8 <= size; i += 8) {
+					std::uint64_t word;
+					std::memcpy(&word, bytes + i, 8);
+					Mix(word);
+				}
+
+				// Pad the tail with its length, so that trailing zero bytes are not lost.
+				std::uint64_t tail = static_cast<std::uint64_t>(size - i) << 56;
+				if (size > i) std::memcpy(&tail, bytes + i, size - i);
+				Mix(tail);
+				++fields_;
+			}
+
+			void Update(const std::wstring_view text) {
+				Update(text.size());
+				Update(text.data(), text.size() * sizeof(wchar_t));
+			}
+
+			/**
+			 * \brief Hashes text as its UTF-16 code units in little-endian order, whatever the width of wchar_t
+			 * and the byte order of the host, so that hashes can be compared across hosts.
+			 * Where wchar_t holds little-endian UTF-16, as on Windows, this is the same as Update(text).
+			 */
+			void UpdateUtf16(const std::wstring_view text) {
+				std::uint64_t word = 0;
+				std::size_t units = 0;
+				const auto append = [&](const std::uint64_t unit) {
+					word |= unit << (16 * (units++ % 4));
+					if (units % 4 == 0) {
+						Mix(word);
+						word = 0;
+					}
+				};
+
+				std::size_t length = text.size();
+				if constexpr (sizeof(wchar_t) > 2) {
+					length = 0;
+					for (const auto c : text) length += static_cast<std::uint32_t>(c) > 0xFFFF && static_cast<std::uint32_t>(c) <= 0x10FFFF ? 2 : 1;
+				}
+
+				Update(length);
+				for (const auto c : text) {
+					auto code_point = static_cast<std::uint32_t>(c);
+					if (code_point > 0x10FFFF) code_point = 0xFFFD;
+					if (code_point > 0xFFFF) {
+						code_point -= 0x10000;
+						append(0xD800 + (code_point >> 10));
+						append(0xDC00 + (code_point & 0x3FF));
+					}
+					else {
+						append(code_point);
+					}
+				}
+
+				// Like the tail of Update(data, size), the last word ends with its length in bytes.
+				Mix(word | (static_cast<std::uint64_t>(units % 4 * 2) << 56));
+				++fields_;
+			}
+
+			[[nodiscard]] Fingerprint Finish() const {
+				const auto a = a_ ^ fields_;
+				const auto b = b_ ^ (fields_ * kMultiplier2);
+				return {Avalanche(a + b), Avalanche(b + Rotate(a, 32))};
+			}
+
+		private:
+			static constexpr std::uint64_t kMultiplier1 = 0x9E3779B97F4A7C15ull;
+			static constexpr std::uint64_t kMultiplier2 = 0xC2B2AE3D27D4EB4Full;
+			static constexpr std::uint64_t kMultiplier3 = 0x165667B19E3779F9ull;
+
+			std::uint64_t a_ = 0x243F6A8885A308D3ull;
+			std::uint64_t b_ = 0x13198A2E03707344ull;
+			std::uint64_t fields_ = 0;
+
+			void Mix(const std::uint64_t word) {
+				a_ = Rotate((a_ ^ word) * kMultiplier1, 31) * kMultiplier2;
+				b_ = Rotate((b_ + word) * kMultiplier3, 29) ^ a_;
+			}
+
+			static std::uint64_t Rotate(const std::uint64_t value, const int bits) {
+				return (value << bits) | (value >> (64 - bits));
+			}
+
+			/**
+			 * \brief The finalizer of SplitMix64, which makes every input bit affect every output bit.
+			 */
+			static std::uint64_t Avalanche(std::uint64_t value) {
+				value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+				value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+				return value ^ (value >> 31);
+			}
+		};
+
+		/**
+		 * \brief Combines the fingerprints of the objects of a result into the fingerprint of the result.
+		 * WMI does not guarantee the order objects are enumerated in, so the combination is independent
+		 * of the order, while still telling apart results that differ by duplicated objects.
+		 */
+		class FingerprintAccumulator {
+		public:
+			void Add(const Fingerprint& fingerprint) {
+				high_ += fingerprint.high;
+				low_ += fingerprint.low;
+				++count_;
+			}
+
+			void Reset() {
+				*this = {};
+			}
+
+			[[nodiscard]] Fingerprint Finish() const {
+				Hasher hasher;
+				hasher.Update(count_);
+				hasher.Update(high_);
+				hasher.Update(low_);
+				return hasher.Finish();
+			}
+
+		private:
+			std::uint64_t high_ = 0;
+			std::uint64_t low_ = 0;
+			std::uint64_t count_ = 0;
+		};
+	} // namespace detail
+} // namespace wmipp
+
+#endif // SD_WMIPP_FINGERPRINT_HXX
@@ -0,0 +1,267 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_LINT_HXX
+#define SD_WMIPP_LINT_HXX
+
+#include <algorithm>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "wql.hxx"
+
+namespace wmipp::wql
+{
+	enum class Severity {
+		/**
+		 * \brief The query works, but could be cheaper.
+		 */
+		Info,
+
+		/**
+		 * \brief The query is likely to be slow on some systems.
+		 */
+		Warning,
+
+		/**
+		 * \brief The query is known to be very expensive, or to have side effects.
+		 */
+		Error,
+	};
+
+	/**
+	 * \brief A potential performance problem found in a query.
+	 */
+	struct LintFinding {
+		Severity severity = Severity::Info;
+
+		/**
+		 * \brief A stable identifier of the rule that produced the finding, such as "select-star".
+		 */
+		std::wstring rule;
+
+		std::wstring message;
+
+		/**
+		 * \brief How to avoid the problem.
+		 */
+		std::wstring suggestion;
+
+		/**
+		 * \brief An equivalent or narrower query without the problem, if one can be derived mechanically.
+		 */
+		std::optional<std::wstring> rewrite;
+	};
+
+	/**
+	 * \brief What the linter knows about a class.
+	 */
+	struct ClassMetadata {
+		/**
+		 * \brief The key properties of the class.
+		 */
+		std::vector<std::wstring> keys;
+
+		/**
+		 * \brief The properties the provider can use to avoid enumerating every instance, when
+		 * compared for equality. Keys are always assumed to be indexed.
+		 */
+		std::vector<std::wstring> indexed;
+
+		/**
+		 * \brief True if the class commonly has so many instances that enumerating them all is expensive.
+		 */
+		bool large = false;
+	};
+
+	/**
+	 * \brief Returns the built-in metadata of classes that are known to be expensive to enumerate.
+	 * \param class_name The name of the class, case-insensitively.
+	 * \return The metadata, or std::nullopt if the class is not known to the linter.
+	 */
+	[[nodiscard]] inline std::optional<ClassMetadata> KnownClassMetadata(const std::wstring_view class_name) {
+		const auto is_any = [&](std::initializer_list<std::wstring_view> names) {
+			return std::any_of(names.begin(), names.end(), [&](const std::wstring_view name) {
+				return EqualsIgnoreCase(class_name, name);
+			});
+		};
+
+		// The file system provider only avoids walking every drive when the drive, the path or the
+		// full name of the file are known.
+		if (is_any({L"CIM_DataFile", L"CIM_LogicalFile", L"CIM_Directory", L"Win32_Directory",
+			L"Win32_ShortcutFile", L"Win32_CodecFile"})) {
+			return ClassMetadata{{L"Name"}, {L"Name", L"Drive", L"Path"}, true};
+		}
+
+		if (is_any({L"Win32_NTLogEvent"})) {
+			return ClassMetadata{{L"Logfile", L"RecordNumber"}, {L"Logfile", L"RecordNumber"}, true};
+		}
+
+		if (is_any({L"Win32_UserAccount", L"Win32_Group", L"Win32_Account"})) {
+			return ClassMetadata{{L"Domain", L"Name"}, {L"Domain", L"Name", L"LocalAccount"}, false};
+		}
+
+		if (is_any({L"Win32_Product"})) {
+			return ClassMetadata{{L"IdentifyingNumber", L"Name", L"Version"}, {}, true};
+		}
+
+		return std::nullopt;
+	}
+
+	/**
+	 * \brief Analyzes a query for patterns that are known to be expensive.
+	 * Only data queries of the form SELECT properties FROM class [WHERE condition] are analyzed;
+	 * other queries produce no findings.
+	 * \param query The WQL query to analyze.
+	 * \param metadata The metadata of the queried class. If omitted, the built-in metadata is used.
+	 * \return The findings, ordered from the most to the least severe.
+	 */
+	[[nodiscard]] inline std::vector<LintFinding> Lint(
+		const std::wstring_view query,
+		std::optional<ClassMetadata> metadata = std::nullopt) {
+		std::vector<LintFinding> findings;
+		const auto parsed = ParseSelect(query);
+		if (!parsed) return findings;
+
+		if (!metadata) metadata = KnownClassMetadata(parsed->class_name);
+		if (!metadata) metadata = ClassMetadata{};
+
+		const auto& class_name = parsed->class_name;
+		const auto add = [&](
+			const Severity severity,
+			const std::wstring_view rule,
+			std::wstring message,
+			std::wstring suggestion,
+			std::optional<std::wstring> rewrite = std::nullopt) {
+			findings.push_back({severity, std::wstring(rule), std::move(message), std::move(suggestion), std::move(rewrite)});
+		};
+
+		const auto join = [](const std::vector<std::wstring>& names) {
+			std::wstring result;
+			for (std::size_t i = 0; i < names.size(); ++i) {
+				if (i != 0) result += L", ";
+				result += names[i];
+			}
+
+			return result;
+		};
+
+		// Collect the properties compared for equality and the LIKE patterns of the WHERE clause.
+		// A disjunction may defeat any of them, so conditions under an OR are not trusted.
+		std::vector<std::wstring_view> equalities;
+		std::vector<std::pair<std::wstring_view, std::wstring_view>> likes;
+		auto has_or = false;
+		const auto where = Tokenize(parsed->where);
+		if (where) {
+			const auto& tokens = *where;
+			const auto is_literal = [](const Token& token) {
+				return token.kind == TokenKind::String || token.kind == TokenKind::Number ||
+					IsKeyword(token, L"TRUE") || IsKeyword(token, L"FALSE");
+			};
+
+			for (std::size_t i = 0; i < tokens.size(); ++i) {
+				if (IsKeyword(tokens[i], L"OR")) has_or = true;
+				if (i + 2 >= tokens.size()) continue;
+
+				const auto& left = tokens[i];
+				const auto& op = tokens[i + 1];
+				const auto& right = tokens[i + 2];
+				if (op.kind == TokenKind::Operator && op.text == L"=") {
+					if (left.kind == TokenKind::Identifier && is_literal(right)) equalities.push_back(left.text);
+					else if (right.kind == TokenKind::Identifier && is_literal(left)) equalities.push_back(right.text);
+				}
+				else if (left.kind == TokenKind::Identifier && IsKeyword(op, L"LIKE") && right.kind == TokenKind::String) {
+					likes.emplace_back(left.text, right.text.substr(1, right.text.size() - 2));
+				}
+			}
+		}
+
+		const auto constrains = [&](const std::vector<std::wstring>& properties) {
+			return !has_or && std::any_of(equalities.begin(), equalities.end(), [&](const std::wstring_view property) {
+				return std::any_of(properties.begin(), properties.end(), [&](const std::wstring& p) {
+					return EqualsIgnoreCase(p, property);
+				});
+			});
+		};
+
+		auto indexed = metadata->keys;
+		for (const auto& property : metadata->indexed) {
+			const auto duplicate = std::any_of(indexed.begin(), indexed.end(), [&](const std::wstring& p) {
+				return EqualsIgnoreCase(p, property);
+			});
+			if (!duplicate) indexed.push_back(property);
+		}
+
+		if (EqualsIgnoreCase(class_name, L"Win32_Product")) {
+			add(Severity::Error, L"win32-product",
+				L"Querying Win32_Product makes Windows Installer verify every installed product, which is slow and "
+				L"may trigger repairs.",
+				L"Read the Uninstall keys under HKLM\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall, "
+				L"or query Win32_InstalledWin32Program instead.");
+		}
+		else if (metadata->large && parsed->where.empty()) {
+			add(Severity::Error, L"unfiltered-large-class",
+				L"The query enumerates every instance of " + class_name + L", which commonly has a very large "
+				L"number of instances.",
+				indexed.empty()
+					? L"Add a WHERE clause."
+					: L"Add a WHERE clause comparing any of " + join(indexed) + L" for equality.");
+		}
+		else if (metadata->large && !constrains(indexed)) {
+			add(Severity::Warning, L"non-key-filter",
+				L"The WHERE clause does not compare an indexed property of " + class_name + L" for equality "
+				L"(outside of an OR), so the provider enumerates every instance and filters them afterwards.",
+				indexed.empty()
+					? L"Narrow the query with a condition the provider can use."
+					: L"Compare any of " + join(indexed) + L" for equality.");
+		}
+
+		for (const auto& [property, pattern] : likes) {
+			if (!metadata->large || constrains(indexed) || pattern.empty()) continue;
+			if (pattern.front() != L'%' && pattern.front() != L'_' && pattern.front() != L'[') continue;
+
+			add(Severity::Error, L"leading-wildcard",
+				L"The LIKE pattern on " + std::wstring(property) + L" starts with a wildcard, so every instance of " +
+				class_name + L" is enumerated to evaluate it.",
+				L"Constrain the query with equality conditions on indexed properties, or anchor the pattern.");
+		}
+
+		// Without LocalAccount = TRUE or a specific account, the account classes enumerate every
+		// account of the domain the computer is joined to.
+		const auto is_account_class = EqualsIgnoreCase(class_name, L"Win32_UserAccount") ||
+			EqualsIgnoreCase(class_name, L"Win32_Group") || EqualsIgnoreCase(class_name, L"Win32_Account");
+		if (is_account_class && !constrains(indexed)) {
+			auto rewritten = *parsed;
+			rewritten.where = parsed->where.empty()
+				? L"LocalAccount = TRUE"
+				: L"(" + parsed->where + L") AND LocalAccount = TRUE";
+
+			add(Severity::Warning, L"domain-accounts",
+				L"On computers joined to a domain, the query enumerates every account of the domain.",
+				L"Add LocalAccount = TRUE, or compare Domain and Name for equality.",
+				rewritten.ToString());
+		}
+
+		if (parsed->SelectsAll()) {
+			add(metadata->large ? Severity::Warning : Severity::Info, L"select-star",
+				L"The query retrieves every property of " + class_name + L", including ones that may be "
+				L"expensive for the provider to compute.",
+				L"Select only the properties you read.");
+		}
+
+		std::stable_sort(findings.begin(), findings.end(), [](const LintFinding& a, const LintFinding& b) {
+			return a.severity > b.severity;
+		});
+		return findings;
+	}
+} // namespace wmipp::wql
+
+#endif // SD_WMIPP_LINT_HXX
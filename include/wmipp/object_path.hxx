@@ -0,0 +1,466 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_OBJECT_PATH_HXX
+#define SD_WMIPP_OBJECT_PATH_HXX
+
+#include <algorithm>
+#include <cstdint>
+#include <cwctype>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "wql.hxx"
+
+namespace wmipp
+{
+	/**
+	 * \brief A parsed WMI object path, such as \\SERVER\root\cimv2:Win32_Service.Name="Spooler".
+	 * Parsing does not allocate: the path is a set of views into the parsed text, which must outlive it.
+	 * Keys are parsed again on each iteration, which is cheap for the one or two keys paths usually have.
+	 */
+	class ObjectPath {
+	public:
+		/**
+		 * \brief A key of an object path, such as Name="Spooler".
+		 */
+		struct Key {
+			/**
+			 * \brief The name of the key, or an empty string for the single unnamed key of Class="value".
+			 */
+			std::wstring_view name;
+
+			/**
+			 * \brief The value as written in the path: escaped and without quotes for strings.
+			 */
+			std::wstring_view raw;
+
+			/**
+			 * \brief True if the value is a quoted string.
+			 */
+			bool quoted = false;
+
+			/**
+			 * \brief Returns the value with its escapes removed, or the raw value if it has none.
+			 * \param buffer Receives the unescaped value if needed, so that the returned view stays valid.
+			 */
+			[[nodiscard]] std::wstring_view Value(std::wstring& buffer) const {
+				if (raw.find(L'\\') == std::wstring_view::npos) return raw;
+
+				buffer.clear();
+				for (std::size_t i = 0; i < raw.size(); ++i) {
+					if (raw[i] == L'\\' && i + 1 < raw.size()) ++i;
+					buffer += raw[i];
+				}
+
+				return buffer;
+			}
+
+			[[nodiscard]] std::wstring Value() const {
+				std::wstring buffer;
+				return std::wstring(Value(buffer));
+			}
+
+			/**
+			 * \brief Compares the unescaped value with the given text, without allocating.
+			 * \param ignore_case Whether to compare case-insensitively, as WMI does for most string keys.
+			 */
+			[[nodiscard]] bool ValueEquals(const std::wstring_view text, const bool ignore_case = false) const {
+				std::size_t t = 0;
+				for (std::size_t i = 0; i < raw.size(); ++i, ++t) {
+					if (raw[i] == L'\\' && i + 1 < raw.size()) ++i;
+					if (t >= text.size()) return false;
+					if (ignore_case ? std::towlower(raw[i]) != std::towlower(text[t]) : raw[i] != text[t]) return false;
+				}
+
+				return t == text.size();
+			}
+
+			/**
+			 * \brief Returns the value as an integer, if it is an unquoted decimal number.
+			 */
+			[[nodiscard]] std::optional<std::int64_t> AsInt64() const {
+				if (quoted || raw.empty()) return std::nullopt;
+
+				const auto negative = raw.front() == L'-';
+				if (negative && raw.size() == 1) return std::nullopt;
+
+				std::uint64_t value = 0;
+				for (auto i = negative ? 1 : 0; i < static_cast<int>(raw.size()); ++i) {
+					if (raw[i] < L'0' || raw[i] > L'9') return std::nullopt;
+					const auto digit = static_cast<std::uint64_t>(raw[i] - L'0');
+					if (value > (UINT64_C(0x8000000000000000) - digit) / 10) return std::nullopt;
+					value = value * 10 + digit;
+				}
+
+				if (!negative && value > static_cast<std::uint64_t>(INT64_MAX)) return std::nullopt;
+				return negative ? static_cast<std::int64_t>(0 - value) : static_cast<std::int64_t>(value);
+			}
+		};
+
+		class KeyIterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Key;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Key*;
+			using reference = const Key&;
+
+			KeyIterator() = default;
+			explicit KeyIterator(const std::wstring_view keys) : rest_(keys), valid_(true) { ++*this; }
+
+			reference operator*() const { return key_; }
+			pointer operator->() const { return &key_; }
+
+			KeyIterator& operator++() {
+				if (rest_.empty() || !ParseKey(rest_, key_)) {
+					valid_ = false;
+					rest_ = {};
+				}
+
+				return *this;
+			}
+
+			KeyIterator operator++(int) {
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			bool operator==(const KeyIterator& other) const {
+				return valid_ == other.valid_ && (!valid_ || rest_.data() == other.rest_.data());
+			}
+
+			bool operator!=(const KeyIterator& other) const { return !(*this == other); }
+
+		private:
+			std::wstring_view rest_;
+			Key key_;
+			bool valid_ = false;
+		};
+
+		ObjectPath() = default;
+
+		/**
+		 * \brief Parses an absolute (\\server\namespace:Class.keys), namespace-relative (namespace:Class.keys)
+		 * or relative (Class.keys) object path. Forward slashes are accepted in place of the leading backslashes.
+		 * \param text The path to parse. It must outlive the returned path.
+		 * \return The parsed path, or std::nullopt if it is malformed.
+		 */
+		[[nodiscard]] static std::optional<ObjectPath> Parse(std::wstring_view text) {
+			ObjectPath path;
+			path.text_ = text;
+
+			const auto is_separator = [](const wchar_t c) { return c == L'\\' || c == L'/'; };
+			if (text.size() >= 2 && is_separator(text[0]) && is_separator(text[1])) {
+				text.remove_prefix(2);
+				const auto server_end = std::find_if(text.begin(), text.end(), is_separator) - text.begin();
+				if (server_end == 0 || static_cast<std::size_t>(server_end) == text.size()) return std::nullopt;
+
+				path.server_ = text.substr(0, server_end);
+				text.remove_prefix(server_end + 1);
+
+				const auto colon = text.find(L':');
+				if (colon == std::wstring_view::npos) {
+					// A path to a namespace, with no class.
+					path.namespace_ = text;
+					return path.namespace_.empty() ? std::nullopt : std::optional<ObjectPath>(path);
+				}
+
+				path.namespace_ = text.substr(0, colon);
+				text.remove_prefix(colon + 1);
+			}
+			else {
+				// A colon before the first key belongs to a namespace prefix, not to a key value.
+				const auto class_end = text.find_first_of(L".=\"");
+				const auto colon = text.substr(0, class_end).find(L':');
+				if (colon != std::wstring_view::npos) {
+					path.namespace_ = text.substr(0, colon);
+					text.remove_prefix(colon + 1);
+				}
+			}
+
+			const auto class_end = std::find_if(text.begin(), text.end(), [](const wchar_t c) {
+				return !(std::iswalnum(c) || c == L'_');
+			}) - text.begin();
+			if (class_end == 0) return std::nullopt;
+
+			path.class_name_ = text.substr(0, class_end);
+			text.remove_prefix(class_end);
+			if (text.empty()) return path;
+
+			if (text == L"=@") {
+				path.singleton_ = true;
+				return path;
+			}
+
+			// Class="value" designates an instance by its single key, without naming it.
+			const auto unnamed = text.front() == L'=';
+			if (text.front() == L'.') text.remove_prefix(1);
+			else if (!unnamed) return std::nullopt;
+
+			// Validate every key up front, so that iterating them later cannot fail.
+			if (text.empty()) return std::nullopt;
+			path.keys_ = text;
+			Key key;
+			while (!text.empty()) {
+				if (!ParseKey(text, key)) return std::nullopt;
+				if (key.name.empty() != unnamed || (unnamed && !text.empty())) return std::nullopt;
+			}
+
+			return path;
+		}
+
+		/**
+		 * \brief Returns the text the path was parsed from.
+		 */
+		[[nodiscard]] std::wstring_view GetText() const { return text_; }
+
+		/**
+		 * \brief Returns the server, or an empty string for relative paths.
+		 */
+		[[nodiscard]] std::wstring_view GetServer() const { return server_; }
+
+		/**
+		 * \brief Returns the namespace, or an empty string if the path does not specify one.
+		 */
+		[[nodiscard]] std::wstring_view GetNamespace() const { return namespace_; }
+
+		[[nodiscard]] std::wstring_view GetClass() const { return class_name_; }
+
+		/**
+		 * \brief Returns true if the path designates an instance of a singleton class (Class=@).
+		 */
+		[[nodiscard]] bool IsSingleton() const { return singleton_; }
+
+		/**
+		 * \brief Returns true if the path designates a class rather than an instance.
+		 */
+		[[nodiscard]] bool IsClass() const { return !singleton_ && keys_.empty(); }
+
+		[[nodiscard]] KeyIterator begin() const {
+			return keys_.empty() ? KeyIterator() : KeyIterator(keys_);
+		}
+
+		[[nodiscard]] KeyIterator end() const {
+			return {};
+		}
+
+		[[nodiscard]] std::size_t KeyCount() const {
+			return static_cast<std::size_t>(std::distance(begin(), end()));
+		}
+
+		/**
+		 * \brief Finds a key by name, case-insensitively.
+		 */
+		[[nodiscard]] std::optional<Key> FindKey(const std::wstring_view name) const {
+			for (const auto& key : *this) {
+				if (wql::EqualsIgnoreCase(key.name, name)) return key;
+			}
+
+			return std::nullopt;
+		}
+
+		/**
+		 * \brief Returns true if both paths designate the same class or instance, regardless of the order
+		 * of their keys and of their server and namespace. Class and key names are compared
+		 * case-insensitively, and key values exactly.
+		 */
+		[[nodiscard]] bool SameObject(const ObjectPath& other) const {
+			if (!wql::EqualsIgnoreCase(class_name_, other.class_name_) || singleton_ != other.singleton_) return false;
+			if (KeyCount() != other.KeyCount()) return false;
+
+			std::wstring buffer;
+			for (const auto& key : *this) {
+				const auto match = other.FindKey(key.name);
+				if (!match || match->quoted != key.quoted || !match->ValueEquals(key.Value(buffer))) return false;
+			}
+
+			return true;
+		}
+
+		/**
+		 * \brief Formats the path in a canonical form, suitable as the key of a map of objects: the relative
+		 * path with lower-case class and key names, keys sorted by name, and strings quoted and escaped.
+		 */
+		[[nodiscard]] std::wstring ToCanonical() const;
+
+	private:
+		std::wstring_view text_;
+		std::wstring_view server_;
+		std::wstring_view namespace_;
+		std::wstring_view class_name_;
+		std::wstring_view keys_;
+		bool singleton_ = false;
+
+		/**
+		 * \brief Parses the key at the start of the text, and advances the text past it and its separator.
+		 * \return false if the key is malformed.
+		 */
+		static bool ParseKey(std::wstring_view& text, Key& key) {
+			const auto equals = text.find(L'=');
+			if (equals == std::wstring_view::npos) return false;
+
+			key.name = text.substr(0, equals);
+			if (!std::all_of(key.name.begin(), key.name.end(), [](const wchar_t c) { return std::iswalnum(c) || c == L'_'; })) {
+				return false;
+			}
+
+			text.remove_prefix(equals + 1);
+			key.quoted = !text.empty() && text.front() == L'"';
+			if (key.quoted) {
+				std::size_t i = 1;
+				for (; i < text.size() && text[i] != L'"'; ++i) {
+					if (text[i] == L'\\') ++i;
+				}
+
+				if (i >= text.size()) return false;
+				key.raw = text.substr(1, i - 1);
+				text.remove_prefix(i + 1);
+			}
+			else {
+				const auto comma = text.find(L',');
+				key.raw = text.substr(0, comma);
+				if (key.raw.empty()) return false;
+				text.remove_prefix(comma == std::wstring_view::npos ? text.size() : comma);
+			}
+
+			if (text.empty()) return true;
+			if (text.front() != L',' || text.size() == 1) return false;
+			text.remove_prefix(1);
+			return true;
+		}
+	};
+
+	/**
+	 * \brief Builds object paths, quoting and escaping their key values.
+	 */
+	class ObjectPathBuilder {
+	public:
+		explicit ObjectPathBuilder(const std::wstring_view class_name) : class_name_(class_name) {}
+
+		ObjectPathBuilder& SetServer(const std::wstring_view server) {
+			server_ = server;
+			return *this;
+		}
+
+		ObjectPathBuilder& SetNamespace(const std::wstring_view name) {
+			namespace_ = name;
+			return *this;
+		}
+
+		/**
+		 * \brief Makes the path designate the instance of a singleton class (Class=@).
+		 */
+		ObjectPathBuilder& SetSingleton() {
+			singleton_ = true;
+			return *this;
+		}
+
+		/**
+		 * \brief Adds a string key, which is quoted and escaped.
+		 */
+		ObjectPathBuilder& AddKey(const std::wstring_view name, const std::wstring_view value) {
+			std::wstring quoted = L"\"";
+			for (const auto c : value) {
+				if (c == L'"' || c == L'\\') quoted += L'\\';
+				quoted += c;
+			}
+
+			quoted += L'"';
+			keys_.emplace_back(name, std::move(quoted));
+			return *this;
+		}
+
+		ObjectPathBuilder& AddKey(const std::wstring_view name, const wchar_t* value) {
+			return AddKey(name, std::wstring_view(value));
+		}
+
+		/**
+		 * \brief Adds a numeric or boolean key, which is written without quotes.
+		 */
+		template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+		ObjectPathBuilder& AddKey(const std::wstring_view name, const T value) {
+			if constexpr (std::is_same_v<T, bool>) keys_.emplace_back(name, value ? L"TRUE" : L"FALSE");
+			else keys_.emplace_back(name, std::to_wstring(value));
+			return *this;
+		}
+
+		/**
+		 * \brief Adds a key whose value is already formatted as it appears in a path.
+		 */
+		ObjectPathBuilder& AddRawKey(const std::wstring_view name, const std::wstring_view raw) {
+			keys_.emplace_back(name, raw);
+			return *this;
+		}
+
+		[[nodiscard]] std::wstring Build() const {
+			std::wstring result;
+			if (!server_.empty()) {
+				result += L"\\\\";
+				result += server_;
+				result += L'\\';
+			}
+
+			if (!namespace_.empty() || !server_.empty()) {
+				result += namespace_;
+				result += L':';
+			}
+
+			result += class_name_;
+			if (singleton_) return result + L"=@";
+
+			for (std::size_t i = 0; i < keys_.size(); ++i) {
+				result += i == 0 ? L'.' : L',';
+				result += keys_[i].first;
+				result += L'=';
+				result += keys_[i].second;
+			}
+
+			return result;
+		}
+
+	private:
+		std::wstring server_;
+		std::wstring namespace_;
+		std::wstring class_name_;
+		std::vector<std::pair<std::wstring, std::wstring>> keys_;
+		bool singleton_ = false;
+	};
+
+	inline std::wstring ObjectPath::ToCanonical() const {
+		const auto lower = [](const std::wstring_view text) {
+			std::wstring result(text);
+			std::transform(result.begin(), result.end(), result.begin(), [](const wchar_t c) {
+				return static_cast<wchar_t>(std::towlower(c));
+			});
+			return result;
+		};
+
+		std::vector<Key> keys(begin(), end());
+		std::sort(keys.begin(), keys.end(), [&](const Key& a, const Key& b) { return lower(a.name) < lower(b.name); });
+
+		ObjectPathBuilder builder(lower(class_name_));
+		if (singleton_) builder.SetSingleton();
+
+		std::wstring buffer;
+		for (const auto& key : keys) {
+			if (key.quoted) builder.AddKey(lower(key.name), key.Value(buffer));
+			else builder.AddRawKey(lower(key.name), key.raw);
+		}
+
+		return builder.Build();
+	}
+} // namespace wmipp
+
+#endif // SD_WMIPP_OBJECT_PATH_HXX
@@ -0,0 +1,428 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_PROCESS_TREE_HXX
+#define SD_WMIPP_PROCESS_TREE_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "columnar.hxx"
+#include "value.hxx"
+
+namespace wmipp
+{
+	namespace detail
+	{
+		/**
+		 * \brief Parses a CIM datetime, such as 20240131235959.123456+060, into microseconds since the Unix epoch in UTC.
+		 * \return The time, or std::nullopt if the text is not a complete datetime.
+		 */
+		inline std::optional<std::int64_t> ParseCimDateTime(const std::wstring_view text) {
+			if (text.size() != 25 || text[14] != L'.' || (text[21] != L'+' && text[21] != L'-')) return std::nullopt;
+
+			const auto number = [&](const std::size_t begin, const std::size_t end) -> std::optional<std::int64_t> {
+				std::int64_t value = 0;
+				for (auto i = begin; i < end; ++i) {
+					if (text[i] < L'0' || text[i] > L'9') return std::nullopt;
+					value = value * 10 + (text[i] - L'0');
+				}
+
+				return value;
+			};
+
+			const auto year = number(0, 4), month = number(4, 6), day = number(6, 8);
+			const auto hour = number(8, 10), minute = number(10, 12), second = number(12, 14);
+			const auto micros = number(15, 21), offset = number(22, 25);
+			if (!year || !month || !day || !hour || !minute || !second || !micros || !offset) return std::nullopt;
+			if (*month < 1 || *month > 12 || *day < 1 || *day > 31) return std::nullopt;
+
+			// The number of days since 1970-01-01 of a proleptic Gregorian date.
+			const auto y = *year - (*month <= 2 ? 1 : 0);
+			const auto era = y / 400;
+			const auto year_of_era = y - era * 400;
+			const auto day_of_year = (153 * (*month + (*month > 2 ? -3 : 9)) + 2) / 5 + *day - 1;
+			const auto day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+			const auto days = era * 146097 + day_of_era - 719468;
+
+			auto minutes = days * 1440 + *hour * 60 + *minute;
+			minutes += text[21] == L'+' ? -*offset : *offset;
+			return (minutes * 60 + *second) * 1000000 + *micros;
+		}
+	} // namespace detail
+
+	/**
+	 * \brief The parent and child links of the running processes, maintained incrementally.
+	 * Processes are stored in a flat vector and linked by index, so that snapshots of Win32_Process only
+	 * touch the processes that started or exited since the previous one, and subtree and ancestry queries
+	 * walk the links without allocating.
+	 *
+	 * Process ids are reused by Windows, and ParentProcessId is not cleared when the parent exits. A process
+	 * is therefore only linked to a parent that was created before it, which is checked with CreationDate.
+	 */
+	class ProcessTree {
+	public:
+		struct Process {
+			std::uint32_t pid = 0;
+			std::uint32_t parent_pid = 0;
+
+			/**
+			 * \brief The creation time in microseconds since the Unix epoch, or zero if it is unknown.
+			 */
+			std::int64_t creation = 0;
+		};
+
+		/**
+		 * \brief Returns the properties to select from Win32_Process, and to pass to QueryResult::ToColumnar.
+		 */
+		[[nodiscard]] static std::vector<std::wstring> GetProperties() {
+			return {L"ProcessId", L"ParentProcessId", L"CreationDate"};
+		}
+
+		[[nodiscard]] std::size_t size() const {
+			return index_.size();
+		}
+
+		[[nodiscard]] bool empty() const {
+			return index_.empty();
+		}
+
+		void Clear() {
+			nodes_.clear();
+			free_.clear();
+			index_.clear();
+			orphans_.clear();
+		}
+
+		/**
+		 * \brief Replaces the tree with a snapshot of Win32_Process. Processes that are still running keep
+		 * their links, processes missing from the snapshot are removed, and new ones are added.
+		 * \param table The snapshot, holding the columns returned by GetProperties.
+		 * \throws std::invalid_argument if a column is missing from the table.
+		 */
+		void Update(const ColumnarTable& table) {
+			const auto& pids = Require(table, L"ProcessId");
+			const auto& parents = Require(table, L"ParentProcessId");
+			const auto& creations = Require(table, L"CreationDate");
+
+			++generation_;
+			for (std::size_t row = 0; row < table.RowCount(); ++row) {
+				const auto pid = pids.GetAt(row).AsUInt64();
+				if (!pid || *pid > (std::numeric_limits<std::uint32_t>::max)()) continue;
+
+				Process process;
+				process.pid = static_cast<std::uint32_t>(*pid);
+				process.parent_pid = static_cast<std::uint32_t>(parents.GetAt(row).AsUInt64().value_or(process.pid));
+				if (!creations.IsNull(row)) {
+					const auto creation = creations.GetAt(row);
+					process.creation = detail::ParseCimDateTime(creation.AsString().value_or(L"")).value_or(0);
+				}
+
+				const auto it = index_.find(process.pid);
+				if (it != index_.end() && nodes_[it->second].process.creation == process.creation) {
+					nodes_[it->second].generation = generation_;
+					continue;
+				}
+
+				if (it != index_.end()) RemoveNode(it->second);
+				nodes_[AddNode(process)].generation = generation_;
+			}
+
+			for (std::uint32_t slot = 0; slot < nodes_.size(); ++slot) {
+				if (nodes_[slot].used && nodes_[slot].generation != generation_) RemoveNode(slot);
+			}
+		}
+
+		/**
+		 * \brief Adds a process, typically from the TargetInstance of an __InstanceCreationEvent.
+		 * A process already known under the same id is replaced, unless it has the same creation time.
+		 * \param creation_date The CreationDate of the process, as a CIM datetime.
+		 * \return false if the process was already known.
+		 */
+		bool Add(const std::uint32_t pid, const std::uint32_t parent_pid, const std::wstring_view creation_date) {
+			const Process process{pid, parent_pid, detail::ParseCimDateTime(creation_date).value_or(0)};
+			const auto it = index_.find(pid);
+			if (it != index_.end()) {
+				if (nodes_[it->second].process.creation == process.creation) return false;
+				RemoveNode(it->second);
+			}
+
+			AddNode(process);
+			return true;
+		}
+
+		/**
+		 * \brief Removes a process, typically from the TargetInstance of an __InstanceDeletionEvent.
+		 * Its children are kept, without a parent.
+		 * \param creation_date The CreationDate of the process, which if given must match the known process,
+		 * so that a late deletion event does not remove a newer process that reused the id.
+		 * \return false if the process was not known.
+		 */
+		bool Remove(const std::uint32_t pid, const std::wstring_view creation_date = {}) {
+			const auto it = index_.find(pid);
+			if (it == index_.end()) return false;
+
+			if (!creation_date.empty()) {
+				const auto creation = detail::ParseCimDateTime(creation_date).value_or(0);
+				if (creation != 0 && nodes_[it->second].process.creation != creation) return false;
+			}
+
+			RemoveNode(it->second);
+			return true;
+		}
+
+		[[nodiscard]] const Process* Find(const std::uint32_t pid) const {
+			const auto slot = Slot(pid);
+			return slot == kNone ? nullptr : &nodes_[slot].process;
+		}
+
+		/**
+		 * \brief Returns the id of the parent of a process, or std::nullopt if the parent is not running.
+		 */
+		[[nodiscard]] std::optional<std::uint32_t> GetParent(const std::uint32_t pid) const {
+			const auto slot = Slot(pid);
+			if (slot == kNone || nodes_[slot].parent == kNone) return std::nullopt;
+			return nodes_[nodes_[slot].parent].process.pid;
+		}
+
+		[[nodiscard]] std::vector<std::uint32_t> GetChildren(const std::uint32_t pid) const {
+			std::vector<std::uint32_t> children;
+			const auto slot = Slot(pid);
+			if (slot == kNone) return children;
+
+			for (auto child = nodes_[slot].first_child; child != kNone; child = nodes_[child].next_sibling) {
+				children.push_back(nodes_[child].process.pid);
+			}
+
+			return children;
+		}
+
+		/**
+		 * \brief Returns the ids of the running ancestors of a process, starting with its parent.
+		 */
+		[[nodiscard]] std::vector<std::uint32_t> GetAncestors(const std::uint32_t pid) const {
+			std::vector<std::uint32_t> ancestors;
+			const auto slot = Slot(pid);
+			if (slot == kNone) return ancestors;
+
+			for (auto parent = nodes_[slot].parent; parent != kNone; parent = nodes_[parent].parent) {
+				ancestors.push_back(nodes_[parent].process.pid);
+			}
+
+			return ancestors;
+		}
+
+		/**
+		 * \brief Returns true if a process descends from another, directly or not.
+		 */
+		[[nodiscard]] bool IsDescendant(const std::uint32_t pid, const std::uint32_t ancestor) const {
+			const auto slot = Slot(pid);
+			const auto target = Slot(ancestor);
+			return slot != kNone && target != kNone && slot != target && IsAncestorSlot(target, slot);
+		}
+
+		/**
+		 * \brief Returns the ids of the processes without a running parent.
+		 */
+		[[nodiscard]] std::vector<std::uint32_t> GetRoots() const {
+			std::vector<std::uint32_t> roots;
+			for (const auto& node : nodes_) {
+				if (node.used && node.parent == kNone) roots.push_back(node.process.pid);
+			}
+
+			return roots;
+		}
+
+		/**
+		 * \brief Calls a function for a process and each of its descendants, parents before children.
+		 * The tree must not be modified by the function.
+		 * \param callback A function taking a const Process&.
+		 */
+		template <typename F>
+		void VisitSubtree(const std::uint32_t pid, F&& callback) const {
+			const auto root = Slot(pid);
+			if (root == kNone) return;
+
+			auto slot = root;
+			for (;;) {
+				callback(nodes_[slot].process);
+				if (nodes_[slot].first_child != kNone) {
+					slot = nodes_[slot].first_child;
+					continue;
+				}
+
+				while (slot != root && nodes_[slot].next_sibling == kNone) slot = nodes_[slot].parent;
+				if (slot == root) return;
+				slot = nodes_[slot].next_sibling;
+			}
+		}
+
+		/**
+		 * \brief Returns the ids of a process and of each of its descendants, parents before children.
+		 */
+		[[nodiscard]] std::vector<std::uint32_t> GetSubtree(const std::uint32_t pid) const {
+			std::vector<std::uint32_t> subtree;
+			VisitSubtree(pid, [&](const Process& process) { subtree.push_back(process.pid); });
+			return subtree;
+		}
+
+	private:
+		static constexpr std::uint32_t kNone = (std::numeric_limits<std::uint32_t>::max)();
+
+		struct Node {
+			Process process;
+			std::uint32_t parent = kNone;
+			std::uint32_t first_child = kNone;
+			std::uint32_t next_sibling = kNone;
+			std::uint32_t previous_sibling = kNone;
+			std::uint32_t generation = 0;
+			bool used = false;
+
+			/**
+			 * \brief Whether the process is waiting in orphans_ for a parent that has not been added yet.
+			 */
+			bool orphan = false;
+		};
+
+		std::vector<Node> nodes_;
+		std::vector<std::uint32_t> free_;
+		std::unordered_map<std::uint32_t, std::uint32_t> index_;
+
+		/**
+		 * \brief The processes whose parent was unknown when they were added, by parent id. This happens when
+		 * a snapshot lists a child before its parent, or when creation events arrive out of order.
+		 */
+		std::unordered_multimap<std::uint32_t, std::uint32_t> orphans_;
+		std::uint32_t generation_ = 0;
+
+		static const Column& Require(const ColumnarTable& table, const std::wstring_view name) {
+			const auto* column = table.FindColumn(name);
+			if (!column) throw std::invalid_argument("The table has no column for a Win32_Process property");
+			return *column;
+		}
+
+		[[nodiscard]] std::uint32_t Slot(const std::uint32_t pid) const {
+			const auto it = index_.find(pid);
+			return it == index_.end() ? kNone : it->second;
+		}
+
+		/**
+		 * \brief Returns true if a node is an ancestor of another, or the same node.
+		 */
+		[[nodiscard]] bool IsAncestorSlot(const std::uint32_t ancestor, std::uint32_t slot) const {
+			for (; slot != kNone; slot = nodes_[slot].parent) {
+				if (slot == ancestor) return true;
+			}
+
+			return false;
+		}
+
+		/**
+		 * \brief Returns true if a process can be the parent of another: it must have been created first
+		 * (unless either creation time is unknown), and the link must not close a cycle.
+		 */
+		[[nodiscard]] bool CanLink(const std::uint32_t parent, const std::uint32_t child) const {
+			const auto parent_creation = nodes_[parent].process.creation;
+			const auto child_creation = nodes_[child].process.creation;
+			if (parent_creation != 0 && child_creation != 0 && parent_creation > child_creation) return false;
+			return !IsAncestorSlot(child, parent);
+		}
+
+		void Link(const std::uint32_t parent, const std::uint32_t child) {
+			auto& node = nodes_[child];
+			node.parent = parent;
+			node.previous_sibling = kNone;
+			node.next_sibling = nodes_[parent].first_child;
+			if (node.next_sibling != kNone) nodes_[node.next_sibling].previous_sibling = child;
+			nodes_[parent].first_child = child;
+		}
+
+		void Unlink(const std::uint32_t child) {
+			auto& node = nodes_[child];
+			if (node.orphan) {
+				const auto [begin, end] = orphans_.equal_range(node.process.parent_pid);
+				for (auto it = begin; it != end; ++it) {
+					if (it->second != child) continue;
+					orphans_.erase(it);
+					break;
+				}
+
+				node.orphan = false;
+			}
+
+			if (node.parent == kNone) return;
+
+			if (node.previous_sibling != kNone) nodes_[node.previous_sibling].next_sibling = node.next_sibling;
+			else nodes_[node.parent].first_child = node.next_sibling;
+			if (node.next_sibling != kNone) nodes_[node.next_sibling].previous_sibling = node.previous_sibling;
+
+			node.parent = node.next_sibling = node.previous_sibling = kNone;
+		}
+
+		std::uint32_t AddNode(const Process& process) {
+			std::uint32_t slot;
+			if (!free_.empty()) {
+				slot = free_.back();
+				free_.pop_back();
+			} else {
+				slot = static_cast<std::uint32_t>(nodes_.size());
+				nodes_.emplace_back();
+			}
+
+			nodes_[slot] = Node{};
+			nodes_[slot].process = process;
+			nodes_[slot].used = true;
+			index_[process.pid] = slot;
+
+			// Link the process to its parent, or wait for the parent if it is not known yet.
+			if (process.parent_pid != process.pid) {
+				const auto parent = Slot(process.parent_pid);
+				if (parent == kNone) {
+					orphans_.emplace(process.parent_pid, slot);
+					nodes_[slot].orphan = true;
+				} else if (CanLink(parent, slot)) {
+					Link(parent, slot);
+				}
+			}
+
+			// Adopt the processes that were waiting for this one. Those created before it had a parent that
+			// exited, and cannot be adopted by a later process either, so they stop waiting.
+			const auto [begin, end] = orphans_.equal_range(process.pid);
+			for (auto it = begin; it != end;) {
+				const auto child = it->second;
+				it = orphans_.erase(it);
+				nodes_[child].orphan = false;
+				if (CanLink(slot, child)) Link(slot, child);
+			}
+
+			return slot;
+		}
+
+		void RemoveNode(const std::uint32_t slot) {
+			Unlink(slot);
+			for (auto child = nodes_[slot].first_child; child != kNone;) {
+				const auto next = nodes_[child].next_sibling;
+				nodes_[child].parent = nodes_[child].next_sibling = nodes_[child].previous_sibling = kNone;
+				child = next;
+			}
+
+			index_.erase(nodes_[slot].process.pid);
+			nodes_[slot] = Node{};
+			free_.push_back(slot);
+		}
+	};
+} // namespace wmipp
+
+#endif // SD_WMIPP_PROCESS_TREE_HXX
@@ -0,0 +1,777 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_SKETCHES_HXX
+#define SD_WMIPP_SKETCHES_HXX
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "columnar.hxx"
+#include "fingerprint.hxx"
+#include "value.hxx"
+
+namespace wmipp
+{
+	namespace detail
+	{
+		/**
+		 * \brief Returns true if a value is hashed by its text. Integers that WMI returns as strings,
+		 * such as uint64 properties, are hashed by their value like other numbers.
+		 */
+		inline bool IsTextual(const Value& value) {
+			const auto type = value.GetType();
+			return value.IsString() && (type == CimType::String || type == CimType::DateTime || type == CimType::Reference);
+		}
+
+		/**
+		 * \brief Hashes a text for a sketch, as UTF-16 whatever the width of wchar_t.
+		 */
+		inline Fingerprint HashSketchText(const std::wstring_view text) {
+			Hasher hasher;
+			hasher.UpdateUtf16(text);
+			return hasher.Finish();
+		}
+
+		/**
+		 * \brief Hashes a value for a sketch, so that the same value hashes the same on every host.
+		 * \return The hash, or std::nullopt for nulls and arrays.
+		 */
+		inline std::optional<Fingerprint> HashSketchValue(const Value& value) {
+			Hasher hasher;
+			if (IsTextual(value)) {
+				hasher.UpdateUtf16(*value.AsString());
+			}
+			else if (const auto integer = value.AsInt64()) {
+				hasher.Update(static_cast<std::uint64_t>(*integer));
+			}
+			else if (const auto unsigned_integer = value.AsUInt64()) {
+				hasher.Update(*unsigned_integer);
+			}
+			else if (const auto real = value.AsDouble()) {
+				std::uint64_t bits;
+				std::memcpy(&bits, &*real, sizeof(bits));
+				hasher.Update(bits);
+			}
+			else if (const auto text = value.AsString()) {
+				hasher.UpdateUtf16(*text);
+			}
+			else {
+				return std::nullopt;
+			}
+
+			return hasher.Finish();
+		}
+
+		/**
+		 * \brief Writes and reads the serializations of the sketches: a four-byte tag, then LEB128
+		 * integers and little-endian doubles.
+		 */
+		class SketchWriter {
+		public:
+			explicit SketchWriter(const char (&tag)[5]) {
+				bytes_.assign(tag, tag + 4);
+			}
+
+			void Integer(std::uint64_t value) {
+				for (; value >= 0x80; value >>= 7) bytes_.push_back(static_cast<std::uint8_t>(value | 0x80));
+				bytes_.push_back(static_cast<std::uint8_t>(value));
+			}
+
+			void Real(const double value) {
+				std::uint64_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				for (int i = 0; i < 8; ++i) bytes_.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+			}
+
+			void Byte(const std::uint8_t value) {
+				bytes_.push_back(value);
+			}
+
+			void Text(const std::wstring_view text) {
+				std::string utf8;
+				AppendUtf8(utf8, text);
+				Integer(utf8.size());
+				bytes_.insert(bytes_.end(), utf8.begin(), utf8.end());
+			}
+
+			[[nodiscard]] std::vector<std::uint8_t> Finish() {
+				return std::move(bytes_);
+			}
+
+		private:
+			std::vector<std::uint8_t> bytes_;
+		};
+
+		class SketchReader {
+		public:
+			SketchReader(const std::vector<std::uint8_t>& bytes, const char (&tag)[5])
+				: data_(bytes.data()), end_(bytes.data() + bytes.size()) {
+				valid_ = bytes.size() >= 4 && std::memcmp(data_, tag, 4) == 0;
+				data_ += valid_ ? 4 : 0;
+			}
+
+			[[nodiscard]] std::uint64_t Integer() {
+				std::uint64_t value = 0;
+				for (int shift = 0; valid_; shift += 7) {
+					if (data_ == end_ || shift > 63) return Fail();
+					const auto byte = *data_++;
+					value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+					if ((byte & 0x80) == 0) return value;
+				}
+
+				return 0;
+			}
+
+			[[nodiscard]] double Real() {
+				if (end_ - data_ < 8) return static_cast<double>(Fail());
+
+				std::uint64_t bits = 0;
+				for (int i = 0; i < 8; ++i) bits |= static_cast<std::uint64_t>(*data_++) << (8 * i);
+				double value;
+				std::memcpy(&value, &bits, sizeof(value));
+				return value;
+			}
+
+			[[nodiscard]] std::uint8_t Byte() {
+				if (data_ == end_) return static_cast<std::uint8_t>(Fail());
+				return *data_++;
+			}
+
+			[[nodiscard]] std::wstring Text() {
+				const auto size = Integer();
+				if (!valid_ || static_cast<std::uint64_t>(end_ - data_) < size) return Fail(), std::wstring();
+
+				const std::string_view utf8(reinterpret_cast<const char*>(data_), static_cast<std::size_t>(size));
+				data_ += size;
+				return FromUtf8(utf8);
+			}
+
+			/**
+			 * \brief Returns true if everything was read successfully, and nothing is left.
+			 */
+			[[nodiscard]] bool Done() const {
+				return valid_ && data_ == end_;
+			}
+
+			[[nodiscard]] bool IsValid() const {
+				return valid_;
+			}
+
+		private:
+			const std::uint8_t* data_;
+			const std::uint8_t* end_;
+			bool valid_;
+
+			std::uint64_t Fail() {
+				valid_ = false;
+				return 0;
+			}
+		};
+	} // namespace detail
+
+	/**
+	 * \brief Estimates the number of distinct values of a stream, such as the distinct file extensions
+	 * of CIM_DataFile, in 2^precision bytes with a relative error of about 1.04 / sqrt(2^precision).
+	 * Sketches built with the same precision can be merged, on one host or after being serialized.
+	 */
+	class HyperLogLog {
+	public:
+		/**
+		 * \param precision The number of hash bits selecting a register, between 4 and 18.
+		 * The default of 14 uses 16 KiB and estimates within about 0.8%.
+		 * \throws std::invalid_argument if the precision is out of range.
+		 */
+		explicit HyperLogLog(const unsigned precision = 14) : precision_(precision) {
+			if (precision < 4 || precision > 18) {
+				throw std::invalid_argument("The precision of a HyperLogLog must be between 4 and 18");
+			}
+
+			registers_.assign(std::size_t{1} << precision, 0);
+		}
+
+		[[nodiscard]] unsigned GetPrecision() const {
+			return precision_;
+		}
+
+		/**
+		 * \brief Adds a value. Nulls and arrays are ignored.
+		 */
+		void Add(const Value& value) {
+			if (const auto hash = detail::HashSketchValue(value)) AddHash(hash->low);
+		}
+
+		void Add(const std::wstring_view text) {
+			AddHash(detail::HashSketchText(text).low);
+		}
+
+		/**
+		 * \brief Adds a value by its 64-bit hash, which must be uniformly distributed.
+		 */
+		void AddHash(const std::uint64_t hash) {
+			const auto index = static_cast<std::size_t>(hash >> (64 - precision_));
+			const auto rest = hash << precision_;
+			const auto rank = static_cast<std::uint8_t>(rest == 0 ? 64 - precision_ + 1 : LeadingZeros(rest) + 1);
+			registers_[index] = (std::max)(registers_[index], rank);
+		}
+
+		/**
+		 * \brief Returns the estimated number of distinct values added.
+		 */
+		[[nodiscard]] double Estimate() const {
+			const auto m = static_cast<double>(registers_.size());
+			double sum = 0.0;
+			std::size_t zeros = 0;
+			for (const auto rank : registers_) {
+				sum += std::ldexp(1.0, -static_cast<int>(rank));
+				zeros += rank == 0;
+			}
+
+			const auto alpha = registers_.size() == 16 ? 0.673
+				: registers_.size() == 32 ? 0.697
+				: registers_.size() == 64 ? 0.709
+				: 0.7213 / (1.0 + 1.079 / m);
+			const auto estimate = alpha * m * m / sum;
+
+			// Linear counting is more accurate while many registers are still empty.
+			if (estimate <= 2.5 * m && zeros != 0) return m * std::log(m / static_cast<double>(zeros));
+			return estimate;
+		}
+
+		/**
+		 * \brief Adds the values of another sketch to this one.
+		 * \throws std::invalid_argument if the precisions differ.
+		 */
+		void Merge(const HyperLogLog& other) {
+			if (other.precision_ != precision_) throw std::invalid_argument("Cannot merge HyperLogLogs of different precisions");
+			for (std::size_t i = 0; i < registers_.size(); ++i) registers_[i] = (std::max)(registers_[i], other.registers_[i]);
+		}
+
+		/**
+		 * \brief Serializes the sketch. Sparse sketches store their non-empty registers, and dense ones
+		 * pack every register in 6 bits.
+		 */
+		[[nodiscard]] std::vector<std::uint8_t> Serialize() const {
+			detail::SketchWriter writer(kTag);
+			writer.Byte(static_cast<std::uint8_t>(precision_));
+
+			const auto used = static_cast<std::size_t>(std::count_if(registers_.begin(), registers_.end(), [](const std::uint8_t rank) {
+				return rank != 0;
+			}));
+
+			// A sparse entry takes about 3 bytes, against 0.75 for a packed register.
+			if (used * 4 < registers_.size()) {
+				writer.Byte(kSparse);
+				writer.Integer(used);
+				std::size_t previous = 0;
+				for (std::size_t i = 0; i < registers_.size(); ++i) {
+					if (registers_[i] == 0) continue;
+					writer.Integer(i - previous);
+					writer.Byte(registers_[i]);
+					previous = i;
+				}
+			}
+			else {
+				writer.Byte(kDense);
+				std::uint32_t bits = 0;
+				int pending = 0;
+				for (const auto rank : registers_) {
+					bits |= static_cast<std::uint32_t>(rank) << pending;
+					for (pending += 6; pending >= 8; pending -= 8, bits >>= 8) writer.Byte(static_cast<std::uint8_t>(bits));
+				}
+
+				if (pending > 0) writer.Byte(static_cast<std::uint8_t>(bits));
+			}
+
+			return writer.Finish();
+		}
+
+		/**
+		 * \return The sketch, or std::nullopt if the bytes were not produced by Serialize.
+		 */
+		[[nodiscard]] static std::optional<HyperLogLog> Deserialize(const std::vector<std::uint8_t>& bytes) {
+			detail::SketchReader reader(bytes, kTag);
+			const auto precision = reader.Byte();
+			if (!reader.IsValid() || precision < 4 || precision > 18) return std::nullopt;
+
+			HyperLogLog sketch(precision);
+			const auto encoding = reader.Byte();
+			if (encoding == kSparse) {
+				const auto used = reader.Integer();
+				std::size_t index = 0;
+				for (std::uint64_t i = 0; i < used && reader.IsValid(); ++i) {
+					index += static_cast<std::size_t>(reader.Integer());
+					const auto rank = reader.Byte();
+					if (index >= sketch.registers_.size() || rank > 64) return std::nullopt;
+					sketch.registers_[index] = rank;
+				}
+			}
+			else if (encoding == kDense) {
+				std::uint32_t bits = 0;
+				int available = 0;
+				for (auto& rank : sketch.registers_) {
+					for (; available < 6 && reader.IsValid(); available += 8) bits |= static_cast<std::uint32_t>(reader.Byte()) << available;
+					rank = static_cast<std::uint8_t>(bits & 0x3F);
+					bits >>= 6;
+					available -= 6;
+				}
+			}
+			else {
+				return std::nullopt;
+			}
+
+			if (!reader.Done()) return std::nullopt;
+			return sketch;
+		}
+
+	private:
+		static constexpr const char kTag[5] = "HLL1";
+		static constexpr std::uint8_t kSparse = 0;
+		static constexpr std::uint8_t kDense = 1;
+
+		unsigned precision_;
+		std::vector<std::uint8_t> registers_;
+
+		static unsigned LeadingZeros(std::uint64_t value) {
+			unsigned count = 0;
+			for (unsigned shift = 32; shift > 0; shift /= 2) {
+				if ((value >> (64 - shift)) == 0) {
+					count += shift;
+					value <<= shift;
+				}
+			}
+
+			return count;
+		}
+	};
+
+	/**
+	 * \brief Estimates how often values occur in a stream, such as the event sources of Win32_NTLogEvent,
+	 * and tracks the most frequent ones. Estimates never undercount, and overcount by at most
+	 * e / width times the total count with probability 1 - exp(-depth).
+	 * Sketches built with the same dimensions can be merged, on one host or after being serialized.
+	 */
+	class CountMinSketch {
+	public:
+		/**
+		 * \param width The number of counters per row.
+		 * \param depth The number of rows, each indexed by an independent hash.
+		 * \param heavy_hitters The number of most frequent values to track, which are added as strings.
+		 * \throws std::invalid_argument if the width or depth is zero.
+		 */
+		explicit CountMinSketch(const std::size_t width = 2048, const std::size_t depth = 4, const std::size_t heavy_hitters = 16)
+			: width_(width), depth_(depth), capacity_(heavy_hitters) {
+			if (width == 0 || depth == 0) throw std::invalid_argument("A CountMinSketch needs a non-zero width and depth");
+			counters_.assign(width * depth, 0);
+		}
+
+		[[nodiscard]] std::size_t GetWidth() const {
+			return width_;
+		}
+
+		[[nodiscard]] std::size_t GetDepth() const {
+			return depth_;
+		}
+
+		/**
+		 * \brief Returns the sum of all counts added.
+		 */
+		[[nodiscard]] std::uint64_t GetTotal() const {
+			return total_;
+		}
+
+		/**
+		 * \brief Adds a value. Nulls and arrays are ignored, and numbers are counted by their decimal text.
+		 */
+		void Add(const Value& value, const std::uint64_t count = 1) {
+			if (detail::IsTextual(value)) Add(*value.AsString(), count);
+			else if (const auto key = ToKey(value)) Add(*key, count);
+		}
+
+		void Add(const std::wstring_view text, const std::uint64_t count = 1) {
+			Track(text, AddHash(detail::HashSketchText(text), count));
+		}
+
+		/**
+		 * \brief Returns the estimated count of a value.
+		 */
+		[[nodiscard]] std::uint64_t Estimate(const Value& value) const {
+			if (detail::IsTextual(value)) return Estimate(*value.AsString());
+			const auto key = ToKey(value);
+			return key ? Estimate(*key) : 0;
+		}
+
+		[[nodiscard]] std::uint64_t Estimate(const std::wstring_view text) const {
+			return EstimateHash(detail::HashSketchText(text));
+		}
+
+		/**
+		 * \brief Returns the tracked values with their estimated counts, most frequent first.
+		 * A value is tracked if it was among the most frequent when it was last added.
+		 */
+		[[nodiscard]] std::vector<std::pair<std::wstring, std::uint64_t>> GetHeavyHitters() const {
+			auto hitters = hitters_;
+			std::sort(hitters.begin(), hitters.end(), [](const auto& a, const auto& b) {
+				return a.second != b.second ? a.second > b.second : a.first < b.first;
+			});
+			return hitters;
+		}
+
+		/**
+		 * \brief Adds the counts of another sketch to this one, and re-ranks the heavy hitters of both.
+		 * \throws std::invalid_argument if the dimensions differ.
+		 */
+		void Merge(const CountMinSketch& other) {
+			if (other.width_ != width_ || other.depth_ != depth_) {
+				throw std::invalid_argument("Cannot merge CountMinSketches of different dimensions");
+			}
+
+			for (std::size_t i = 0; i < counters_.size(); ++i) counters_[i] += other.counters_[i];
+			total_ += other.total_;
+
+			auto candidates = std::move(hitters_);
+			candidates.insert(candidates.end(), other.hitters_.begin(), other.hitters_.end());
+			hitters_.clear();
+			for (const auto& [key, count] : candidates) {
+				const auto known = std::any_of(hitters_.begin(), hitters_.end(), [&](const auto& hitter) {
+					return hitter.first == key;
+				});
+				if (!known) Track(key, Estimate(key));
+			}
+		}
+
+		/**
+		 * \brief Serializes the sketch. Counters are stored as variable-length integers, so that empty
+		 * and small counters take a single byte.
+		 */
+		[[nodiscard]] std::vector<std::uint8_t> Serialize() const {
+			detail::SketchWriter writer(kTag);
+			writer.Integer(width_);
+			writer.Integer(depth_);
+			writer.Integer(capacity_);
+			writer.Integer(total_);
+			for (const auto counter : counters_) writer.Integer(counter);
+
+			writer.Integer(hitters_.size());
+			for (const auto& [key, count] : hitters_) {
+				writer.Text(key);
+				writer.Integer(count);
+			}
+
+			return writer.Finish();
+		}
+
+		/**
+		 * \return The sketch, or std::nullopt if the bytes were not produced by Serialize.
+		 */
+		[[nodiscard]] static std::optional<CountMinSketch> Deserialize(const std::vector<std::uint8_t>& bytes) {
+			detail::SketchReader reader(bytes, kTag);
+			const auto width = reader.Integer();
+			const auto depth = reader.Integer();
+			const auto capacity = reader.Integer();
+
+			// Every counter takes at least a byte, which bounds the dimensions by the size of the input.
+			if (!reader.IsValid() || width == 0 || depth == 0 || width > bytes.size() || depth > bytes.size() / width) {
+				return std::nullopt;
+			}
+
+			CountMinSketch sketch(static_cast<std::size_t>(width), static_cast<std::size_t>(depth), static_cast<std::size_t>(capacity));
+			sketch.total_ = reader.Integer();
+			for (auto& counter : sketch.counters_) counter = reader.Integer();
+
+			const auto hitters = reader.Integer();
+			for (std::uint64_t i = 0; i < hitters && reader.IsValid(); ++i) {
+				auto key = reader.Text();
+				const auto count = reader.Integer();
+				sketch.hitters_.emplace_back(std::move(key), count);
+			}
+
+			if (!reader.Done() || sketch.hitters_.size() > sketch.capacity_) return std::nullopt;
+			return sketch;
+		}
+
+	private:
+		static constexpr const char kTag[5] = "CMS1";
+
+		std::size_t width_;
+		std::size_t depth_;
+		std::size_t capacity_;
+		std::uint64_t total_ = 0;
+
+		/**
+		 * \brief The counters, row after row.
+		 */
+		std::vector<std::uint64_t> counters_;
+
+		/**
+		 * \brief The tracked values and their estimated counts, unordered. There are few of them,
+		 * so a vector is faster than a map.
+		 */
+		std::vector<std::pair<std::wstring, std::uint64_t>> hitters_;
+
+		/**
+		 * \brief Derives the column of every row from the two halves of the hash.
+		 */
+		[[nodiscard]] std::size_t Column(const Fingerprint& hash, const std::size_t row) const {
+			return static_cast<std::size_t>((hash.low + row * (hash.high | 1)) % width_);
+		}
+
+		std::uint64_t AddHash(const Fingerprint& hash, const std::uint64_t count) {
+			total_ += count;
+			auto estimate = (std::numeric_limits<std::uint64_t>::max)();
+			for (std::size_t row = 0; row < depth_; ++row) {
+				auto& counter = counters_[row * width_ + Column(hash, row)];
+				counter += count;
+				estimate = (std::min)(estimate, counter);
+			}
+
+			return estimate;
+		}
+
+		[[nodiscard]] std::uint64_t EstimateHash(const Fingerprint& hash) const {
+			auto estimate = (std::numeric_limits<std::uint64_t>::max)();
+			for (std::size_t row = 0; row < depth_; ++row) {
+				estimate = (std::min)(estimate, counters_[row * width_ + Column(hash, row)]);
+			}
+
+			return estimate;
+		}
+
+		/**
+		 * \brief Updates the count of a tracked value, or tracks it in place of the least frequent one.
+		 */
+		void Track(const std::wstring_view key, const std::uint64_t estimate) {
+			if (capacity_ == 0) return;
+
+			std::size_t least = 0;
+			for (std::size_t i = 0; i < hitters_.size(); ++i) {
+				if (hitters_[i].first == key) {
+					hitters_[i].second = estimate;
+					return;
+				}
+
+				if (hitters_[i].second < hitters_[least].second) least = i;
+			}
+
+			if (hitters_.size() < capacity_) hitters_.emplace_back(key, estimate);
+			else if (hitters_[least].second < estimate) hitters_[least] = {std::wstring(key), estimate};
+		}
+
+		static std::optional<std::wstring> ToKey(const Value& value) {
+			if (value.IsNull() || value.IsArray()) return std::nullopt;
+			if (const auto integer = value.AsInt64()) return std::to_wstring(*integer);
+			if (const auto unsigned_integer = value.AsUInt64()) return std::to_wstring(*unsigned_integer);
+			if (const auto real = value.AsDouble()) return detail::FormatReal(*real);
+			if (const auto text = value.AsString()) return std::wstring(*text);
+			return std::nullopt;
+		}
+	};
+
+	/**
+	 * \brief Estimates the quantiles of a stream of numbers, such as sizes or durations, in a bounded
+	 * number of centroids. Quantiles near 0 and 1 are the most accurate.
+	 * Digests can be merged, on one host or after being serialized.
+	 */
+	class TDigest {
+	public:
+		/**
+		 * \param compression Bounds the number of centroids to about twice its value. Higher values are more accurate.
+		 * \throws std::invalid_argument if the compression is not positive.
+		 */
+		explicit TDigest(const double compression = 100.0) : compression_(compression) {
+			if (!(compression > 0.0)) throw std::invalid_argument("The compression of a TDigest must be positive");
+		}
+
+		/**
+		 * \brief Adds a number. Values that are not numbers, or not finite, are ignored.
+		 */
+		void Add(const Value& value) {
+			if (const auto number = value.AsDouble()) Add(*number);
+		}
+
+		void Add(const double value, const double weight = 1.0) {
+			if (!std::isfinite(value) || !(weight > 0.0)) return;
+
+			buffer_.push_back({value, weight});
+			min_ = (std::min)(min_, value);
+			max_ = (std::max)(max_, value);
+			if (buffer_.size() >= BufferLimit()) Compress();
+		}
+
+		/**
+		 * \brief Returns the total weight of the numbers added.
+		 */
+		[[nodiscard]] double GetCount() const {
+			double count = 0.0;
+			for (const auto& centroid : centroids_) count += centroid.weight;
+			for (const auto& centroid : buffer_) count += centroid.weight;
+			return count;
+		}
+
+		/**
+		 * \brief Returns the estimated value at a quantile, such as 0.5 for the median or 0.99.
+		 * \return The value, or std::nullopt if nothing was added.
+		 */
+		[[nodiscard]] std::optional<double> Quantile(double q) const {
+			Compress();
+			if (centroids_.empty()) return std::nullopt;
+			if (centroids_.size() == 1) return centroids_.front().mean;
+
+			q = (std::clamp)(q, 0.0, 1.0);
+			const auto index = q * count_;
+			const auto& first = centroids_.front();
+			if (index < first.weight / 2) return min_ + (first.mean - min_) * index / (first.weight / 2);
+
+			auto cumulative = first.weight / 2;
+			for (std::size_t i = 0; i + 1 < centroids_.size(); ++i) {
+				const auto& left = centroids_[i];
+				const auto& right = centroids_[i + 1];
+				const auto step = (left.weight + right.weight) / 2;
+				if (index < cumulative + step) return left.mean + (right.mean - left.mean) * (index - cumulative) / step;
+				cumulative += step;
+			}
+
+			const auto& last = centroids_.back();
+			const auto remaining = count_ - cumulative;
+			return remaining <= 0.0 ? max_ : last.mean + (max_ - last.mean) * (index - cumulative) / remaining;
+		}
+
+		/**
+		 * \brief Adds the numbers of another digest to this one.
+		 */
+		void Merge(const TDigest& other) {
+			if (other.centroids_.empty() && other.buffer_.empty()) return;
+
+			buffer_.insert(buffer_.end(), other.centroids_.begin(), other.centroids_.end());
+			buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+			min_ = (std::min)(min_, other.min_);
+			max_ = (std::max)(max_, other.max_);
+			Compress();
+		}
+
+		/**
+		 * \brief Serializes the digest, with the mean and weight of every centroid.
+		 */
+		[[nodiscard]] std::vector<std::uint8_t> Serialize() const {
+			Compress();
+
+			detail::SketchWriter writer(kTag);
+			writer.Real(compression_);
+			writer.Integer(centroids_.size());
+			if (centroids_.empty()) return writer.Finish();
+
+			writer.Real(min_);
+			writer.Real(max_);
+			for (const auto& centroid : centroids_) {
+				writer.Real(centroid.mean);
+				writer.Real(centroid.weight);
+			}
+
+			return writer.Finish();
+		}
+
+		/**
+		 * \return The digest, or std::nullopt if the bytes were not produced by Serialize.
+		 */
+		[[nodiscard]] static std::optional<TDigest> Deserialize(const std::vector<std::uint8_t>& bytes) {
+			detail::SketchReader reader(bytes, kTag);
+			const auto compression = reader.Real();
+			const auto size = reader.Integer();
+			if (!reader.IsValid() || !(compression > 0.0) || size > bytes.size() / 16) return std::nullopt;
+
+			TDigest digest(compression);
+			if (size != 0) {
+				digest.min_ = reader.Real();
+				digest.max_ = reader.Real();
+			}
+
+			for (std::uint64_t i = 0; i < size && reader.IsValid(); ++i) {
+				const auto mean = reader.Real();
+				const auto weight = reader.Real();
+				if (!std::isfinite(mean) || !(weight > 0.0)) return std::nullopt;
+				digest.centroids_.push_back({mean, weight});
+				digest.count_ += weight;
+			}
+
+			if (!reader.Done()) return std::nullopt;
+			return digest;
+		}
+
+	private:
+		static constexpr const char kTag[5] = "TDG1";
+
+		struct Centroid {
+			double mean;
+			double weight;
+		};
+
+		double compression_;
+
+		/**
+		 * \brief The centroids sorted by mean, and the numbers added since they were last compressed,
+		 * which queries merge first.
+		 */
+		mutable std::vector<Centroid> centroids_;
+		mutable std::vector<Centroid> buffer_;
+		mutable double count_ = 0.0;
+		double min_ = std::numeric_limits<double>::infinity();
+		double max_ = -std::numeric_limits<double>::infinity();
+
+		[[nodiscard]] std::size_t BufferLimit() const {
+			return static_cast<std::size_t>(compression_ * 5) + 16;
+		}
+
+		/**
+		 * \brief Merges the buffered numbers into the centroids. Neighbouring centroids are merged while
+		 * their weight stays below 4 * count * q * (1 - q) / compression, which keeps centroids small
+		 * near the tails.
+		 */
+		void Compress() const {
+			if (buffer_.empty()) return;
+
+			buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+			std::sort(buffer_.begin(), buffer_.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+			count_ = 0.0;
+			for (const auto& centroid : buffer_) count_ += centroid.weight;
+
+			centroids_.clear();
+			auto current = buffer_.front();
+			double before = 0.0;
+			for (std::size_t i = 1; i < buffer_.size(); ++i) {
+				const auto& next = buffer_[i];
+				const auto weight = current.weight + next.weight;
+				const auto q = (before + weight / 2) / count_;
+				if (weight <= (std::max)(1.0, 4 * count_ * q * (1 - q) / compression_)) {
+					current.mean += (next.mean - current.mean) * next.weight / weight;
+					current.weight = weight;
+				}
+				else {
+					before += current.weight;
+					centroids_.push_back(current);
+					current = next;
+				}
+			}
+
+			centroids_.push_back(current);
+			buffer_.clear();
+		}
+	};
+} // namespace wmipp
+
+#endif // SD_WMIPP_SKETCHES_HXX
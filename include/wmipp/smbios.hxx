@@ -0,0 +1,413 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_SMBIOS_HXX
+#define SD_WMIPP_SMBIOS_HXX
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace wmipp::smbios
+{
+	/**
+	 * \brief The types of the SMBIOS structures decoded by this header.
+	 */
+	enum class Type : std::uint8_t {
+		Bios = 0,
+		System = 1,
+		Baseboard = 2,
+		Chassis = 3,
+		Processor = 4,
+		MemoryDevice = 17,
+		EndOfTable = 127,
+	};
+
+	/**
+	 * \brief A view of a single structure of an SMBIOS table: its formatted area and its string set.
+	 * Structures do not own their data, which must outlive them.
+	 */
+	class Structure {
+	public:
+		Structure() = default;
+		Structure(const std::byte* formatted, const std::size_t length, const char* strings, const std::size_t strings_size)
+			: formatted_(formatted), length_(length), strings_(strings), strings_size_(strings_size) {}
+
+		[[nodiscard]] std::uint8_t GetType() const {
+			return static_cast<std::uint8_t>(formatted_[0]);
+		}
+
+		[[nodiscard]] std::uint16_t GetHandle() const {
+			return *Word(2);
+		}
+
+		/**
+		 * \brief Returns the formatted area of the structure, including its 4-byte header.
+		 */
+		[[nodiscard]] const std::byte* data() const {
+			return formatted_;
+		}
+
+		[[nodiscard]] std::size_t size() const {
+			return length_;
+		}
+
+		/**
+		 * \brief Reads a little-endian field of the formatted area.
+		 * \return The field, or std::nullopt if the structure is too short to contain it, which is
+		 * how fields added by later versions of the specification are missing.
+		 */
+		[[nodiscard]] std::optional<std::uint8_t> Byte(const std::size_t offset) const {
+			return Read<std::uint8_t>(offset);
+		}
+
+		[[nodiscard]] std::optional<std::uint16_t> Word(const std::size_t offset) const {
+			return Read<std::uint16_t>(offset);
+		}
+
+		[[nodiscard]] std::optional<std::uint32_t> DWord(const std::size_t offset) const {
+			return Read<std::uint32_t>(offset);
+		}
+
+		[[nodiscard]] std::optional<std::uint64_t> QWord(const std::size_t offset) const {
+			return Read<std::uint64_t>(offset);
+		}
+
+		/**
+		 * \brief Reads the string referenced by the string number at the given offset.
+		 * \return A view into the table, or an empty string if the field is missing or references no string.
+		 */
+		[[nodiscard]] std::string_view String(const std::size_t offset) const {
+			const auto number = Byte(offset);
+			if (!number || *number == 0) return {};
+
+			std::size_t position = 0;
+			for (auto i = 1; position < strings_size_; ++i) {
+				const auto length = std::strlen(strings_ + position);
+				if (length == 0) break;
+				if (i == *number) return {strings_ + position, length};
+				position += length + 1;
+			}
+
+			return {};
+		}
+
+	private:
+		const std::byte* formatted_ = nullptr;
+		std::size_t length_ = 0;
+		const char* strings_ = nullptr;
+		std::size_t strings_size_ = 0;
+
+		template <typename T>
+		[[nodiscard]] std::optional<T> Read(const std::size_t offset) const {
+			if (offset + sizeof(T) > length_) return std::nullopt;
+
+			T value = 0;
+			for (std::size_t i = 0; i < sizeof(T); ++i) {
+				value |= static_cast<T>(static_cast<T>(formatted_[offset + i]) << (i * 8));
+			}
+
+			return value;
+		}
+	};
+
+	/**
+	 * \brief A view of a raw SMBIOS table, such as MSSmBios_RawSMBiosTables.SMBiosData in root\WMI,
+	 * that iterates over its structures without copying them.
+	 * Parsing stops at the end-of-table structure, or at the first structure that is truncated.
+	 */
+	class Table {
+	public:
+		class Iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Structure;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Structure*;
+			using reference = const Structure&;
+
+			Iterator() = default;
+			Iterator(const std::byte* data, const std::size_t size) : data_(data), size_(size) { Parse(); }
+
+			reference operator*() const { return current_; }
+			pointer operator->() const { return &current_; }
+
+			Iterator& operator++() {
+				offset_ = next_;
+				Parse();
+				return *this;
+			}
+
+			Iterator operator++(int) {
+				auto copy = *this;
+				++*this;
+				return copy;
+			}
+
+			bool operator==(const Iterator& other) const { return data_ == other.data_ && offset_ == other.offset_; }
+			bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+		private:
+			const std::byte* data_ = nullptr;
+			std::size_t size_ = 0;
+			std::size_t offset_ = 0;
+			std::size_t next_ = 0;
+			Structure current_;
+
+			/**
+			 * \brief Decodes the structure at the current offset, or turns into the end iterator.
+			 */
+			void Parse() {
+				if (data_ == nullptr) return;
+
+				const auto remaining = size_ - offset_;
+				const auto length = remaining >= 4 ? static_cast<std::size_t>(data_[offset_ + 1]) : 0;
+				if (length < 4 || length > remaining) return End();
+
+				// The string set ends with two NULs, even when it is empty.
+				const auto* strings = reinterpret_cast<const char*>(data_ + offset_ + length);
+				const auto strings_size = remaining - length;
+				std::size_t end = 0;
+				while (end + 1 < strings_size && (strings[end] != '\0' || strings[end + 1] != '\0')) ++end;
+				if (end + 1 >= strings_size) return End();
+
+				current_ = Structure(data_ + offset_, length, strings, end + 1);
+				if (current_.GetType() == static_cast<std::uint8_t>(Type::EndOfTable)) return End();
+				next_ = offset_ + length + end + 2;
+			}
+
+			void End() {
+				data_ = nullptr;
+				offset_ = 0;
+			}
+		};
+
+		Table() = default;
+		Table(const void* data, const std::size_t size) : data_(static_cast<const std::byte*>(data)), size_(size) {}
+
+		[[nodiscard]] Iterator begin() const {
+			return data_ != nullptr ? Iterator(data_, size_) : Iterator();
+		}
+
+		[[nodiscard]] Iterator end() const {
+			return {};
+		}
+
+		/**
+		 * \brief Returns the structures of the given type, in table order.
+		 */
+		[[nodiscard]] std::vector<Structure> FindAll(const Type type) const {
+			std::vector<Structure> result;
+			for (const auto& structure : *this) {
+				if (structure.GetType() == static_cast<std::uint8_t>(type)) result.push_back(structure);
+			}
+
+			return result;
+		}
+
+		/**
+		 * \brief Returns the first structure of the given type, if any.
+		 */
+		[[nodiscard]] std::optional<Structure> Find(const Type type) const {
+			for (const auto& structure : *this) {
+				if (structure.GetType() == static_cast<std::uint8_t>(type)) return structure;
+			}
+
+			return std::nullopt;
+		}
+
+	private:
+		const std::byte* data_ = nullptr;
+		std::size_t size_ = 0;
+	};
+
+	/**
+	 * \brief The decoded structures below hold views into the table, which must outlive them.
+	 * Numeric fields that are missing from older versions of a structure are std::nullopt.
+	 */
+	struct BiosInformation {
+		std::string_view vendor;
+		std::string_view version;
+		std::string_view release_date;
+		std::optional<std::uint8_t> major_release;
+		std::optional<std::uint8_t> minor_release;
+	};
+
+	struct SystemInformation {
+		std::string_view manufacturer;
+		std::string_view product_name;
+		std::string_view version;
+		std::string_view serial_number;
+
+		/**
+		 * \brief The system UUID in its canonical form, as reported by Win32_ComputerSystemProduct.UUID.
+		 */
+		std::optional<std::string> uuid;
+		std::string_view sku_number;
+		std::string_view family;
+	};
+
+	struct BaseboardInformation {
+		std::string_view manufacturer;
+		std::string_view product;
+		std::string_view version;
+		std::string_view serial_number;
+		std::string_view asset_tag;
+	};
+
+	struct ChassisInformation {
+		std::string_view manufacturer;
+		std::optional<std::uint8_t> type;
+		std::string_view version;
+		std::string_view serial_number;
+		std::string_view asset_tag;
+	};
+
+	struct ProcessorInformation {
+		std::string_view socket;
+		std::string_view manufacturer;
+		std::string_view version;
+		std::optional<std::uint16_t> max_speed_mhz;
+		std::optional<std::uint16_t> current_speed_mhz;
+		std::optional<std::uint16_t> core_count;
+		std::optional<std::uint16_t> thread_count;
+	};
+
+	struct MemoryDeviceInformation {
+		/**
+		 * \brief The size of the installed module in bytes; zero for an empty slot, and std::nullopt if unknown.
+		 */
+		std::optional<std::uint64_t> size;
+		std::string_view device_locator;
+		std::string_view bank_locator;
+		std::optional<std::uint8_t> memory_type;
+		std::optional<std::uint16_t> speed_mts;
+		std::string_view manufacturer;
+		std::string_view serial_number;
+		std::string_view part_number;
+		std::optional<std::uint16_t> configured_speed_mts;
+	};
+
+	[[nodiscard]] inline BiosInformation DecodeBios(const Structure& structure) {
+		return {
+			structure.String(0x04),
+			structure.String(0x05),
+			structure.String(0x08),
+			structure.Byte(0x14),
+			structure.Byte(0x15),
+		};
+	}
+
+	[[nodiscard]] inline SystemInformation DecodeSystem(const Structure& structure) {
+		SystemInformation result;
+		result.manufacturer = structure.String(0x04);
+		result.product_name = structure.String(0x05);
+		result.version = structure.String(0x06);
+		result.serial_number = structure.String(0x07);
+		result.sku_number = structure.String(0x19);
+		result.family = structure.String(0x1A);
+
+		// The first three fields are little-endian, as in SMBIOS 2.6 and later.
+		if (structure.size() >= 0x18) {
+			const auto* uuid = structure.data() + 0x08;
+			static constexpr int kOrder[] = {3, 2, 1, 0, -1, 5, 4, -1, 7, 6, -1, 8, 9, -1, 10, 11, 12, 13, 14, 15};
+			std::string text;
+			for (const auto index : kOrder) {
+				if (index < 0) {
+					text += '-';
+					continue;
+				}
+
+				char digits[3];
+				std::snprintf(digits, sizeof(digits), "%02X", static_cast<unsigned>(uuid[index]));
+				text += digits;
+			}
+
+			result.uuid = std::move(text);
+		}
+
+		return result;
+	}
+
+	[[nodiscard]] inline BaseboardInformation DecodeBaseboard(const Structure& structure) {
+		return {
+			structure.String(0x04),
+			structure.String(0x05),
+			structure.String(0x06),
+			structure.String(0x07),
+			structure.String(0x08),
+		};
+	}
+
+	[[nodiscard]] inline ChassisInformation DecodeChassis(const Structure& structure) {
+		auto type = structure.Byte(0x05);
+		if (type) *type &= 0x7F;
+
+		return {
+			structure.String(0x04),
+			type,
+			structure.String(0x06),
+			structure.String(0x07),
+			structure.String(0x08),
+		};
+	}
+
+	[[nodiscard]] inline ProcessorInformation DecodeProcessor(const Structure& structure) {
+		ProcessorInformation result;
+		result.socket = structure.String(0x04);
+		result.manufacturer = structure.String(0x07);
+		result.version = structure.String(0x10);
+		result.max_speed_mhz = structure.Word(0x14);
+		result.current_speed_mhz = structure.Word(0x16);
+
+		// Counts above 254 are stored in the 16-bit fields added by SMBIOS 3.0.
+		if (const auto cores = structure.Byte(0x23)) {
+			result.core_count = *cores == 0xFF ? structure.Word(0x2A) : std::optional<std::uint16_t>(*cores);
+		}
+
+		if (const auto threads = structure.Byte(0x25)) {
+			result.thread_count = *threads == 0xFF ? structure.Word(0x2E) : std::optional<std::uint16_t>(*threads);
+		}
+
+		return result;
+	}
+
+	[[nodiscard]] inline MemoryDeviceInformation DecodeMemoryDevice(const Structure& structure) {
+		MemoryDeviceInformation result;
+		if (const auto size = structure.Word(0x0C); size && *size != 0xFFFF) {
+			if (*size == 0x7FFF) {
+				// Modules of 32 GiB or more store their size in megabytes in the extended field.
+				if (const auto extended = structure.DWord(0x1C)) {
+					result.size = static_cast<std::uint64_t>(*extended & 0x7FFFFFFF) << 20;
+				}
+			}
+			else {
+				const auto granularity = (*size & 0x8000) != 0 ? 10 : 20;
+				result.size = static_cast<std::uint64_t>(*size & 0x7FFF) << granularity;
+			}
+		}
+
+		result.device_locator = structure.String(0x10);
+		result.bank_locator = structure.String(0x11);
+		result.memory_type = structure.Byte(0x12);
+		result.speed_mts = structure.Word(0x15);
+		result.manufacturer = structure.String(0x17);
+		result.serial_number = structure.String(0x18);
+		result.part_number = structure.String(0x1A);
+		result.configured_speed_mts = structure.Word(0x20);
+		return result;
+	}
+} // namespace wmipp::smbios
+
+#endif // SD_WMIPP_SMBIOS_HXX
@@ -0,0 +1,504 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_TIMESERIES_HXX
+#define SD_WMIPP_TIMESERIES_HXX
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "columnar.hxx"
+#include "rates.hxx"
+#include "value.hxx"
+
+namespace wmipp
+{
+	/**
+	 * \brief A level of detail of a TimeSeriesStore: the values of every series are aggregated into
+	 * buckets of the given resolution, and the most recent buckets are kept.
+	 */
+	struct TimeSeriesTier {
+		std::chrono::seconds resolution;
+		std::size_t capacity;
+	};
+
+	/**
+	 * \brief The aggregate of the samples of a series within a bucket, or a window.
+	 */
+	struct TimeSeriesPoint {
+		std::chrono::steady_clock::time_point start;
+		double min = 0.0;
+		double max = 0.0;
+		double average = 0.0;
+		std::uint32_t count = 0;
+	};
+
+	/**
+	 * \brief Keeps the recent values of sampled counters, keyed by query, instance and property.
+	 * Every tier stores the buckets of all series in fixed-size ring buffers laid out column by column
+	 * (bucket, min, max, sum and count), so that samples are recorded without allocating once a series
+	 * exists, and windows are scanned over contiguous memory. Each tier aggregates the samples itself,
+	 * so coarse tiers are exact downsamplings of the fine ones.
+	 *
+	 * A slot takes 36 bytes, so the default tiers take about 6.5 KB per series.
+	 *
+	 * Like standard containers, a store can be read by several threads at once, but must not be read
+	 * while it is being written to.
+	 */
+	class TimeSeriesStore {
+	public:
+		/**
+		 * \brief Returns the default tiers: one minute at 1s, ten minutes at 10s and one hour at 1m.
+		 */
+		[[nodiscard]] static std::vector<TimeSeriesTier> DefaultTiers() {
+			return {
+				{std::chrono::seconds(1), 60},
+				{std::chrono::seconds(10), 60},
+				{std::chrono::seconds(60), 60},
+			};
+		}
+
+		/**
+		 * \throws std::invalid_argument if there is no tier, if a tier is empty, or if the resolutions
+		 * are not increasing.
+		 */
+		explicit TimeSeriesStore(const std::vector<TimeSeriesTier>& tiers = DefaultTiers()) {
+			if (tiers.empty()) throw std::invalid_argument("A TimeSeriesStore needs at least one tier");
+
+			for (const auto& tier : tiers) {
+				if (tier.resolution.count() <= 0 || tier.capacity == 0) throw std::invalid_argument("Empty time series tier");
+				if (!tiers_.empty() && tier.resolution <= tiers_.back().resolution) {
+					throw std::invalid_argument("The resolutions of the time series tiers must be increasing");
+				}
+
+				tiers_.emplace_back(tier);
+			}
+		}
+
+		/**
+		 * \brief Returns the number of series.
+		 */
+		[[nodiscard]] std::size_t size() const {
+			return keys_.size();
+		}
+
+		/**
+		 * \brief Records a sample. Samples older than the newest bucket of a tier are added to their
+		 * bucket if it is still kept, and dropped otherwise. Values that are not finite are dropped.
+		 * \param instance Identifies the instance within the query, such as the values of its key properties
+		 * separated by null characters, as returned by RateTable::GetKey.
+		 */
+		void Record(
+			const std::wstring_view query,
+			const std::wstring_view instance,
+			const std::wstring_view property,
+			const std::chrono::steady_clock::time_point time,
+			const double value) {
+			if (!std::isfinite(value)) return;
+
+			MakeKey(lookup_, query, instance, property);
+			Record(FindOrAdd(), time, value);
+		}
+
+		/**
+		 * \brief Records a sample of every numeric property of every row of a poll.
+		 * The instance of a row is made of its key properties, as for a RateTracker, and every other
+		 * numeric column is a series.
+		 * \param query Identifies the poll, such as the text of its query.
+		 * \param keys The properties identifying a row across polls.
+		 * \throws std::invalid_argument if a key column is missing from the table.
+		 */
+		void Ingest(
+			const std::wstring_view query,
+			const ColumnarTable& table,
+			const std::vector<std::wstring>& keys,
+			const std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now()) {
+			std::vector<const Column*> key_columns;
+			for (const auto& key : keys) {
+				const auto* column = table.FindColumn(key);
+				if (!column) throw std::invalid_argument("The table has no column for a key property");
+				key_columns.push_back(column);
+			}
+
+			std::vector<const Column*> value_columns;
+			for (std::size_t i = 0; i < table.ColumnCount(); ++i) {
+				const auto& column = table.GetColumn(i);
+				if (IsNumeric(column.GetType()) && std::find(key_columns.begin(), key_columns.end(), &column) == key_columns.end()) {
+					value_columns.push_back(&column);
+				}
+			}
+
+			const auto paths = detail::FindPathKeys(keys);
+			std::vector<Value> key;
+			for (std::size_t row = 0; row < table.RowCount(); ++row) {
+				key.clear();
+				for (const auto* column : key_columns) key.push_back(column->GetAt(row));
+				const auto instance = detail::JoinRateKey(key, paths);
+
+				for (const auto* column : value_columns) {
+					if (column->IsNull(row)) continue;
+					const auto value = column->GetAt(row).AsDouble();
+					if (value && std::isfinite(*value)) {
+						MakeKey(lookup_, query, instance, column->GetName());
+						Record(FindOrAdd(), time, *value);
+					}
+				}
+			}
+		}
+
+		/**
+		 * \brief Returns the instances of a query that have at least one series.
+		 */
+		[[nodiscard]] std::vector<std::wstring> GetInstances(const std::wstring_view query) const {
+			std::vector<std::wstring> instances;
+			for (const auto& key : keys_) {
+				const auto first = key.find(L'\0');
+				const auto last = key.rfind(L'\0');
+				if (std::wstring_view(key).substr(0, first) != query) continue;
+
+				auto instance = key.substr(first + 1, last - first - 1);
+				if (std::find(instances.begin(), instances.end(), instance) == instances.end()) instances.push_back(std::move(instance));
+			}
+
+			return instances;
+		}
+
+		/**
+		 * \brief Returns the buckets of a series within a window ending now, oldest first, from the finest
+		 * tier that spans the window (or the coarsest tier if none does).
+		 */
+		[[nodiscard]] std::vector<TimeSeriesPoint> GetRange(
+			const std::wstring_view query,
+			const std::wstring_view instance,
+			const std::wstring_view property,
+			const std::chrono::steady_clock::duration window,
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const {
+			std::vector<TimeSeriesPoint> points;
+			ForEachBucket(query, instance, property, window, now, [&](const Tier& tier, const std::size_t slot) {
+				TimeSeriesPoint point;
+				point.start = std::chrono::steady_clock::time_point(tier.resolution * tier.buckets[slot]);
+				point.min = tier.mins[slot];
+				point.max = tier.maxs[slot];
+				point.average = tier.sums[slot] / tier.counts[slot];
+				point.count = tier.counts[slot];
+				points.push_back(point);
+			});
+			return points;
+		}
+
+		/**
+		 * \brief Aggregates the samples of a series within a window ending now.
+		 * \return The aggregate, whose start is the start of its oldest bucket, or std::nullopt if the
+		 * series has no sample within the window.
+		 */
+		[[nodiscard]] std::optional<TimeSeriesPoint> Summarize(
+			const std::wstring_view query,
+			const std::wstring_view instance,
+			const std::wstring_view property,
+			const std::chrono::steady_clock::duration window,
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const {
+			std::optional<TimeSeriesPoint> summary;
+			double sum = 0.0;
+			ForEachBucket(query, instance, property, window, now, [&](const Tier& tier, const std::size_t slot) {
+				if (!summary) {
+					summary.emplace();
+					summary->start = std::chrono::steady_clock::time_point(tier.resolution * tier.buckets[slot]);
+					summary->min = tier.mins[slot];
+					summary->max = tier.maxs[slot];
+				}
+
+				summary->min = (std::min)(summary->min, tier.mins[slot]);
+				summary->max = (std::max)(summary->max, tier.maxs[slot]);
+				summary->count += tier.counts[slot];
+				sum += tier.sums[slot];
+			});
+
+			if (summary) summary->average = sum / summary->count;
+			return summary;
+		}
+
+		/**
+		 * \brief Estimates a percentile of a series within a window ending now, over the averages of its
+		 * buckets weighted by their number of samples. The estimate is exact when the finest tier spanning
+		 * the window holds a single sample per bucket.
+		 * \param q The percentile, between 0 and 1.
+		 * \return The percentile, or std::nullopt if the series has no sample within the window.
+		 */
+		[[nodiscard]] std::optional<double> Percentile(
+			const std::wstring_view query,
+			const std::wstring_view instance,
+			const std::wstring_view property,
+			const std::chrono::steady_clock::duration window,
+			const double q,
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) const {
+			std::vector<std::pair<double, std::uint32_t>> samples;
+			std::uint64_t total = 0;
+			ForEachBucket(query, instance, property, window, now, [&](const Tier& tier, const std::size_t slot) {
+				samples.emplace_back(tier.sums[slot] / tier.counts[slot], tier.counts[slot]);
+				total += tier.counts[slot];
+			});
+
+			if (samples.empty()) return std::nullopt;
+
+			std::sort(samples.begin(), samples.end());
+			const auto rank = static_cast<std::uint64_t>(std::ceil((std::clamp)(q, 0.0, 1.0) * static_cast<double>(total)));
+			std::uint64_t seen = 0;
+			for (const auto& [value, count] : samples) {
+				seen += count;
+				if (seen >= rank) return value;
+			}
+
+			return samples.back().first;
+		}
+
+		/**
+		 * \brief Removes the series without a sample since the given time, such as those of processes that exited.
+		 * \return The number of series removed.
+		 */
+		std::size_t Prune(const std::chrono::steady_clock::time_point since) {
+			std::size_t removed = 0;
+			for (std::size_t series = keys_.size(); series-- > 0;) {
+				const auto& tier = tiers_.front();
+				const auto slot = series * tier.capacity + tier.heads[series];
+				const auto newest = tier.resolution * (tier.buckets[slot] + 1);
+				if (tier.counts[slot] != 0 && std::chrono::steady_clock::time_point(newest) > since) continue;
+
+				Remove(series);
+				++removed;
+			}
+
+			return removed;
+		}
+
+	private:
+		/**
+		 * \brief The ring buffers of a tier, with capacity slots per series. A slot with a zero count is empty.
+		 */
+		struct Tier {
+			explicit Tier(const TimeSeriesTier& tier) : resolution(tier.resolution), capacity(tier.capacity) {}
+
+			std::chrono::seconds resolution;
+			std::size_t capacity;
+
+			/**
+			 * \brief The bucket of every slot, as the number of resolutions since the epoch of the clock.
+			 */
+			std::vector<std::int64_t> buckets;
+			std::vector<double> mins;
+			std::vector<double> maxs;
+			std::vector<double> sums;
+			std::vector<std::uint32_t> counts;
+
+			/**
+			 * \brief The slot of the newest bucket of every series.
+			 */
+			std::vector<std::size_t> heads;
+
+			void AddSeries() {
+				const auto size = buckets.size() + capacity;
+				buckets.resize(size, 0);
+				mins.resize(size, 0.0);
+				maxs.resize(size, 0.0);
+				sums.resize(size, 0.0);
+				counts.resize(size, 0);
+				heads.push_back(0);
+			}
+
+			/**
+			 * \brief Moves the last series into the slots of another, and drops the last one.
+			 */
+			void RemoveSeries(const std::size_t series) {
+				const auto last = heads.size() - 1;
+				if (series != last) {
+					const auto from = static_cast<std::ptrdiff_t>(last * capacity);
+					const auto to = static_cast<std::ptrdiff_t>(series * capacity);
+					const auto count = static_cast<std::ptrdiff_t>(capacity);
+					std::copy(buckets.begin() + from, buckets.begin() + from + count, buckets.begin() + to);
+					std::copy(mins.begin() + from, mins.begin() + from + count, mins.begin() + to);
+					std::copy(maxs.begin() + from, maxs.begin() + from + count, maxs.begin() + to);
+					std::copy(sums.begin() + from, sums.begin() + from + count, sums.begin() + to);
+					std::copy(counts.begin() + from, counts.begin() + from + count, counts.begin() + to);
+					heads[series] = heads[last];
+				}
+
+				const auto size = last * capacity;
+				buckets.resize(size);
+				mins.resize(size);
+				maxs.resize(size);
+				sums.resize(size);
+				counts.resize(size);
+				heads.pop_back();
+			}
+
+			void Record(const std::size_t series, const std::int64_t bucket, const double value) {
+				const auto base = series * capacity;
+				auto slot = base + heads[series];
+				if (counts[slot] != 0 && bucket < buckets[slot]) {
+					// A late sample: look for its bucket among the older ones.
+					for (std::size_t i = 1; i < capacity; ++i) {
+						slot = base + (heads[series] + capacity - i) % capacity;
+						if (counts[slot] == 0 || buckets[slot] < bucket) return;
+						if (buckets[slot] == bucket) break;
+					}
+
+					if (buckets[slot] != bucket) return;
+				}
+				else if (counts[slot] != 0 && bucket > buckets[slot]) {
+					heads[series] = (heads[series] + 1) % capacity;
+					slot = base + heads[series];
+					counts[slot] = 0;
+				}
+
+				if (counts[slot] == 0) {
+					buckets[slot] = bucket;
+					mins[slot] = maxs[slot] = value;
+					sums[slot] = 0.0;
+				}
+
+				mins[slot] = (std::min)(mins[slot], value);
+				maxs[slot] = (std::max)(maxs[slot], value);
+				sums[slot] += value;
+				++counts[slot];
+			}
+		};
+
+		std::vector<Tier> tiers_;
+
+		/**
+		 * \brief The key of every series (its query, instance and property separated by null characters),
+		 * and the series of every key.
+		 */
+		std::vector<std::wstring> keys_;
+		std::unordered_map<std::wstring, std::size_t> index_;
+
+		/**
+		 * \brief The key of the series being recorded, reused across samples to avoid allocating.
+		 * Const members use a buffer of their own thread instead, so that they can run concurrently.
+		 */
+		std::wstring lookup_;
+
+		static bool IsNumeric(const CimType type) {
+			switch (type) {
+			case CimType::SInt8:
+			case CimType::UInt8:
+			case CimType::SInt16:
+			case CimType::UInt16:
+			case CimType::SInt32:
+			case CimType::UInt32:
+			case CimType::SInt64:
+			case CimType::UInt64:
+			case CimType::Real32:
+			case CimType::Real64: return true;
+			default: return false;
+			}
+		}
+
+		static void MakeKey(
+			std::wstring& key,
+			const std::wstring_view query,
+			const std::wstring_view instance,
+			const std::wstring_view property) {
+			key.assign(query);
+			key += L'\0';
+			key += instance;
+			key += L'\0';
+			key += property;
+		}
+
+		[[nodiscard]] std::optional<std::size_t> Find(const std::wstring& key) const {
+			const auto it = index_.find(key);
+			if (it == index_.end()) return std::nullopt;
+			return it->second;
+		}
+
+		/**
+		 * \brief Returns the series of the key in lookup_, which is added if it does not exist.
+		 */
+		std::size_t FindOrAdd() {
+			if (const auto series = Find(lookup_)) return *series;
+
+			const auto series = keys_.size();
+			keys_.push_back(lookup_);
+			index_.emplace(lookup_, series);
+			for (auto& tier : tiers_) tier.AddSeries();
+			return series;
+		}
+
+		void Record(const std::size_t series, const std::chrono::steady_clock::time_point time, const double value) {
+			const auto since_epoch = time.time_since_epoch();
+			for (auto& tier : tiers_) {
+				// Round towards negative infinity, so that buckets before the epoch of the clock are not merged.
+				auto bucket = static_cast<std::int64_t>(since_epoch / tier.resolution);
+				if (tier.resolution * bucket > since_epoch) --bucket;
+				tier.Record(series, bucket, value);
+			}
+		}
+
+		void Remove(const std::size_t series) {
+			for (auto& tier : tiers_) tier.RemoveSeries(series);
+
+			index_.erase(keys_[series]);
+			if (series + 1 != keys_.size()) {
+				keys_[series] = std::move(keys_.back());
+				index_[keys_[series]] = series;
+			}
+
+			keys_.pop_back();
+		}
+
+		/**
+		 * \brief Calls a function for every non-empty bucket of a series that overlaps a window ending now,
+		 * oldest first, in the finest tier that spans the window.
+		 */
+		template <typename F>
+		void ForEachBucket(
+			const std::wstring_view query,
+			const std::wstring_view instance,
+			const std::wstring_view property,
+			const std::chrono::steady_clock::duration window,
+			const std::chrono::steady_clock::time_point now,
+			F&& callback) const {
+			thread_local std::wstring key;
+			MakeKey(key, query, instance, property);
+			const auto series = Find(key);
+			if (!series) return;
+
+			const auto* tier = &tiers_.back();
+			for (const auto& candidate : tiers_) {
+				if (candidate.resolution * static_cast<std::int64_t>(candidate.capacity) >= window) {
+					tier = &candidate;
+					break;
+				}
+			}
+
+			const auto begin = now - window;
+			const auto base = *series * tier->capacity;
+			const auto head = tier->heads[*series];
+			for (std::size_t i = tier->capacity; i-- > 0;) {
+				const auto slot = base + (head + tier->capacity - i) % tier->capacity;
+				if (tier->counts[slot] == 0) continue;
+
+				const std::chrono::steady_clock::time_point end(tier->resolution * (tier->buckets[slot] + 1));
+				if (end > begin) callback(*tier, slot);
+			}
+		}
+	};
+} // namespace wmipp
+
+#endif // SD_WMIPP_TIMESERIES_HXX
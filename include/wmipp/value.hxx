@@ -0,0 +1,502 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_VALUE_HXX
+#define SD_WMIPP_VALUE_HXX
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <OleAuto.h>
+#endif
+
+namespace wmipp
+{
+	/**
+	 * \brief The CIM types of WMI properties, with the same values as the CIMTYPE_ENUMERATION of Wbemidl.h.
+	 */
+	enum class CimType : std::uint16_t {
+		Empty = 0,
+		SInt16 = 2,
+		SInt32 = 3,
+		Real32 = 4,
+		Real64 = 5,
+		String = 8,
+		Boolean = 11,
+		Object = 13,
+		SInt8 = 16,
+		UInt8 = 17,
+		UInt16 = 18,
+		UInt32 = 19,
+		SInt64 = 20,
+		UInt64 = 21,
+		DateTime = 101,
+		Reference = 102,
+		Char16 = 103,
+		Illegal = 0xfff,
+		FlagArray = 0x2000,
+	};
+
+	/**
+	 * \brief A compact, type-erased property value tagged with its CIM type.
+	 * Values occupy 16 bytes. Numbers and booleans are stored inline, and so are strings short enough
+	 * to fit in the 12 bytes of payload. Longer strings are either borrowed (a view into memory owned
+	 * by someone else, such as the BSTR of a VARIANT that outlives the Value), owned, or, on Windows,
+	 * adopted BSTRs taken over from a VARIANT without copying. Arrays own their elements.
+	 * \note Embedded objects are not represented: their Value is null, but keeps the CimType::Object tag.
+	 */
+	class Value {
+	public:
+		Value() noexcept = default;
+		Value(std::nullptr_t) noexcept {}
+
+		/**
+		 * \brief Creates a numeric or boolean value, tagged with the CIM type matching T.
+		 */
+		template <typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+		Value(const T value) noexcept : storage_(kScalar) {
+			if constexpr (std::is_same_v<T, bool>) {
+				type_ = static_cast<std::uint16_t>(CimType::Boolean);
+				StoreScalar<std::uint64_t>(value ? 1 : 0);
+			}
+			else if constexpr (std::is_floating_point_v<T>) {
+				type_ = static_cast<std::uint16_t>(sizeof(T) == 4 ? CimType::Real32 : CimType::Real64);
+				StoreScalar<double>(static_cast<double>(value));
+			}
+			else if constexpr (std::is_signed_v<T>) {
+				constexpr CimType kTypes[] = {CimType::SInt8, CimType::SInt16, CimType::SInt32, CimType::SInt64};
+				type_ = static_cast<std::uint16_t>(kTypes[SizeIndex<T>()]);
+				StoreScalar<std::int64_t>(value);
+			}
+			else {
+				constexpr CimType kTypes[] = {CimType::UInt8, CimType::UInt16, CimType::UInt32, CimType::UInt64};
+				type_ = static_cast<std::uint16_t>(kTypes[SizeIndex<T>()]);
+				StoreScalar<std::uint64_t>(value);
+			}
+		}
+
+		/**
+		 * \brief Creates a string value owning a copy of the text.
+		 */
+		explicit Value(const std::wstring_view text, const CimType type = CimType::String)
+				: type_(static_cast<std::uint16_t>(type)) {
+			AssignString(text);
+		}
+
+		/**
+		 * \brief Creates a string value that refers to the text without copying it.
+		 * The text must outlive the value and all of its copies; use ToOwned to detach from it.
+		 */
+		[[nodiscard]] static Value Borrow(const std::wstring_view text, const CimType type = CimType::String) noexcept {
+			Value value;
+			value.type_ = static_cast<std::uint16_t>(type);
+			value.storage_ = kBorrowed;
+			value.StorePointer(text.data(), text.size());
+			return value;
+		}
+
+		/**
+		 * \brief Creates an array value owning the given elements.
+		 * \param elements The elements of the array.
+		 * \param element_type The CIM type of the elements.
+		 */
+		[[nodiscard]] static Value Array(std::vector<Value> elements, const CimType element_type) {
+			Value value;
+			value.type_ = static_cast<std::uint16_t>(element_type) | static_cast<std::uint16_t>(CimType::FlagArray);
+			value.storage_ = kArray;
+
+			auto* data = new Value[elements.size()];
+			std::move(elements.begin(), elements.end(), data);
+			value.StorePointer(data, elements.size());
+			return value;
+		}
+
+		/**
+		 * \brief Creates a null value tagged with a CIM type.
+		 */
+		[[nodiscard]] static Value Null(const CimType type) noexcept {
+			Value value;
+			value.type_ = static_cast<std::uint16_t>(type);
+			return value;
+		}
+
+#if defined(_WIN32)
+		/**
+		 * \brief Creates a string value that takes ownership of a BSTR, which is freed with the value.
+		 */
+		[[nodiscard]] static Value AdoptBstr(BSTR text, const CimType type = CimType::String) noexcept {
+			Value value;
+			value.type_ = static_cast<std::uint16_t>(type);
+			if (text == nullptr) return value;
+
+			value.storage_ = kBstr;
+			value.StorePointer(text, SysStringLen(text));
+			return value;
+		}
+#endif
+
+		Value(const Value& other) {
+			CopyFrom(other);
+		}
+
+		Value& operator=(const Value& other) {
+			if (this != &other) {
+				Release();
+				CopyFrom(other);
+			}
+
+			return *this;
+		}
+
+		Value(Value&& other) noexcept {
+			MoveFrom(other);
+		}
+
+		Value& operator=(Value&& other) noexcept {
+			if (this != &other) {
+				Release();
+				MoveFrom(other);
+			}
+
+			return *this;
+		}
+
+		~Value() {
+			Release();
+		}
+
+		/**
+		 * \brief Returns the CIM type tag of the value, including CimType::FlagArray for arrays.
+		 */
+		[[nodiscard]] CimType GetType() const noexcept {
+			return static_cast<CimType>(type_);
+		}
+
+		/**
+		 * \brief Returns the CIM type of the value, or of its elements for arrays.
+		 */
+		[[nodiscard]] CimType GetElementType() const noexcept {
+			return static_cast<CimType>(type_ & ~static_cast<std::uint16_t>(CimType::FlagArray));
+		}
+
+		[[nodiscard]] bool IsNull() const noexcept { return storage_ == kNone; }
+		[[nodiscard]] bool IsArray() const noexcept { return storage_ == kArray; }
+		[[nodiscard]] bool IsString() const noexcept { return storage_ >= kInline && storage_ <= kBstr; }
+
+		/**
+		 * \brief Returns true if the value refers to memory it does not own.
+		 */
+		[[nodiscard]] bool IsBorrowed() const noexcept { return storage_ == kBorrowed; }
+
+		/**
+		 * \brief Returns the value as a boolean. Numbers convert to true when they are not zero.
+		 */
+		[[nodiscard]] std::optional<bool> AsBool() const noexcept {
+			if (storage_ != kScalar) return std::nullopt;
+			if (IsReal()) return LoadScalar<double>() != 0.0;
+			return LoadScalar<std::uint64_t>() != 0;
+		}
+
+		/**
+		 * \brief Returns the value as a signed 64-bit integer.
+		 * Strings holding a decimal integer are parsed, since WMI returns 64-bit integers as strings.
+		 * \return The value, or std::nullopt if it is not an integer or does not fit.
+		 */
+		[[nodiscard]] std::optional<std::int64_t> AsInt64() const noexcept {
+			if (IsString()) return ParseInteger<std::int64_t>(View());
+			if (storage_ != kScalar || IsReal()) return std::nullopt;
+			if (IsUnsigned()) {
+				const auto value = LoadScalar<std::uint64_t>();
+				if (value > static_cast<std::uint64_t>((std::numeric_limits<std::int64_t>::max)())) return std::nullopt;
+				return static_cast<std::int64_t>(value);
+			}
+
+			return LoadScalar<std::int64_t>();
+		}
+
+		/**
+		 * \brief Returns the value as an unsigned 64-bit integer.
+		 * \see AsInt64 for more information.
+		 */
+		[[nodiscard]] std::optional<std::uint64_t> AsUInt64() const noexcept {
+			if (IsString()) return ParseInteger<std::uint64_t>(View());
+			if (storage_ != kScalar || IsReal()) return std::nullopt;
+			if (!IsUnsigned()) {
+				const auto value = LoadScalar<std::int64_t>();
+				if (value < 0) return std::nullopt;
+				return static_cast<std::uint64_t>(value);
+			}
+
+			return LoadScalar<std::uint64_t>();
+		}
+
+		/**
+		 * \brief Returns the value as a double. Integers are converted, and numeric strings are parsed.
+		 */
+		[[nodiscard]] std::optional<double> AsDouble() const noexcept {
+			if (IsString()) {
+				if (const auto integer = AsInt64()) return static_cast<double>(*integer);
+				if (const auto integer = AsUInt64()) return static_cast<double>(*integer);
+				return std::nullopt;
+			}
+
+			if (storage_ != kScalar) return std::nullopt;
+			if (IsReal()) return LoadScalar<double>();
+			if (IsUnsigned()) return static_cast<double>(LoadScalar<std::uint64_t>());
+			return static_cast<double>(LoadScalar<std::int64_t>());
+		}
+
+		/**
+		 * \brief Returns a view of the string held by the value, without copying it.
+		 * \return The view, valid as long as the value (or, if borrowed, the memory it refers to) is alive,
+		 * or std::nullopt if the value is not a string.
+		 */
+		[[nodiscard]] std::optional<std::wstring_view> AsString() const noexcept {
+			if (!IsString()) return std::nullopt;
+			return View();
+		}
+
+		/**
+		 * \brief Returns the number of elements of an array value, or zero for other values.
+		 */
+		[[nodiscard]] std::size_t Size() const noexcept {
+			return IsArray() ? LoadSize() : 0;
+		}
+
+		[[nodiscard]] const Value* begin() const noexcept {
+			return IsArray() ? LoadPointer<Value>() : nullptr;
+		}
+
+		[[nodiscard]] const Value* end() const noexcept {
+			return begin() + Size();
+		}
+
+		/**
+		 * \param index The index of the element to access, which must be less than Size.
+		 */
+		[[nodiscard]] const Value& operator[](const std::size_t index) const noexcept {
+			return begin()[index];
+		}
+
+		/**
+		 * \brief Returns a copy of the value that does not refer to memory it does not own.
+		 */
+		[[nodiscard]] Value ToOwned() const {
+			if (storage_ == kBorrowed) return Value(View(), GetType());
+			if (storage_ != kArray) return *this;
+
+			std::vector<Value> elements;
+			elements.reserve(Size());
+			for (const auto& element : *this) elements.push_back(element.ToOwned());
+			return Array(std::move(elements), GetElementType());
+		}
+
+		/**
+		 * \brief Compares the type tag and the contents of two values. Strings compare case-sensitively,
+		 * and reals numerically, so 0.0 equals -0.0 and NaN equals nothing, not even itself.
+		 */
+		bool operator==(const Value& other) const noexcept {
+			if (type_ != other.type_) return false;
+			if (IsString() && other.IsString()) return View() == other.View();
+			if (storage_ != other.storage_) return false;
+
+			switch (storage_) {
+			case kNone: return true;
+			case kScalar:
+				if (IsReal()) return LoadScalar<double>() == other.LoadScalar<double>();
+				return LoadScalar<std::uint64_t>() == other.LoadScalar<std::uint64_t>();
+			default: return std::equal(begin(), end(), other.begin(), other.end());
+			}
+		}
+
+		bool operator!=(const Value& other) const noexcept {
+			return !(*this == other);
+		}
+
+	private:
+		enum : std::uint8_t {
+			kNone,
+			kScalar,
+			kInline,
+			kBorrowed,
+			kOwned,
+			kBstr,
+			kArray,
+		};
+
+		static constexpr std::size_t kPayloadSize = 12;
+		static constexpr std::size_t kInlineCapacity = kPayloadSize / sizeof(wchar_t);
+
+		alignas(8) unsigned char payload_[kPayloadSize]{};
+		std::uint16_t type_ = static_cast<std::uint16_t>(CimType::Empty);
+		std::uint8_t storage_ = kNone;
+		std::uint8_t inline_size_ = 0;
+
+		template <typename T>
+		static constexpr std::size_t SizeIndex() {
+			return sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3;
+		}
+
+		[[nodiscard]] bool IsReal() const noexcept {
+			const auto type = GetElementType();
+			return type == CimType::Real32 || type == CimType::Real64;
+		}
+
+		[[nodiscard]] bool IsUnsigned() const noexcept {
+			switch (GetElementType()) {
+			case CimType::Boolean:
+			case CimType::UInt8:
+			case CimType::UInt16:
+			case CimType::UInt32:
+			case CimType::UInt64:
+			case CimType::Char16:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		template <typename T>
+		void StoreScalar(const T value) noexcept {
+			std::memcpy(payload_, &value, sizeof(T));
+		}
+
+		template <typename T>
+		[[nodiscard]] T LoadScalar() const noexcept {
+			T value;
+			std::memcpy(&value, payload_, sizeof(T));
+			return value;
+		}
+
+		template <typename T>
+		void StorePointer(T* pointer, const std::size_t size) noexcept {
+			const auto size32 = static_cast<std::uint32_t>(size);
+			std::memcpy(payload_, &pointer, sizeof(pointer));
+			std::memcpy(payload_ + sizeof(pointer), &size32, sizeof(size32));
+		}
+
+		template <typename T>
+		[[nodiscard]] T* LoadPointer() const noexcept {
+			T* pointer;
+			std::memcpy(&pointer, payload_, sizeof(pointer));
+			return pointer;
+		}
+
+		[[nodiscard]] std::size_t LoadSize() const noexcept {
+			std::uint32_t size;
+			std::memcpy(&size, payload_ + sizeof(void*), sizeof(size));
+			return size;
+		}
+
+		[[nodiscard]] std::wstring_view View() const noexcept {
+			if (storage_ == kInline) {
+				return {reinterpret_cast<const wchar_t*>(payload_), inline_size_};
+			}
+
+			return {LoadPointer<const wchar_t>(), LoadSize()};
+		}
+
+		void AssignString(const std::wstring_view text) {
+			if (text.size() <= kInlineCapacity) {
+				storage_ = kInline;
+				inline_size_ = static_cast<std::uint8_t>(text.size());
+				std::memcpy(payload_, text.data(), text.size() * sizeof(wchar_t));
+				return;
+			}
+
+			auto* data = new wchar_t[text.size()];
+			std::memcpy(data, text.data(), text.size() * sizeof(wchar_t));
+			storage_ = kOwned;
+			StorePointer(data, text.size());
+		}
+
+		void CopyFrom(const Value& other) {
+			type_ = other.type_;
+			switch (other.storage_) {
+			case kOwned:
+			case kBstr:
+				AssignString(other.View());
+				break;
+			case kArray: {
+				const auto size = other.Size();
+				auto* data = new Value[size];
+				std::copy(other.begin(), other.end(), data);
+				storage_ = kArray;
+				StorePointer(data, size);
+				break;
+			}
+			default:
+				std::memcpy(payload_, other.payload_, kPayloadSize);
+				storage_ = other.storage_;
+				inline_size_ = other.inline_size_;
+				break;
+			}
+		}
+
+		void MoveFrom(Value& other) noexcept {
+			std::memcpy(payload_, other.payload_, kPayloadSize);
+			type_ = other.type_;
+			storage_ = other.storage_;
+			inline_size_ = other.inline_size_;
+			other.storage_ = kNone;
+		}
+
+		void Release() noexcept {
+			switch (storage_) {
+			case kOwned: delete[] LoadPointer<wchar_t>(); break;
+			case kArray: delete[] LoadPointer<Value>(); break;
+#if defined(_WIN32)
+			case kBstr: SysFreeString(LoadPointer<wchar_t>()); break;
+#endif
+			default: break;
+			}
+
+			storage_ = kNone;
+		}
+
+		template <typename T>
+		static std::optional<T> ParseInteger(const std::wstring_view text) noexcept {
+			if (text.empty()) return std::nullopt;
+
+			const auto negative = text.front() == L'-';
+			if (negative && (std::is_unsigned_v<T> || text.size() == 1)) return std::nullopt;
+
+			std::uint64_t magnitude = 0;
+			for (std::size_t i = negative ? 1 : 0; i < text.size(); ++i) {
+				const auto c = text[i];
+				if (c < L'0' || c > L'9') return std::nullopt;
+
+				const auto digit = static_cast<std::uint64_t>(c - L'0');
+				if (magnitude > ((std::numeric_limits<std::uint64_t>::max)() - digit) / 10) return std::nullopt;
+				magnitude = magnitude * 10 + digit;
+			}
+
+			if constexpr (std::is_signed_v<T>) {
+				const auto limit = static_cast<std::uint64_t>((std::numeric_limits<T>::max)()) + (negative ? 1 : 0);
+				if (magnitude > limit) return std::nullopt;
+				return negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+			}
+			else {
+				return static_cast<T>(magnitude);
+			}
+		}
+	};
+
+	static_assert(sizeof(void*) != 8 || sizeof(Value) == 16, "wmipp::Value is expected to occupy 16 bytes");
+} // namespace wmipp
+
+#endif // SD_WMIPP_VALUE_HXX
@@ -0,0 +1,348 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_WATCHLIST_HXX
+#define SD_WMIPP_WATCHLIST_HXX
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "casefold.hxx"
+#include "columnar.hxx"
+
+namespace wmipp
+{
+	/**
+	 * \brief Where a watchlist pattern must occur in a string.
+	 */
+	enum class WatchKind {
+		Contains,
+		Prefix,
+		Suffix,
+		Exact,
+	};
+
+	struct WatchPattern {
+		std::wstring text;
+		WatchKind kind = WatchKind::Contains;
+	};
+
+	/**
+	 * \brief Matches strings against many patterns at once, case-insensitively, such as process names
+	 * and executable paths against a list of known-bad tools.
+	 * The patterns are compiled into an Aho-Corasick automaton, expanded into a DFA over the characters
+	 * that occur in them (every other character shares a single class), so that each string is scanned
+	 * once with a table lookup per character regardless of the number of patterns. The DFA takes
+	 * 4 bytes per state and character class.
+	 *
+	 * A Watchlist is immutable once built, and can be shared across threads.
+	 */
+	class Watchlist {
+	public:
+		/**
+		 * \brief A fixed-size set of bits, holding either the patterns matched by a string or the rows
+		 * matched by any pattern.
+		 */
+		class Bitmap {
+		public:
+			explicit Bitmap(const std::size_t size = 0) : size_(size), words_((size + 63) / 64) {}
+
+			[[nodiscard]] std::size_t size() const {
+				return size_;
+			}
+
+			[[nodiscard]] bool Test(const std::size_t index) const {
+				return index < size_ && (words_[index / 64] >> (index % 64) & 1) != 0;
+			}
+
+			void Set(const std::size_t index) {
+				if (index < size_) words_[index / 64] |= std::uint64_t{1} << (index % 64);
+			}
+
+			[[nodiscard]] bool Any() const {
+				for (const auto word : words_) {
+					if (word != 0) return true;
+				}
+
+				return false;
+			}
+
+			[[nodiscard]] std::size_t Count() const {
+				std::size_t count = 0;
+				for (auto word : words_) {
+					for (; word != 0; word &= word - 1) ++count;
+				}
+
+				return count;
+			}
+
+			/**
+			 * \brief Returns the bits in 64-bit words, least significant bit first.
+			 */
+			[[nodiscard]] const std::vector<std::uint64_t>& GetWords() const {
+				return words_;
+			}
+
+		private:
+			std::size_t size_;
+			std::vector<std::uint64_t> words_;
+		};
+
+		/**
+		 * \param patterns The patterns, identified by their index in the vector.
+		 * \throws std::invalid_argument if a pattern is empty.
+		 */
+		explicit Watchlist(std::vector<WatchPattern> patterns) : patterns_(std::move(patterns)) {
+			for (auto& pattern : patterns_) {
+				if (pattern.text.empty()) throw std::invalid_argument("Watchlist patterns must not be empty");
+				for (auto& c : pattern.text) c = text::Fold(c);
+			}
+
+			Build();
+		}
+
+		[[nodiscard]] std::size_t PatternCount() const {
+			return patterns_.size();
+		}
+
+		/**
+		 * \brief Returns a pattern, with its text folded to lower case.
+		 * \throws std::out_of_range if the index is out of range.
+		 */
+		[[nodiscard]] const WatchPattern& GetPattern(const std::size_t index) const {
+			return patterns_.at(index);
+		}
+
+		[[nodiscard]] std::size_t StateCount() const {
+			return output_links_.size();
+		}
+
+		/**
+		 * \brief Returns the patterns matched by a string.
+		 */
+		[[nodiscard]] Bitmap Match(const std::wstring_view text) const {
+			Bitmap matches(patterns_.size());
+			Scan(text, [&](const std::size_t pattern) {
+				matches.Set(pattern);
+				return true;
+			});
+			return matches;
+		}
+
+		/**
+		 * \brief Returns true if a string matches any pattern, stopping at the first match.
+		 */
+		[[nodiscard]] bool MatchesAny(const std::wstring_view text) const {
+			auto matched = false;
+			Scan(text, [&](std::size_t) {
+				matched = true;
+				return false;
+			});
+			return matched;
+		}
+
+		/**
+		 * \brief Returns the strings matching any pattern, such as views of the BSTRs of a query result.
+		 */
+		[[nodiscard]] Bitmap MatchRows(const std::vector<std::wstring_view>& texts) const {
+			Bitmap rows(texts.size());
+			for (std::size_t row = 0; row < texts.size(); ++row) {
+				if (MatchesAny(texts[row])) rows.Set(row);
+			}
+
+			return rows;
+		}
+
+		/**
+		 * \brief Returns the rows of a string column matching any pattern. Every distinct string is
+		 * matched once, and nulls never match.
+		 */
+		[[nodiscard]] Bitmap MatchRows(const Column& column) const {
+			std::vector<std::uint8_t> entries(column.DictionarySize());
+			for (std::size_t entry = 0; entry < entries.size(); ++entry) {
+				entries[entry] = MatchesAny(detail::FromUtf8(column.GetDictionaryEntry(entry))) ? 1 : 0;
+			}
+
+			Bitmap rows(column.size());
+			for (std::size_t row = 0; row < column.size(); ++row) {
+				const auto entry = column.GetDictionaryIndex(row);
+				if (entry && entries[*entry] != 0) rows.Set(row);
+			}
+
+			return rows;
+		}
+
+		/**
+		 * \brief Calls a function for every row of a string column and every pattern it matches, in row order.
+		 * Every distinct string is matched once.
+		 * \param callback A function taking the row and pattern indices.
+		 */
+		template <typename F>
+		void ForEachMatch(const Column& column, F&& callback) const {
+			std::vector<std::vector<std::size_t>> entries(column.DictionarySize());
+			std::vector<std::uint8_t> scanned(entries.size());
+			for (std::size_t row = 0; row < column.size(); ++row) {
+				const auto entry = column.GetDictionaryIndex(row);
+				if (!entry) continue;
+
+				if (scanned[*entry] == 0) {
+					const auto matches = Match(detail::FromUtf8(column.GetDictionaryEntry(*entry)));
+					for (std::size_t pattern = 0; pattern < matches.size(); ++pattern) {
+						if (matches.Test(pattern)) entries[*entry].push_back(pattern);
+					}
+
+					scanned[*entry] = 1;
+				}
+
+				for (const auto pattern : entries[*entry]) callback(row, pattern);
+			}
+		}
+
+	private:
+		static constexpr std::uint32_t kNone = (std::numeric_limits<std::uint32_t>::max)();
+
+		std::vector<WatchPattern> patterns_;
+
+		/**
+		 * \brief The character class of every ASCII character, and of the other characters of the patterns.
+		 * Class 0 holds the characters that occur in no pattern.
+		 */
+		std::array<std::uint32_t, 128> ascii_classes_{};
+		std::unordered_map<wchar_t, std::uint32_t> other_classes_;
+		std::size_t class_count_ = 1;
+
+		/**
+		 * \brief The transitions of the DFA, class_count_ per state. State 0 is the root.
+		 */
+		std::vector<std::uint32_t> transitions_;
+
+		/**
+		 * \brief The patterns ending at every state, as ranges of terminals_.
+		 */
+		std::vector<std::uint32_t> terminal_offsets_;
+		std::vector<std::uint32_t> terminals_;
+
+		/**
+		 * \brief The nearest state along the failure links of every state that ends a pattern, or kNone.
+		 */
+		std::vector<std::uint32_t> output_links_;
+
+		[[nodiscard]] std::uint32_t Class(const wchar_t c) const {
+			const auto folded = text::Fold(c);
+			if (static_cast<std::make_unsigned_t<wchar_t>>(folded) < 0x80) return ascii_classes_[static_cast<std::size_t>(folded)];
+
+			const auto it = other_classes_.find(folded);
+			return it == other_classes_.end() ? 0 : it->second;
+		}
+
+		[[nodiscard]] bool IsTerminal(const std::uint32_t state) const {
+			return terminal_offsets_[state] != terminal_offsets_[state + 1];
+		}
+
+		/**
+		 * \brief Runs the DFA over a string, and calls a function for every match until it returns false.
+		 */
+		template <typename F>
+		void Scan(const std::wstring_view text, F&& on_match) const {
+			std::uint32_t state = 0;
+			for (std::size_t i = 0; i < text.size(); ++i) {
+				state = transitions_[state * class_count_ + Class(text[i])];
+				for (auto node = IsTerminal(state) ? state : output_links_[state]; node != kNone; node = output_links_[node]) {
+					for (auto t = terminal_offsets_[node]; t < terminal_offsets_[node + 1]; ++t) {
+						const auto& pattern = patterns_[terminals_[t]];
+						const auto at_start = i + 1 == pattern.text.size();
+						const auto at_end = i + 1 == text.size();
+						const auto anchored = pattern.kind == WatchKind::Contains
+							|| (pattern.kind == WatchKind::Prefix && at_start)
+							|| (pattern.kind == WatchKind::Suffix && at_end)
+							|| (pattern.kind == WatchKind::Exact && at_start && at_end);
+						if (anchored && !on_match(terminals_[t])) return;
+					}
+				}
+			}
+		}
+
+		void Build() {
+			// Assign a class to every distinct character of the patterns.
+			for (const auto& pattern : patterns_) {
+				for (const auto c : pattern.text) {
+					if (static_cast<std::make_unsigned_t<wchar_t>>(c) < 0x80) {
+						auto& slot = ascii_classes_[static_cast<std::size_t>(c)];
+						if (slot == 0) slot = static_cast<std::uint32_t>(class_count_++);
+					}
+					else if (other_classes_.try_emplace(c, static_cast<std::uint32_t>(class_count_)).second) {
+						++class_count_;
+					}
+				}
+			}
+
+			// Insert the patterns into a trie, stored in the transition table. Since no edge of the trie
+			// leads back to the root, 0 marks the missing edges until the DFA is completed.
+			std::vector<std::vector<std::uint32_t>> ends(1);
+			transitions_.assign(class_count_, 0);
+			for (std::size_t p = 0; p < patterns_.size(); ++p) {
+				std::uint32_t state = 0;
+				for (const auto c : patterns_[p].text) {
+					auto& next = transitions_[state * class_count_ + Class(c)];
+					if (next == 0) {
+						next = static_cast<std::uint32_t>(ends.size());
+						ends.emplace_back();
+						transitions_.resize(transitions_.size() + class_count_, 0);
+					}
+
+					state = transitions_[state * class_count_ + Class(c)];
+				}
+
+				ends[state].push_back(static_cast<std::uint32_t>(p));
+			}
+
+			terminal_offsets_.reserve(ends.size() + 1);
+			terminal_offsets_.push_back(0);
+			for (const auto& end : ends) {
+				terminals_.insert(terminals_.end(), end.begin(), end.end());
+				terminal_offsets_.push_back(static_cast<std::uint32_t>(terminals_.size()));
+			}
+
+			// Complete the DFA breadth first: a missing edge leads where the failure state leads.
+			std::vector<std::uint32_t> failures(ends.size(), 0);
+			output_links_.assign(ends.size(), kNone);
+			std::vector<std::uint32_t> queue;
+			for (std::size_t c = 0; c < class_count_; ++c) {
+				if (transitions_[c] != 0) queue.push_back(transitions_[c]);
+			}
+
+			for (std::size_t head = 0; head < queue.size(); ++head) {
+				const auto state = queue[head];
+				const auto failure = failures[state];
+				for (std::size_t c = 0; c < class_count_; ++c) {
+					auto& next = transitions_[state * class_count_ + c];
+					const auto fallback = transitions_[failure * class_count_ + c];
+					if (next == 0) {
+						next = fallback;
+						continue;
+					}
+
+					failures[next] = fallback;
+					output_links_[next] = IsTerminal(fallback) ? fallback : output_links_[fallback];
+					queue.push_back(next);
+				}
+			}
+		}
+	};
+} // namespace wmipp
+
+#endif // SD_WMIPP_WATCHLIST_HXX
@@ -39,8 +39,28 @@
 #ifndef SD_WMIPP_HXX
 #define SD_WMIPP_HXX
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cwctype>
+#include <functional>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
 #include <utility>
 #include <stdexcept>
 #include <vector>
@@ -51,6 +71,21 @@
 #include <comdef.h>
 #include <Wbemidl.h>
 
+#include "capabilities.hxx"
+#include "casefold.hxx"
+#include "columnar.hxx"
+#include "fingerprint.hxx"
+#include "lint.hxx"
+#include "object_path.hxx"
+#include "process_tree.hxx"
+#include "rates.hxx"
+#include "sketches.hxx"
+#include "smbios.hxx"
+#include "timeseries.hxx"
+#include "value.hxx"
+#include "watchlist.hxx"
+#include "wql.hxx"
+
 #pragma comment(lib, "wbemuuid.lib")
 
 namespace wmipp::type_traits
@@ -147,302 +182,3610 @@ namespace wmipp
 	}
 
 	/**
-	 * \brief This class encapsulates a WMI object obtained from a query result.
-	 * It provides a convenient interface to access its properties.
+	 * \brief Converts a VARIANT read from a WMI object into a Value tagged with the property's CIM type.
+	 * Strings are taken over from the variant without being copied, leaving it empty. Since WMI returns
+	 * unsigned integers in signed VARIANT types and 64-bit integers as strings, the CIM type is used to
+	 * restore their actual type.
+	 * \param variant The variant to convert. If it holds a BSTR, the string is moved into the Value.
+	 * \param type The CIM type of the property, or CIM_ILLEGAL to infer it from the variant type.
+	 * \return The converted value. Embedded objects are converted to null values.
 	 */
-	class Object{
-		friend class QueryResult;
+	[[nodiscard]] inline Value MakeValue(VARIANT& variant, const CIMTYPE type = CIM_ILLEGAL) {
+		const auto base_type = static_cast<VARTYPE>(variant.vt & VT_TYPEMASK);
 
-	protected:
-		Object(std::shared_ptr<const Interface> iface, CComPtr<IWbemClassObject> object)
-			: iface_(std::move(iface)), object_(std::move(object)) {}
+		// The CIM types of the scalar VARIANT types share their values.
+		const auto cim_type = static_cast<CimType>(type == CIM_ILLEGAL
+			? ((variant.vt & VT_ARRAY) != 0 ? CIM_FLAG_ARRAY : 0) | base_type
+			: type);
+		const auto element_type = static_cast<CimType>(
+			static_cast<std::uint16_t>(cim_type) & ~static_cast<std::uint16_t>(CimType::FlagArray));
 
-	public:
-		/**
-		 * \brief This function retrieves the value of the property with the given name from the WMI object.
-		 * The value is converted to the specified type, and if the conversion fails, std::nullopt is returned.
-		 * \tparam T The type of the property value to retrieve.
-		 * \param name The name of the property to retrieve, specified as a wide string view.
-		 * \return std::optional containing the retrieved property value, or std::nullopt if retrieval fails.
-		 * \note Certain type conversions may throw asserts in debug mode if the conversion is not possible.
-		 */
-		template <typename T = variant_t>
-		[[nodiscard]] std::optional<T> GetProperty(const std::wstring_view name) const {
-			CComVariant variant;
-			const auto result = object_->Get(
-				name.data(),
-				0,
-				&variant,
-				nullptr,
-				nullptr);
-			if (FAILED(result)) {
-				return std::nullopt;
+		// Converts an integer read from a (possibly reinterpreted) VARIANT to the width and signedness
+		// of its CIM type.
+		const auto make_integer = [&](const std::int64_t raw) -> Value {
+			switch (element_type) {
+			case CimType::UInt8: return static_cast<std::uint8_t>(raw);
+			case CimType::UInt16:
+			case CimType::Char16: return static_cast<std::uint16_t>(raw);
+			case CimType::UInt32: return static_cast<std::uint32_t>(raw);
+			case CimType::UInt64: return static_cast<std::uint64_t>(raw);
+			case CimType::SInt8: return static_cast<std::int8_t>(raw);
+			case CimType::SInt16: return static_cast<std::int16_t>(raw);
+			case CimType::SInt64: return raw;
+			case CimType::Boolean: return raw != 0;
+			default: return static_cast<std::int32_t>(raw);
 			}
+		};
 
-			// Only perform the variant type conversion if a return type other than variant_t
-			// is specified.
-			if constexpr (std::is_same_v<T, variant_t>) {
-				return variant;
+		const auto make_string = [&](const std::wstring_view text) -> Value {
+			if (element_type == CimType::SInt64) {
+				if (const auto number = Value::Borrow(text).AsInt64()) return *number;
+			}
+			else if (element_type == CimType::UInt64) {
+				if (const auto number = Value::Borrow(text).AsUInt64()) return *number;
+			}
+
+			return Value(text, element_type);
+		};
+
+		// Reads the element at the given address, which has the base type of the variant.
+		const auto make_element = [&](const void* data) -> Value {
+			switch (base_type) {
+			case VT_BSTR: {
+				const auto text = *static_cast<const BSTR*>(data);
+				return make_string({text, text != nullptr ? SysStringLen(text) : 0});
+			}
+			case VT_BOOL: return *static_cast<const VARIANT_BOOL*>(data) != 0;
+			case VT_R4: return *static_cast<const float*>(data);
+			case VT_R8: return *static_cast<const double*>(data);
+			case VT_I1: return make_integer(*static_cast<const char*>(data));
+			case VT_UI1: return make_integer(*static_cast<const unsigned char*>(data));
+			case VT_I2: return make_integer(*static_cast<const short*>(data));
+			case VT_UI2: return make_integer(*static_cast<const unsigned short*>(data));
+			case VT_I4:
+			case VT_INT: return make_integer(*static_cast<const LONG*>(data));
+			case VT_UI4:
+			case VT_UINT: return make_integer(*static_cast<const ULONG*>(data));
+			case VT_I8: return make_integer(*static_cast<const LONGLONG*>(data));
+			case VT_UI8: return make_integer(static_cast<std::int64_t>(*static_cast<const ULONGLONG*>(data)));
+			default: return Value::Null(element_type);
 			}
+		};
 
-			return ConvertVariant<T>(variant);
+		if (variant.vt == VT_NULL || variant.vt == VT_EMPTY) return Value::Null(cim_type);
+
+		if ((variant.vt & VT_ARRAY) != 0) {
+			if (variant.parray == nullptr) return Value::Null(cim_type);
+
+			LONG lower = 0, upper = -1;
+			SafeArrayGetLBound(variant.parray, 1, &lower);
+			SafeArrayGetUBound(variant.parray, 1, &upper);
+
+			void* raw = nullptr;
+			if (FAILED(SafeArrayAccessData(variant.parray, &raw))) return Value::Null(cim_type);
+			const auto* data = static_cast<const unsigned char*>(raw);
+
+			const auto element_size = SafeArrayGetElemsize(variant.parray);
+			std::vector<Value> elements;
+			elements.reserve(static_cast<std::size_t>(upper - lower + 1));
+			for (LONG i = 0; i <= upper - lower; ++i) {
+				elements.push_back(make_element(data + static_cast<std::size_t>(i) * element_size));
+			}
+
+			SafeArrayUnaccessData(variant.parray);
+			return Value::Array(std::move(elements), element_type);
+		}
+
+		if (variant.vt == VT_BSTR) {
+			if (element_type == CimType::SInt64 || element_type == CimType::UInt64) {
+				return make_element(&variant.bstrVal);
+			}
+
+			// Take the string over instead of copying it.
+			auto value = Value::AdoptBstr(variant.bstrVal, element_type);
+			variant.vt = VT_EMPTY;
+			variant.bstrVal = nullptr;
+			return value;
 		}
 
+		return make_element(&variant.llVal);
+	}
+
+	/**
+	 * \brief How the objects of a streamed query are retrieved from the enumerator.
+	 */
+	enum class Strategy {
 		/**
-		 * \brief Equality operator overload to compare Objects.
-		 * Comparison ignores the objects source (the server and the namespace they
-		 * were retrieved from) and all qualifiers.
-		 * \param other The Object to compare with.
-		 * \return true if the Objects are equal, false otherwise.
+		 * \brief Let the Interface pick the strategy and batch size from the statistics it collected
+		 * about the queried class in past executions.
+		 * \see Interface::PlanQuery for more information.
 		 */
-		bool operator==(const Object& other) const {
-			if (object_ == nullptr && other.object_ == nullptr) return true;
-			if (object_ == nullptr || other.object_ == nullptr) return false;
-			return object_->CompareTo(
-				WBEM_FLAG_IGNORE_OBJECT_SOURCE | WBEM_FLAG_IGNORE_QUALIFIERS,
-				other.object_) == WBEM_S_SAME;
-		}
+		Auto,
 
 		/**
-		 * \brief Inequality operator overload to compare Objects.
- 		 * Comparison ignores the objects source (the server and the namespace they
-		 * were retrieved from) and all qualifiers.
-		 * \param other The Object to compare with.
-		 * \return true if the Objects are not equal, false otherwise.
+		 * \brief Drain the whole result on the first access and release the enumerator.
+		 * This minimizes the number of round trips and is best for small results.
 		 */
-		bool operator!=(const Object& other) const {
-			return !(*this == other);
-		}
+		Materialize,
 
-	private:
-		std::shared_ptr<const Interface> iface_;
-		CComPtr<IWbemClassObject> object_;
+		/**
+		 * \brief Retrieve the objects in batches as they are consumed.
+		 * This keeps memory bounded and is best for large results.
+		 */
+		Stream,
 	};
 
 	/**
-	 * \brief Encapsulates a collection of objects obtained from a query operation. 
-	 * It provides methods to access and retrieve properties from the objects in a convenient manner.
-	 * The class supports iterating over the objects using range-based for loops.
+	 * \brief Execution statistics collected by an Interface about a single class.
+	 * All averages are exponentially weighted, so that recent executions count the most.
 	 */
-	class QueryResult{
-		friend class Interface;
-
-	protected:
-		QueryResult(std::shared_ptr<const Interface> iface, const CComPtr<IEnumWbemClassObject>& enumerator)
-				: iface_(std::move(iface)) {
-			if (enumerator) PopulateObjects(enumerator);
-		}
-
-	public:
+	struct ClassStatistics {
 		/**
-		 * \brief Finds and retrieves the value of a specific property in the populated objects by name.
-		 * If the property is found and its type matches the provided template type T, the value is returned.
-		 * \see Object::GetProperty for more information.
-		 * \tparam T The type of the property to retrieve.
-		 * \param name The name of the property to retrieve.
-		 * \return An optional value containing the property value if found, or an empty optional if not found.
+		 * \brief The number of complete executions the statistics are based on.
 		 */
-		template <typename T = variant_t>
-		[[nodiscard]] std::optional<T> GetProperty(const std::wstring_view name) const {
-			for (const Object& obj : *this) {
-				if (auto value = obj.GetProperty<T>(name)) {
-					return value;
-				}
-			}
-
-			return std::nullopt;
-		}
+		std::uint64_t executions = 0;
 
 		/**
-		 * \brief Retrieves the value of a specific property in the object at the specified index by name.
-		 * If the property is found and its type matches the provided template type T, the value is returned.
-		 * \see Object::GetProperty for more information.
-		 * \tparam T The type of the property to retrieve.
-		 * \param name The name of the property to retrieve.
-		 * \param index The index of the object in the objects vector to retrieve the property from.
-		 * \return An optional value containing the property value exists, or an empty optional if not found.
+		 * \brief The average number of objects returned by a query.
 		 */
-		template <typename T = variant_t>
-		[[nodiscard]] std::optional<T> GetProperty(const std::wstring_view name, const std::size_t index) const {
-			if (index >= Count()) return std::nullopt;
-			return GetAt(index).GetProperty<T>(name);
-		}
+		double rows = 0.0;
 
 		/**
-		 * \brief Returns the number of objects in the result.
+		 * \brief The average estimated size of the property values of an object, in bytes.
 		 */
-		[[nodiscard]] std::size_t Count() const {
-			return objects_.size();
-		}
+		double bytes_per_row = 0.0;
 
 		/**
-		 * \param index The index of the object to access.
-		 * \return A const reference to the object at the specified index.
-		 * \throws std::out_of_range if the index is out of range.
+		 * \brief The average time spent executing and enumerating a query, per returned object, in seconds.
 		 */
-		[[nodiscard]] const Object& GetAt(const std::size_t index) const {
-			return objects_.at(index);
-		}
+		double seconds_per_row = 0.0;
 
 		/**
-		 * \param index The index of the object to access.
-		 * \return A const reference to the object at the specified index.
-		 * \throws std::out_of_range if the index is out of range.
+		 * \brief The fraction of executions whose result differed from the previous one.
+		 * When both results were fingerprinted (see QueryOptions::fingerprint) and come from the same query,
+		 * they are compared by fingerprint; otherwise a result is considered different when its object
+		 * count changed.
 		 */
-		const Object& operator[](const std::size_t index) const {
-			return GetAt(index);
-		}
+		double change_rate = 0.0;
+	};
 
-		[[nodiscard]] std::vector<Object>::const_iterator begin() const {
-			return objects_.begin();
-		}
+	/**
+	 * \brief The strategy and batch size chosen to execute a streamed query.
+	 */
+	struct QueryPlan {
+		Strategy strategy = Strategy::Stream;
+		ULONG batch_size = 32;
 
-		[[nodiscard]] std::vector<Object>::const_iterator end() const {
-			return objects_.end();
-		}
+		/**
+		 * \brief True if the plan was derived from collected statistics rather than defaults.
+		 */
+		bool from_statistics = false;
+	};
 
-	private:
-		std::shared_ptr<const Interface> iface_;
-		std::vector<Object> objects_;
+	/**
+	 * \brief What happens to a string value longer than its SizeCap when it is converted.
+	 */
+	enum class OversizePolicy {
+		/**
+		 * \brief Keep the first max_length characters of the value, or one less if the last of them would
+		 * be the first half of a surrogate pair.
+		 */
+		Truncate,
 
 		/**
-		 * \brief Fills the objects vector by iterating over the given enumerator.
-		 * We do this here so that we don't need to clone the enumerator and wrap it into it's own ::enumerator.
-		 * Each retrieved IWbemClassObject is wrapped in an Object and added to the objects vector.
-		 * \param enumerator A pointer to the IEnumWbemClassObject enumerator.
+		 * \brief Replace the value with the 32 hexadecimal digits of its Fingerprint, which still tells
+		 * different values apart. Caps shorter than 32 keep only the first max_length digits, so that
+		 * values never grow past their cap, at the cost of more collisions.
 		 */
-		void PopulateObjects(const CComPtr<IEnumWbemClassObject>& enumerator) {
-			while (true) {
-				ULONG returned_count = 0;
-				CComPtr<IWbemClassObject> object = nullptr;
-				const auto result = enumerator->Next(
-					WBEM_INFINITE,
-					1,
-					&object,
-					&returned_count);
-				if (FAILED(result) || returned_count == 0) {
-					break;
-				}
+		Hash,
 
-				objects_.emplace_back(Object(iface_, object));
-			}
-		}
+		/**
+		 * \brief Convert the value as null.
+		 */
+		Skip,
 	};
 
 	/**
-	 * \brief Manages a connection to the WMI service and provides a convenient interface
-	 * to query WMI objects.
-	 * This class also handles COM initialization and cleanup.
+	 * \brief A cap on the length of the string values of a property.
 	 */
-	class Interface : public std::enable_shared_from_this<const Interface> {
-	public:
+	struct SizeCap {
 		/**
-		 * Initializes the COM library and creates a connection to the WMI service.
-		 * \param path The path to the WMI namespace to connect to.
-		 * \throws wmipp::Exception if the COM library fails to initialize or the connection
-		 * to the WMI service fails.
+		 * \brief The longest value kept as it is, in UTF-16 code units.
 		 */
-		static std::shared_ptr<Interface> Create(std::string_view path = "cimv2");
-
-		Interface(const Interface& other) = default;
-		Interface& operator=(const Interface& other) = default;
+		std::size_t max_length = 0;
 
-		Interface(Interface&& other) noexcept = delete;
-		Interface& operator=(Interface&& other) noexcept = delete;
+		OversizePolicy policy = OversizePolicy::Truncate;
+	};
 
+	/**
+	 * \brief Options controlling how a streamed query is executed.
+	 */
+	struct QueryOptions {
 		/**
-		 * \brief Executes a WQL query and returns the result.
-		 * \param query The WQL query to execute.
-		 * \return A QueryResult instance containing the result of the query.
-		 * \throws wmipp::Exception if the query fails to execute.
+		 * \brief If true, the query is executed without WBEM_FLAG_FORWARD_ONLY, so that the cursor
+		 * can be reset and cloned. The enumerator then retains every object it returns until it is
+		 * released, which costs as much memory as a materialized QueryResult.
 		 */
-		[[nodiscard]] QueryResult ExecuteQuery(const std::wstring_view query) const {
-			CComPtr<IEnumWbemClassObject> enumerator;
-			const auto result = services_->ExecQuery(
-				bstr_t("WQL"),
-				bstr_t(query.data()),
-				WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY,
-				nullptr,
-				&enumerator);
-			if (FAILED(result)) {
-				throw Exception("Failed to execute WQL query");
-			}
+		bool rewindable = false;
 
-			return {shared_from_this(), enumerator};
-		}
+		/**
+		 * \brief The number of objects requested from the enumerator on each call to Next.
+		 */
+		ULONG batch_size = 32;
 
-	private:
-		struct MakeSharedEnabler;
+		/**
+		 * \brief How the objects are retrieved from the enumerator. With Strategy::Auto, both the
+		 * strategy and batch_size are chosen by the Interface.
+		 */
+		Strategy strategy = Strategy::Stream;
 
-		CComPtr<IWbemLocator> locator_;
-		CComPtr<IWbemServices> services_;
+		/**
+		 * \brief If true, an ExecutionReport is collected while the query is executed and its
+		 * objects are converted. It can be retrieved with GetReport on the result.
+		 */
+		bool report = false;
 
-		explicit Interface(const std::string_view path) {
-			auto result = CoInitializeEx(nullptr, 0);
-			if (FAILED(result)) throw Exception("Failed to initialize the COM library");
+		/**
+		 * \brief If true, a Fingerprint of the property values of the objects is computed while they
+		 * are retrieved from the enumerator. It can be retrieved with GetFingerprint on the result, and
+		 * also makes the change rate in the statistics of the queried class exact. Fingerprinted queries
+		 * are never batched (see Interface::EnableBatching), so that their fingerprint only covers the
+		 * properties they selected.
+		 */
+		bool fingerprint = false;
 
-			result = CoCreateInstance(
-				CLSID_WbemLocator,
-				nullptr,
-				CLSCTX_INPROC_SERVER,
-				IID_IWbemLocator,
-				reinterpret_cast<LPVOID*>(&locator_));
-			if (FAILED(result)) {
-				CoUninitialize();
-				throw Exception("Failed to create WbemLocator object");
-			}
+		/**
+		 * \brief If true, the query is analyzed with Interface::Lint before it is executed, and a
+		 * wmipp::Exception is thrown instead if any finding is an error. Meant for debug builds and tests.
+		 */
+		bool lint = false;
 
-			result = locator_->ConnectServer(
-				bstr_t(R"(\\.\root\)") + bstr_t(path.data()),
-				nullptr,
-				nullptr,
-				nullptr,
-				0,
-				nullptr,
-				nullptr,
-				&services_);
-			if (FAILED(result)) {
-				CoUninitialize();
-				throw Exception("Could not connect to WMI service");
-			}
+		/**
+		 * \brief The cap applied to the strings and string arrays of every property when they are
+		 * converted by Object::GetProperty, so that the memory of converted values stays bounded.
+		 * Reading a property as variant_t returns its raw value, which is never capped.
+		 * \see Object::IsOversized to tell which values exceeded their cap.
+		 */
+		std::optional<SizeCap> size_cap = std::nullopt;
 
-			result = CoSetProxyBlanket(
-				services_,
-				RPC_C_AUTHN_DEFAULT,
-				RPC_C_AUTHZ_NONE,
-				COLE_DEFAULT_PRINCIPAL,
-				RPC_C_AUTHN_LEVEL_DEFAULT,
-				RPC_C_IMP_LEVEL_IMPERSONATE,
-				nullptr,
-				EOAC_NONE);
-			if (FAILED(result)) {
-				CoUninitialize();
-				throw Exception("Could not set proxy blanket");
-			}
-		}
+		/**
+		 * \brief Caps of specific properties, which take precedence over size_cap.
+		 * Property names are compared case-insensitively.
+		 */
+		std::vector<std::pair<std::wstring, SizeCap>> property_caps{};
 
 		/**
-		 * \brief Uninitializes the COM library and releases the WMI service connection.
-		 * \note This function should never be called manually, as the lifetime of the
-		 * instances of this class is automatically managed by std::shared_ptr.
+		 * \brief The component the cost of the query is attributed to in TagAccounting.
+		 * If empty, the tag of the ScopedTag active on the calling thread is used.
 		 */
-		~Interface() {
-			if (services_) services_.Release();
-			if (locator_) locator_.Release();
-			CoUninitialize();
-		}
+		std::wstring tag{};
 	};
 
 	/**
-	 * \see https://stackoverflow.com/questions/8147027/how-do-i-call-stdmake-shared-on-a-class-with-only-protected-or-private-const/8147213#8147213
+	 * \brief Describes how a query was executed, to make tuning decisions data-driven.
+	 * \see Interface::Explain for more information.
 	 */
-	struct Interface::MakeSharedEnabler : Interface {
-		template <typename... Args>
-		explicit MakeSharedEnabler(Args&&... args) : Interface(std::forward<Args>(args)...) {}
-	};
+	struct ExecutionReport {
+		/**
+		 * \brief The WQL text that was sent to WMI, after filter pushdown and batching.
+		 */
+		std::wstring query;
+
+		Strategy strategy = Strategy::Materialize;
+		ULONG batch_size = 0;
+
+		/**
+		 * \brief True if the strategy and batch size were planned from collected statistics.
+		 */
+		bool from_statistics = false;
+
+		/**
+		 * \brief True if part of a filter could not be pushed down and was evaluated locally.
+		 */
+		bool local_filter = false;
+
+		/**
+		 * \brief The number of queries that shared this execution through micro-batching.
+		 * A value greater than one means that the query joined, or was joined by, other queries.
+		 */
+		std::size_t batch_members = 1;
+
+		/**
+		 * \brief The number of calls to IEnumWbemClassObject::Next and the objects they returned.
+		 */
+		std::uint64_t next_calls = 0;
+		std::uint64_t rows = 0;
+
+		/**
+		 * \brief The time spent waiting for the connection to the namespace, which is only non-zero
+		 * for lazy Interfaces that were not connected yet.
+		 */
+		std::chrono::nanoseconds connect_time{};
+		std::chrono::nanoseconds execute_time{};
+		std::chrono::nanoseconds enumeration_time{};
+
+		/**
+		 * \brief The time spent in Object::GetProperty, along with the number of calls and the
+		 * approximate number of bytes of the values they read.
+		 */
+		std::chrono::nanoseconds conversion_time{};
+		std::uint64_t conversions = 0;
+		std::uint64_t bytes_converted = 0;
+
+		/**
+		 * \brief The number of conversions whose value exceeded its size cap.
+		 * \see QueryOptions::size_cap
+		 */
+		std::uint64_t capped_values = 0;
+
+		/**
+		 * \brief Formats the report as human-readable text, one field per line.
+		 */
+		[[nodiscard]] std::wstring ToString() const {
+			static constexpr const wchar_t* kStrategies[] = {L"Auto", L"Materialize", L"Stream"};
+			const auto milliseconds = [](const std::chrono::nanoseconds duration) {
+				return std::to_wstring(std::chrono::duration<double, std::milli>(duration).count()) + L" ms";
+			};
+
+			std::wstring result;
+			result += L"query: " + query + L"\n";
+			result += L"strategy: " + std::wstring(kStrategies[static_cast<int>(strategy)]);
+			result += from_statistics ? L" (planned)\n" : L"\n";
+			result += L"batch size: " + std::to_wstring(batch_size) + L"\n";
+			result += L"local filter: " + std::wstring(local_filter ? L"yes" : L"no") + L"\n";
+			result += L"batch members: " + std::to_wstring(batch_members) + L"\n";
+			result += L"next calls: " + std::to_wstring(next_calls) + L"\n";
+			result += L"rows: " + std::to_wstring(rows) + L"\n";
+			result += L"connect: " + milliseconds(connect_time) + L"\n";
+			result += L"execute: " + milliseconds(execute_time) + L"\n";
+			result += L"enumeration: " + milliseconds(enumeration_time) + L"\n";
+			result += L"conversion: " + milliseconds(conversion_time);
+			result += L" (" + std::to_wstring(conversions) + L" calls, " + std::to_wstring(bytes_converted) + L" bytes)\n";
+			result += L"capped values: " + std::to_wstring(capped_values) + L"\n";
+			return result;
+		}
+	};
+
+	namespace detail
+	{
+		/**
+		 * \brief The state behind an ExecutionReport, shared by a result and its objects.
+		 * Conversions may happen concurrently on different objects, so their counters are atomic.
+		 */
+		struct ExecutionTrace {
+			ExecutionReport report;
+
+			std::atomic<std::uint64_t> conversions = 0;
+			std::atomic<std::uint64_t> conversion_nanoseconds = 0;
+			std::atomic<std::uint64_t> bytes_converted = 0;
+			std::atomic<std::uint64_t> capped_values = 0;
+
+			void RecordConversion(const std::chrono::steady_clock::time_point start, const std::size_t bytes) {
+				const auto elapsed = std::chrono::steady_clock::now() - start;
+				conversions.fetch_add(1, std::memory_order_relaxed);
+				conversion_nanoseconds.fetch_add(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+					std::memory_order_relaxed);
+				bytes_converted.fetch_add(bytes, std::memory_order_relaxed);
+			}
+
+			/**
+			 * \brief Times a call to IEnumWbemClassObject::Next that returned the given number of objects.
+			 */
+			void RecordNext(const std::chrono::steady_clock::time_point start, const ULONG returned_count) {
+				report.enumeration_time += std::chrono::steady_clock::now() - start;
+				++report.next_calls;
+				report.rows += returned_count;
+			}
+
+			[[nodiscard]] ExecutionReport Snapshot() const {
+				auto snapshot = report;
+				snapshot.conversions = conversions.load(std::memory_order_relaxed);
+				snapshot.conversion_time = std::chrono::nanoseconds(conversion_nanoseconds.load(std::memory_order_relaxed));
+				snapshot.bytes_converted = bytes_converted.load(std::memory_order_relaxed);
+				snapshot.capped_values = capped_values.load(std::memory_order_relaxed);
+				return snapshot;
+			}
+		};
+
+		/**
+		 * \brief The size caps of a query, shared by its objects.
+		 */
+		struct SizeCaps {
+			std::optional<SizeCap> all;
+			std::vector<std::pair<std::wstring, SizeCap>> properties;
+
+			/**
+			 * \brief Returns the caps of the options, or nullptr if they have none.
+			 */
+			static std::shared_ptr<const SizeCaps> From(const QueryOptions& options) {
+				if (!options.size_cap && options.property_caps.empty()) return nullptr;
+				return std::make_shared<const SizeCaps>(SizeCaps{options.size_cap, options.property_caps});
+			}
+
+			/**
+			 * \brief Returns the cap of a property, or nullptr if it is not capped.
+			 */
+			[[nodiscard]] const SizeCap* Find(const std::wstring_view name) const {
+				for (const auto& [property, cap] : properties) {
+					if (wql::EqualsIgnoreCase(property, name)) return &cap;
+				}
+
+				return all ? &*all : nullptr;
+			}
+		};
+
+		/**
+		 * \brief Copies the strings of a SAFEARRAY of BSTRs, such as the names returned by
+		 * IWbemClassObject::GetNames, and destroys the array.
+		 */
+		inline std::vector<std::wstring> TakeStringArray(SAFEARRAY* array) {
+			std::vector<std::wstring> result;
+			if (array == nullptr) return result;
+
+			LONG lower = 0, upper = -1;
+			SafeArrayGetLBound(array, 1, &lower);
+			SafeArrayGetUBound(array, 1, &upper);
+
+			BSTR* data = nullptr;
+			if (SUCCEEDED(SafeArrayAccessData(array, reinterpret_cast<void**>(&data)))) {
+				result.reserve(static_cast<std::size_t>(upper - lower + 1));
+				for (LONG i = 0; i <= upper - lower; ++i) {
+					result.emplace_back(data[i], SysStringLen(data[i]));
+				}
+				SafeArrayUnaccessData(array);
+			}
+
+			// Destroying the array frees its strings as well.
+			SafeArrayDestroy(array);
+			return result;
+		}
+	} // namespace detail
+
+	/**
+	 * \brief Counts how properties are read through Object::GetProperty, per class, property and target type.
+	 * Profiling is disabled by default; when disabled, the only cost on GetProperty is a relaxed atomic load.
+	 * When enabled, each call additionally reads the __CLASS of the object and updates one of a set of sharded
+	 * counters, so that threads converting objects concurrently rarely contend on the same lock.
+	 * The properties of each profiled class are registered the first time the class is seen, so that the
+	 * report can list the properties that are never read, which are candidates for projection pruning.
+	 */
+	class PropertyProfiler {
+	public:
+		/**
+		 * \brief The accumulated counters of a (class, property, target type) triple.
+		 */
+		struct Entry {
+			std::wstring class_name;
+			std::wstring property;
+
+			/**
+			 * \brief The name of the type the property was converted to, as reported by std::type_info.
+			 */
+			std::string type;
+
+			std::uint64_t calls = 0;
+
+			/**
+			 * \brief Calls where the property could not be read, or its value could not be converted.
+			 */
+			std::uint64_t failures = 0;
+
+			/**
+			 * \brief Calls where the property was NULL.
+			 */
+			std::uint64_t nulls = 0;
+
+			std::chrono::nanoseconds time{};
+		};
+
+		/**
+		 * \brief A property of a profiled class that was never read.
+		 */
+		struct UnreadProperty {
+			std::wstring class_name;
+			std::wstring property;
+		};
+
+		struct Report {
+			/**
+			 * \brief The most expensive entries, by cumulative time.
+			 */
+			std::vector<Entry> hottest;
+
+			/**
+			 * \brief The properties of the profiled classes that were never read, sorted by class.
+			 */
+			std::vector<UnreadProperty> unread;
+		};
+
+		enum class Outcome {
+			Success,
+			Failure,
+			Null,
+		};
+
+		/**
+		 * \brief Returns the process-wide profiler used by Object::GetProperty.
+		 */
+		static PropertyProfiler& Global() {
+			static PropertyProfiler profiler;
+			return profiler;
+		}
+
+		static void Enable() { enabled_.store(true, std::memory_order_relaxed); }
+		static void Disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+		[[nodiscard]] static bool IsEnabled() {
+			return enabled_.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * \brief Accumulates a property read.
+		 * \return true if the class had not been seen before, in which case its properties should be
+		 * registered with RegisterProperties.
+		 */
+		bool Record(
+			const std::wstring_view class_name,
+			const std::wstring_view property,
+			const std::type_info& type,
+			const std::chrono::nanoseconds elapsed,
+			const Outcome outcome) {
+			auto key = MakeKey(class_name, property);
+			auto& shard = shards_[ShardIndex()];
+
+			auto first_seen = false;
+			{
+				const std::lock_guard lock(shard.mutex);
+				auto it = shard.entries.find({key, type});
+				if (it == shard.entries.end()) {
+					Entry entry;
+					entry.class_name = class_name;
+					entry.property = property;
+					entry.type = type.name();
+					it = shard.entries.emplace(TypedKey{std::move(key), type}, std::move(entry)).first;
+				}
+
+				auto& entry = it->second;
+				++entry.calls;
+				entry.failures += outcome == Outcome::Failure;
+				entry.nulls += outcome == Outcome::Null;
+				entry.time += elapsed;
+
+				first_seen = shard.classes.insert(MakeKey(class_name, {})).second;
+			}
+
+			if (!first_seen) return false;
+
+			// The class is new to this shard; check whether another shard registered it already.
+			const std::lock_guard lock(classes_mutex_);
+			return classes_.find(MakeKey(class_name, {})) == classes_.end();
+		}
+
+		/**
+		 * \brief Registers the properties of a class, so that the ones never read can be reported.
+		 */
+		void RegisterProperties(const std::wstring_view class_name, std::vector<std::wstring> properties) {
+			const std::lock_guard lock(classes_mutex_);
+			classes_.emplace(MakeKey(class_name, {}), RegisteredClass{std::wstring(class_name), std::move(properties)});
+		}
+
+		/**
+		 * \brief Merges the counters of all shards into a report.
+		 * \param top The maximum number of entries to include in Report::hottest.
+		 */
+		[[nodiscard]] Report GetReport(const std::size_t top = 20) const {
+			std::unordered_map<TypedKey, Entry, KeyHash> merged;
+			std::unordered_set<std::wstring> read;
+			for (auto& shard : shards_) {
+				const std::lock_guard lock(shard.mutex);
+				for (const auto& [key, entry] : shard.entries) {
+					read.insert(key.name);
+
+					const auto [it, inserted] = merged.emplace(key, entry);
+					if (inserted) continue;
+
+					it->second.calls += entry.calls;
+					it->second.failures += entry.failures;
+					it->second.nulls += entry.nulls;
+					it->second.time += entry.time;
+				}
+			}
+
+			Report report;
+			report.hottest.reserve(merged.size());
+			for (auto& [key, entry] : merged) report.hottest.push_back(std::move(entry));
+
+			std::sort(report.hottest.begin(), report.hottest.end(), [](const Entry& a, const Entry& b) {
+				return a.time > b.time;
+			});
+			if (report.hottest.size() > top) report.hottest.resize(top);
+
+			const std::lock_guard lock(classes_mutex_);
+			for (const auto& [key, registered] : classes_) {
+				for (const auto& property : registered.properties) {
+					if (read.count(MakeKey(registered.name, property)) == 0) {
+						report.unread.push_back({registered.name, property});
+					}
+				}
+			}
+
+			std::sort(report.unread.begin(), report.unread.end(), [](const UnreadProperty& a, const UnreadProperty& b) {
+				return a.class_name != b.class_name ? a.class_name < b.class_name : a.property < b.property;
+			});
+			return report;
+		}
+
+		/**
+		 * \brief Discards all counters and registered classes.
+		 */
+		void Reset() {
+			for (auto& shard : shards_) {
+				const std::lock_guard lock(shard.mutex);
+				shard.entries.clear();
+				shard.classes.clear();
+			}
+
+			const std::lock_guard lock(classes_mutex_);
+			classes_.clear();
+		}
+
+	private:
+		static constexpr std::size_t kShards = 16;
+
+		struct TypedKey {
+			/**
+			 * \brief The lower-case class and property names, separated by a dot.
+			 */
+			std::wstring name;
+			std::type_index type;
+
+			bool operator==(const TypedKey& other) const {
+				return type == other.type && name == other.name;
+			}
+		};
+
+		struct KeyHash {
+			std::size_t operator()(const TypedKey& key) const {
+				return std::hash<std::wstring>{}(key.name) ^ (key.type.hash_code() * 31);
+			}
+		};
+
+		struct Shard {
+			mutable std::mutex mutex;
+			std::unordered_map<TypedKey, Entry, KeyHash> entries;
+
+			/**
+			 * \brief The classes this shard has seen, to only consult the registered classes once per shard.
+			 */
+			std::unordered_set<std::wstring> classes;
+		};
+
+		struct RegisteredClass {
+			std::wstring name;
+			std::vector<std::wstring> properties;
+		};
+
+		inline static std::atomic<bool> enabled_ = false;
+
+		std::array<Shard, kShards> shards_;
+
+		mutable std::mutex classes_mutex_;
+		std::unordered_map<std::wstring, RegisteredClass> classes_;
+
+		static std::wstring MakeKey(const std::wstring_view class_name, const std::wstring_view property) {
+			std::wstring key;
+			key.reserve(class_name.size() + property.size() + 1);
+			for (const auto c : class_name) key += static_cast<wchar_t>(std::towlower(c));
+			key += L'.';
+			for (const auto c : property) key += static_cast<wchar_t>(std::towlower(c));
+			return key;
+		}
+
+		/**
+		 * \brief Spreads threads over the shards, assigning each thread its shard once.
+		 */
+		static std::size_t ShardIndex() {
+			static std::atomic<std::size_t> next = 0;
+			thread_local const auto index = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+			return index;
+		}
+	};
+
+	/**
+	 * \brief Attributes the cost of queries to the components that issued them, so that load on the WMI
+	 * provider host can be traced back to its cause.
+	 * Queries are tagged with QueryOptions::tag, or else with the ScopedTag active on the thread that issues
+	 * them, and their costs are aggregated per tag. Untagged queries are accounted under an empty tag.
+	 */
+	class TagAccounting {
+	public:
+		/**
+		 * \brief The accumulated costs of a tag.
+		 */
+		struct Entry {
+			std::wstring tag;
+
+			/**
+			 * \brief The number of executed queries, and how many of them failed to execute.
+			 */
+			std::uint64_t queries = 0;
+			std::uint64_t failures = 0;
+
+			/**
+			 * \brief The number of objects returned, and their estimated size in bytes.
+			 */
+			std::uint64_t rows = 0;
+			std::uint64_t bytes = 0;
+
+			/**
+			 * \brief The time the tagged callers spent blocked in the library, executing queries and fetching
+			 * their objects.
+			 */
+			std::chrono::nanoseconds time{};
+
+			/**
+			 * \brief The time spent waiting for the WMI service, in IWbemServices::ExecQuery and
+			 * IEnumWbemClassObject::Next. When batched queries share an execution, it is split between them.
+			 */
+			std::chrono::nanoseconds provider_time{};
+		};
+
+		/**
+		 * \brief Returns the process-wide accounting used by every Interface.
+		 */
+		static TagAccounting& Global() {
+			static TagAccounting accounting;
+			return accounting;
+		}
+
+		/**
+		 * \brief Returns the tag of the innermost ScopedTag active on the calling thread, or an empty string.
+		 */
+		[[nodiscard]] static std::wstring_view CurrentTag() {
+			return ThreadTag();
+		}
+
+		/**
+		 * \brief Adds a cost to the entry of its tag.
+		 */
+		void Record(const Entry& cost) {
+			const std::lock_guard lock(mutex_);
+			auto& entry = entries_[cost.tag];
+			entry.queries += cost.queries;
+			entry.failures += cost.failures;
+			entry.rows += cost.rows;
+			entry.bytes += cost.bytes;
+			entry.time += cost.time;
+			entry.provider_time += cost.provider_time;
+		}
+
+		/**
+		 * \brief Splits a cost evenly between the given tags, one share per occurrence of a tag.
+		 * The tag of the cost is ignored.
+		 */
+		void Record(const std::vector<std::wstring>& tags, const Entry& cost) {
+			if (tags.empty()) return;
+
+			const auto count = tags.size();
+			for (std::size_t i = 0; i < count; ++i) {
+				// The remainders of the integer divisions go to the first share.
+				const auto share = [&](const std::uint64_t total) {
+					return total / count + (i == 0 ? total % count : 0);
+				};
+
+				Entry part;
+				part.tag = tags[i];
+				part.queries = share(cost.queries);
+				part.failures = share(cost.failures);
+				part.rows = share(cost.rows);
+				part.bytes = share(cost.bytes);
+				part.time = std::chrono::nanoseconds(share(static_cast<std::uint64_t>(cost.time.count())));
+				part.provider_time = std::chrono::nanoseconds(share(static_cast<std::uint64_t>(cost.provider_time.count())));
+				Record(part);
+			}
+		}
+
+		/**
+		 * \brief Returns the entry of a tag, or std::nullopt if no query was attributed to it.
+		 */
+		[[nodiscard]] std::optional<Entry> GetEntry(const std::wstring_view tag) const {
+			const std::lock_guard lock(mutex_);
+			const auto it = entries_.find(std::wstring(tag));
+			if (it == entries_.end()) return std::nullopt;
+
+			auto entry = it->second;
+			entry.tag = it->first;
+			return entry;
+		}
+
+		/**
+		 * \brief Returns the entries of all tags, from the highest to the lowest provider time.
+		 */
+		[[nodiscard]] std::vector<Entry> GetEntries() const {
+			std::vector<Entry> entries;
+			{
+				const std::lock_guard lock(mutex_);
+				entries.reserve(entries_.size());
+				for (const auto& [tag, entry] : entries_) {
+					entries.push_back(entry);
+					entries.back().tag = tag;
+				}
+			}
+
+			std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+				return a.provider_time > b.provider_time;
+			});
+			return entries;
+		}
+
+		/**
+		 * \brief Discards the entries of all tags.
+		 */
+		void Reset() {
+			const std::lock_guard lock(mutex_);
+			entries_.clear();
+		}
+
+	private:
+		friend class ScopedTag;
+
+		mutable std::mutex mutex_;
+		std::unordered_map<std::wstring, Entry> entries_;
+
+		static std::wstring_view& ThreadTag() {
+			thread_local std::wstring_view tag;
+			return tag;
+		}
+	};
+
+	/**
+	 * \brief Tags the queries issued by the current thread for as long as it lives.
+	 * Guards nest: the innermost one wins, and the previous tag is restored when it is destroyed.
+	 * \see TagAccounting
+	 */
+	class ScopedTag {
+	public:
+		explicit ScopedTag(std::wstring tag) : tag_(std::move(tag)), previous_(TagAccounting::ThreadTag()) {
+			TagAccounting::ThreadTag() = tag_;
+		}
+
+		~ScopedTag() {
+			TagAccounting::ThreadTag() = previous_;
+		}
+
+		ScopedTag(const ScopedTag& other) = delete;
+		ScopedTag& operator=(const ScopedTag& other) = delete;
+
+	private:
+		std::wstring tag_;
+		std::wstring_view previous_;
+	};
+
+	/**
+	 * \brief The bytes of a uint8[] property, read without copying them element by element.
+	 * The Blob owns the array returned by WMI and keeps it locked, so its data stays valid for as long
+	 * as the Blob lives, independently of the Object it was read from.
+	 */
+	class Blob {
+		friend class Object;
+
+	public:
+		Blob(const Blob& other) = delete;
+		Blob& operator=(const Blob& other) = delete;
+
+		Blob(Blob&& other) noexcept
+			: array_(std::exchange(other.array_, nullptr)), data_(other.data_), size_(other.size_) {}
+
+		Blob& operator=(Blob&& other) noexcept {
+			if (this != &other) {
+				Release();
+				array_ = std::exchange(other.array_, nullptr);
+				data_ = other.data_;
+				size_ = other.size_;
+			}
+
+			return *this;
+		}
+
+		~Blob() {
+			Release();
+		}
+
+		[[nodiscard]] const std::byte* data() const {
+			return data_;
+		}
+
+		[[nodiscard]] std::size_t size() const {
+			return size_;
+		}
+
+		[[nodiscard]] bool empty() const {
+			return size_ == 0;
+		}
+
+		[[nodiscard]] const std::byte* begin() const {
+			return data_;
+		}
+
+		[[nodiscard]] const std::byte* end() const {
+			return data_ + size_;
+		}
+
+		const std::byte& operator[](const std::size_t index) const {
+			return data_[index];
+		}
+
+	private:
+		SAFEARRAY* array_ = nullptr;
+		const std::byte* data_ = nullptr;
+		std::size_t size_ = 0;
+
+		/**
+		 * \brief Takes ownership of a one-dimensional array of bytes and locks it.
+		 */
+		explicit Blob(SAFEARRAY* array) : array_(array) {
+			LONG lower = 0, upper = -1;
+			SafeArrayGetLBound(array_, 1, &lower);
+			SafeArrayGetUBound(array_, 1, &upper);
+
+			void* data = nullptr;
+			if (SUCCEEDED(SafeArrayAccessData(array_, &data))) {
+				data_ = static_cast<const std::byte*>(data);
+				size_ = static_cast<std::size_t>(upper - lower + 1);
+			}
+		}
+
+		void Release() {
+			if (array_ == nullptr) return;
+			if (data_ != nullptr) SafeArrayUnaccessData(array_);
+			SafeArrayDestroy(array_);
+			array_ = nullptr;
+		}
+	};
+
+	/**
+	 * \brief This class encapsulates a WMI object obtained from a query result.
+	 * It provides a convenient interface to access its properties.
+	 */
+	class Object{
+		friend class QueryResult;
+		friend class QueryCursor;
+
+	protected:
+		Object(
+			std::shared_ptr<const Interface> iface,
+			CComPtr<IWbemClassObject> object,
+			std::shared_ptr<detail::ExecutionTrace> trace = nullptr,
+			std::shared_ptr<const detail::SizeCaps> caps = nullptr)
+			: iface_(std::move(iface)), object_(std::move(object)), trace_(std::move(trace)), caps_(std::move(caps)) {}
+
+	public:
+		/**
+		 * \brief This function retrieves the value of the property with the given name from the WMI object.
+		 * The value is converted to the specified type, and if the conversion fails, std::nullopt is returned.
+		 * \tparam T The type of the property value to retrieve.
+		 * \param name The name of the property to retrieve, specified as a wide string view.
+		 * \return std::optional containing the retrieved property value, or std::nullopt if retrieval fails.
+		 * \note Certain type conversions may throw asserts in debug mode if the conversion is not possible.
+		 */
+		template <typename T = Value>
+		[[nodiscard]] std::optional<T> GetProperty(const std::wstring_view name) const {
+			const auto profiling = PropertyProfiler::IsEnabled();
+			const auto start = trace_ != nullptr || profiling
+				? std::chrono::steady_clock::now()
+				: std::chrono::steady_clock::time_point{};
+
+			CComVariant variant;
+			CIMTYPE type = CIM_ILLEGAL;
+			const auto result = object_->Get(
+				name.data(),
+				0,
+				&variant,
+				&type,
+				nullptr);
+			if (SUCCEEDED(result) && IsHidden(name)) {
+				variant.Clear();
+				variant.vt = VT_NULL;
+			}
+
+			// Caps bound the memory of converted values; variant_t reads the raw value and is never capped.
+			auto capped = false;
+			if constexpr (!std::is_same_v<T, variant_t>) {
+				if (caps_ != nullptr && SUCCEEDED(result)) capped = ApplyCap(name, variant);
+			}
+
+			// Inspect the variant before converting it, since a Value takes its string over.
+			const auto is_null = SUCCEEDED(result) && (variant.vt == VT_NULL || variant.vt == VT_EMPTY);
+			const auto size = trace_ != nullptr && SUCCEEDED(result) ? VariantSize(variant) : 0;
+
+			// Only perform the variant type conversion if a return type other than variant_t
+			// is specified.
+			std::optional<T> value;
+			if (SUCCEEDED(result)) {
+				if constexpr (std::is_same_v<T, variant_t>) {
+					value = variant;
+				}
+				else if constexpr (std::is_same_v<T, Value>) {
+					value = MakeValue(variant, type);
+				}
+				else {
+					value = ConvertVariant<T>(variant);
+				}
+			}
+
+			if (trace_ != nullptr) {
+				trace_->RecordConversion(start, size);
+				if (capped) trace_->capped_values.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			if (profiling) {
+				auto outcome = PropertyProfiler::Outcome::Success;
+				if (is_null) {
+					outcome = PropertyProfiler::Outcome::Null;
+				}
+				else if (!value) {
+					outcome = PropertyProfiler::Outcome::Failure;
+				}
+
+				Profile(name, typeid(T), start, outcome);
+			}
+
+			return value;
+		}
+
+		/**
+		 * \brief Retrieves the value of a uint8[] (or sint8[]) property as a Blob, without copying its
+		 * bytes into a container.
+		 * \see smbios::Table to decode MSSmBios_RawSMBiosTables.SMBiosData in the root\WMI namespace.
+		 * \param name The name of the property to retrieve.
+		 * \return The bytes of the property, or std::nullopt if it is null or not a byte array.
+		 */
+		[[nodiscard]] std::optional<Blob> GetBlob(const std::wstring_view name) const {
+			const auto profiling = PropertyProfiler::IsEnabled();
+			const auto start = trace_ != nullptr || profiling
+				? std::chrono::steady_clock::now()
+				: std::chrono::steady_clock::time_point{};
+
+			CComVariant variant;
+			const auto result = object_->Get(name.data(), 0, &variant, nullptr, nullptr);
+			if (SUCCEEDED(result) && IsHidden(name)) {
+				variant.Clear();
+				variant.vt = VT_NULL;
+			}
+			const auto is_null = SUCCEEDED(result) && (variant.vt == VT_NULL || variant.vt == VT_EMPTY);
+
+			std::optional<Blob> blob;
+			if (SUCCEEDED(result) && (variant.vt == (VT_ARRAY | VT_UI1) || variant.vt == (VT_ARRAY | VT_I1)) &&
+				variant.parray != nullptr && SafeArrayGetDim(variant.parray) == 1) {
+				// The blob takes the array over from the variant.
+				blob = Blob(variant.parray);
+				variant.vt = VT_EMPTY;
+			}
+
+			if (trace_ != nullptr) trace_->RecordConversion(start, blob ? blob->size() : 0);
+			if (profiling) {
+				auto outcome = PropertyProfiler::Outcome::Success;
+				if (is_null) {
+					outcome = PropertyProfiler::Outcome::Null;
+				}
+				else if (!blob) {
+					outcome = PropertyProfiler::Outcome::Failure;
+				}
+
+				Profile(name, typeid(Blob), start, outcome);
+			}
+
+			return blob;
+		}
+
+		/**
+		 * \brief Equality operator overload to compare Objects.
+		 * Comparison ignores the objects source (the server and the namespace they
+		 * were retrieved from) and all qualifiers.
+		 * \param other The Object to compare with.
+		 * \return true if the Objects are equal, false otherwise.
+		 */
+		bool operator==(const Object& other) const {
+			if (object_ == nullptr && other.object_ == nullptr) return true;
+			if (object_ == nullptr || other.object_ == nullptr) return false;
+			return object_->CompareTo(
+				WBEM_FLAG_IGNORE_OBJECT_SOURCE | WBEM_FLAG_IGNORE_QUALIFIERS,
+				other.object_) == WBEM_S_SAME;
+		}
+
+		/**
+		 * \brief Inequality operator overload to compare Objects.
+ 		 * Comparison ignores the objects source (the server and the namespace they
+		 * were retrieved from) and all qualifiers.
+		 * \param other The Object to compare with.
+		 * \return true if the Objects are not equal, false otherwise.
+		 */
+		bool operator!=(const Object& other) const {
+			return !(*this == other);
+		}
+
+		/**
+		 * \brief Computes a Fingerprint of the names, CIM types and values of the object's non-system properties.
+		 * Properties that were not selected by the query are null, so the fingerprint only reflects the
+		 * projected values. Embedded objects are fingerprinted recursively.
+		 * Like EstimatedSize, this walks every property of the object.
+		 */
+		[[nodiscard]] Fingerprint GetFingerprint() const {
+			detail::Hasher hasher;
+			HashObject(hasher, object_, projection_.get());
+			return hasher.Finish();
+		}
+
+		/**
+		 * \brief Returns the names of the object's non-system properties, in the order of the class definition.
+		 */
+		[[nodiscard]] std::vector<std::wstring> GetPropertyNames() const {
+			SAFEARRAY* names = nullptr;
+			if (object_ == nullptr ||
+				FAILED(object_->GetNames(nullptr, WBEM_FLAG_ALWAYS | WBEM_FLAG_NONSYSTEM_ONLY, nullptr, &names))) {
+				return {};
+			}
+
+			return detail::TakeStringArray(names);
+		}
+
+		/**
+		 * \brief Returns the object path of the object, from its __PATH or __RELPATH system property.
+		 * The path is only available if the query selected every key of the class.
+		 * \see ObjectPath::Parse to read its class and keys.
+		 * \param relative Whether to return the path relative to its namespace, without server and namespace.
+		 * \return The path, or std::nullopt if the object has none.
+		 */
+		[[nodiscard]] std::optional<std::wstring> GetPath(const bool relative = false) const {
+			CComVariant variant;
+			if (object_ == nullptr ||
+				FAILED(object_->Get(relative ? L"__RELPATH" : L"__PATH", 0, &variant, nullptr, nullptr)) ||
+				variant.vt != VT_BSTR) {
+				return std::nullopt;
+			}
+
+			return std::wstring(variant.bstrVal, SysStringLen(variant.bstrVal));
+		}
+
+		/**
+		 * \brief Returns true if the value of a property exceeds its size cap, in which case GetProperty
+		 * returns it truncated, hashed or null, depending on the policy of the cap.
+		 * \see QueryOptions::size_cap
+		 */
+		[[nodiscard]] bool IsOversized(const std::wstring_view name) const {
+			const auto cap = caps_ != nullptr ? caps_->Find(name) : nullptr;
+			if (cap == nullptr || IsHidden(name)) return false;
+
+			CComVariant variant;
+			return SUCCEEDED(object_->Get(name.data(), 0, &variant, nullptr, nullptr)) && Oversized(variant, cap->max_length);
+		}
+
+		/**
+		 * \brief Approximates the number of bytes held by the values of the object's non-system properties.
+		 * This walks every property of the object, so it is meant for occasional accounting, not hot loops.
+		 * \return The estimated payload size in bytes, or zero if the properties cannot be enumerated.
+		 */
+		[[nodiscard]] std::size_t EstimatedSize() const {
+			if (object_ == nullptr) return 0;
+			if (FAILED(object_->BeginEnumeration(WBEM_FLAG_NONSYSTEM_ONLY))) return 0;
+
+			std::size_t size = 0;
+			while (true) {
+				BSTR name = nullptr;
+				CComVariant variant;
+				if (object_->Next(0, &name, &variant, nullptr, nullptr) != WBEM_S_NO_ERROR) {
+					break;
+				}
+
+				size += IsHidden(std::wstring_view(name, SysStringLen(name))) ? sizeof(VARIANT) : VariantSize(variant);
+				SysFreeString(name);
+			}
+
+			object_->EndEnumeration();
+			return size;
+		}
+
+	private:
+		std::shared_ptr<const Interface> iface_;
+		CComPtr<IWbemClassObject> object_;
+		std::shared_ptr<detail::ExecutionTrace> trace_;
+		std::shared_ptr<const detail::SizeCaps> caps_;
+
+		/**
+		 * \brief The properties selected by the query of the object, if it was retrieved by a larger batched
+		 * query. The others read as null, as they would had the query been executed on its own.
+		 * \see Interface::EnableBatching
+		 */
+		std::shared_ptr<const std::vector<std::wstring>> projection_;
+
+		/**
+		 * \brief Returns true if a property was not selected by the query of the object. System properties
+		 * are always visible.
+		 */
+		[[nodiscard]] bool IsHidden(const std::wstring_view name) const {
+			return IsHidden(projection_.get(), name);
+		}
+
+		static bool IsHidden(const std::vector<std::wstring>* projection, const std::wstring_view name) {
+			if (projection == nullptr || name.substr(0, 2) == L"__") return false;
+			return std::none_of(projection->begin(), projection->end(), [&](const std::wstring& selected) {
+				return wql::EqualsIgnoreCase(selected, name);
+			});
+		}
+
+		/**
+		 * \brief Applies the cap of a property to its value, in place.
+		 * \return true if the value exceeded the cap.
+		 */
+		bool ApplyCap(const std::wstring_view name, CComVariant& variant) const {
+			const auto cap = caps_->Find(name);
+			if (cap == nullptr || !Oversized(variant, cap->max_length)) return false;
+
+			if (cap->policy == OversizePolicy::Skip) {
+				variant.Clear();
+				variant.vt = VT_NULL;
+				return true;
+			}
+
+			const auto shrink = [&](BSTR& text) {
+				if (text == nullptr || SysStringLen(text) <= cap->max_length) return;
+
+				BSTR replacement = nullptr;
+				if (cap->policy == OversizePolicy::Truncate) {
+					// Do not keep the high surrogate of a pair whose low surrogate is cut off.
+					auto length = cap->max_length;
+					if (length > 0 && text[length - 1] >= 0xD800 && text[length - 1] <= 0xDBFF) --length;
+					replacement = SysAllocStringLen(text, static_cast<UINT>(length));
+				}
+				else {
+					detail::Hasher hasher;
+					hasher.Update(std::wstring_view(text, SysStringLen(text)));
+					const auto digest = hasher.Finish().ToString();
+					replacement = SysAllocStringLen(digest.c_str(), static_cast<UINT>((std::min)(digest.size(), cap->max_length)));
+				}
+
+				SysFreeString(text);
+				text = replacement;
+			};
+
+			if (variant.vt == VT_BSTR) shrink(variant.bstrVal);
+			else ForEachString(variant.parray, shrink);
+			return true;
+		}
+
+		/**
+		 * \brief Returns true if the variant holds a string, or an array with a string, longer than max_length.
+		 */
+		static bool Oversized(const VARIANT& variant, const std::size_t max_length) {
+			if (variant.vt == VT_BSTR) return variant.bstrVal != nullptr && SysStringLen(variant.bstrVal) > max_length;
+			if (variant.vt != (VT_ARRAY | VT_BSTR) || variant.parray == nullptr) return false;
+
+			auto oversized = false;
+			ForEachString(variant.parray, [&](const BSTR& text) {
+				oversized |= text != nullptr && SysStringLen(text) > max_length;
+			});
+			return oversized;
+		}
+
+		/**
+		 * \brief Calls the function on each element of a SAFEARRAY of BSTRs.
+		 */
+		template <typename Function>
+		static void ForEachString(SAFEARRAY* array, Function&& function) {
+			LONG lower = 0, upper = -1;
+			SafeArrayGetLBound(array, 1, &lower);
+			SafeArrayGetUBound(array, 1, &upper);
+
+			BSTR* data = nullptr;
+			if (FAILED(SafeArrayAccessData(array, reinterpret_cast<void**>(&data)))) return;
+			for (LONG i = 0; i <= upper - lower; ++i) function(data[i]);
+			SafeArrayUnaccessData(array);
+		}
+
+		/**
+		 * \brief Appends the values of the given properties to a table, as a single row.
+		 * \param row A buffer reused across calls to avoid reallocating it for every object.
+		 */
+		void AppendTo(ColumnarTable& table, const std::vector<std::wstring>& properties, std::vector<Value>& row) const {
+			row.clear();
+			for (const auto& property : properties) {
+				row.push_back(GetProperty<Value>(property).value_or(Value()));
+			}
+
+			table.AppendRow(row);
+		}
+
+		/**
+		 * \brief Reports a property read to the global PropertyProfiler, registering the properties
+		 * of the object's class the first time it is seen.
+		 */
+		void Profile(
+			const std::wstring_view name,
+			const std::type_info& type,
+			const std::chrono::steady_clock::time_point start,
+			const PropertyProfiler::Outcome outcome) const {
+			const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+			CComVariant class_name;
+			if (FAILED(object_->Get(L"__CLASS", 0, &class_name, nullptr, nullptr)) || class_name.vt != VT_BSTR) {
+				return;
+			}
+
+			const std::wstring_view class_view(class_name.bstrVal, SysStringLen(class_name.bstrVal));
+			auto& profiler = PropertyProfiler::Global();
+			if (!profiler.Record(class_view, name, type, elapsed, outcome)) return;
+
+			profiler.RegisterProperties(class_view, GetPropertyNames());
+		}
+
+		/**
+		 * \brief Feeds the non-system properties of a WMI object into the hasher.
+		 * \param projection The properties selected by the query of the object, if they are a subset of
+		 * those it holds. The others are hashed as nulls.
+		 */
+		static void HashObject(
+			detail::Hasher& hasher,
+			IWbemClassObject* object,
+			const std::vector<std::wstring>* projection = nullptr) {
+			if (object == nullptr || FAILED(object->BeginEnumeration(WBEM_FLAG_NONSYSTEM_ONLY))) {
+				hasher.Update(std::uint64_t{0});
+				return;
+			}
+
+			while (true) {
+				BSTR name = nullptr;
+				CComVariant variant;
+				CIMTYPE type = CIM_ILLEGAL;
+				if (object->Next(0, &name, &variant, &type, nullptr) != WBEM_S_NO_ERROR) {
+					break;
+				}
+
+				const std::wstring_view name_view(name, SysStringLen(name));
+				if (IsHidden(projection, name_view)) {
+					variant.Clear();
+					variant.vt = VT_NULL;
+				}
+
+				hasher.Update(name_view);
+				hasher.Update(static_cast<std::uint64_t>(type));
+				HashVariant(hasher, variant);
+				SysFreeString(name);
+			}
+
+			object->EndEnumeration();
+		}
+
+		/**
+		 * \brief Feeds the type and the value of a VARIANT into the hasher.
+		 */
+		static void HashVariant(detail::Hasher& hasher, const VARIANT& variant) {
+			const auto base_type = static_cast<VARTYPE>(variant.vt & VT_TYPEMASK);
+			hasher.Update(static_cast<std::uint64_t>(variant.vt));
+
+			const auto hash_string = [&](const BSTR text) {
+				hasher.Update(std::wstring_view(text, text != nullptr ? SysStringLen(text) : 0));
+			};
+
+			const auto hash_object = [&](IUnknown* unknown) {
+				CComQIPtr<IWbemClassObject> object(unknown);
+				HashObject(hasher, object);
+			};
+
+			if ((variant.vt & VT_ARRAY) != 0) {
+				if (variant.parray == nullptr) return;
+
+				LONG lower = 0, upper = -1;
+				SafeArrayGetLBound(variant.parray, 1, &lower);
+				SafeArrayGetUBound(variant.parray, 1, &upper);
+				const auto count = static_cast<std::size_t>(upper - lower + 1);
+				hasher.Update(count);
+
+				void* data = nullptr;
+				if (FAILED(SafeArrayAccessData(variant.parray, &data))) return;
+				if (base_type == VT_BSTR) {
+					for (std::size_t i = 0; i < count; ++i) hash_string(static_cast<const BSTR*>(data)[i]);
+				}
+				else if (base_type == VT_UNKNOWN) {
+					for (std::size_t i = 0; i < count; ++i) hash_object(static_cast<IUnknown* const*>(data)[i]);
+				}
+				else {
+					// Arrays of scalars are hashed as a single block of memory.
+					hasher.Update(data, count * SafeArrayGetElemsize(variant.parray));
+				}
+
+				SafeArrayUnaccessData(variant.parray);
+				return;
+			}
+
+			switch (base_type) {
+			case VT_EMPTY:
+			case VT_NULL: break;
+			case VT_BSTR: hash_string(variant.bstrVal); break;
+			case VT_UNKNOWN: hash_object(variant.punkVal); break;
+			case VT_I1:
+			case VT_UI1: hasher.Update(&variant.bVal, 1); break;
+			case VT_I2:
+			case VT_UI2:
+			case VT_BOOL: hasher.Update(&variant.iVal, 2); break;
+			case VT_I4:
+			case VT_UI4:
+			case VT_INT:
+			case VT_UINT:
+			case VT_R4: hasher.Update(&variant.lVal, 4); break;
+			default: hasher.Update(&variant.llVal, 8); break;
+			}
+		}
+
+		/**
+		 * \brief Returns the approximate number of bytes occupied by a VARIANT and the data it owns.
+		 */
+		static std::size_t VariantSize(const VARIANT& variant) {
+			std::size_t size = sizeof(VARIANT);
+			if ((variant.vt & VT_ARRAY) != 0) {
+				if (variant.parray == nullptr) return size;
+
+				LONG lower = 0, upper = -1;
+				SafeArrayGetLBound(variant.parray, 1, &lower);
+				SafeArrayGetUBound(variant.parray, 1, &upper);
+				const auto count = static_cast<std::size_t>(upper - lower + 1);
+				size += count * SafeArrayGetElemsize(variant.parray);
+
+				// String arrays own one BSTR per element on top of the pointer array.
+				if ((variant.vt & VT_TYPEMASK) == VT_BSTR) {
+					BSTR* data = nullptr;
+					if (SUCCEEDED(SafeArrayAccessData(variant.parray, reinterpret_cast<void**>(&data)))) {
+						for (std::size_t i = 0; i < count; ++i) {
+							if (data[i] != nullptr) size += SysStringByteLen(data[i]);
+						}
+						SafeArrayUnaccessData(variant.parray);
+					}
+				}
+			}
+			else if (variant.vt == VT_BSTR && variant.bstrVal != nullptr) {
+				size += SysStringByteLen(variant.bstrVal);
+			}
+
+			return size;
+		}
+	};
+
+	/**
+	 * \brief The comparison operators a Filter can apply to a property.
+	 */
+	enum class Comparison {
+		Equal,
+		NotEqual,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+
+		/**
+		 * \brief Matches a string property against a WQL LIKE pattern.
+		 */
+		Like,
+
+		/**
+		 * \brief Matches an embedded object property whose class is, or derives from, the given class.
+		 */
+		Isa,
+	};
+
+	/**
+	 * \brief A client-side predicate over the objects of a query.
+	 * Filters are built from property comparisons, combined with &&, || and !, and may contain
+	 * arbitrary callbacks. When a filtered query is executed, every part of the filter that WQL can
+	 * express is pushed down into the WHERE clause of the query, so that only the residual part
+	 * (the callbacks, and whatever they are combined with through || and !) is evaluated locally.
+	 * \see Property for a convenient way to build comparisons.
+	 */
+	struct FilteredQuery;
+
+	class Filter {
+	public:
+		using Value = std::variant<std::nullptr_t, bool, std::int64_t, double, std::wstring>;
+
+		/**
+		 * \brief Creates a filter comparing a property with a constant value.
+		 * Comparing with nullptr is only meaningful with Comparison::Equal and Comparison::NotEqual,
+		 * and tests whether the property is NULL. Comparisons with infinities and NaN, which WQL cannot
+		 * write, are evaluated locally; as in C++, only Comparison::NotEqual is satisfied by NaN.
+		 */
+		static Filter Compare(std::wstring property, const Comparison comparison, Value value) {
+			Filter filter(Kind::Compare);
+			filter.property_ = std::move(property);
+			filter.comparison_ = comparison;
+			filter.value_ = std::move(value);
+			if (const auto* pattern = std::get_if<std::wstring>(&filter.value_); pattern && comparison == Comparison::Like) {
+				filter.like_ = std::make_shared<const text::LikePattern>(*pattern);
+			}
+
+			return filter;
+		}
+
+		/**
+		 * \brief Creates a filter evaluating an arbitrary callback. Callbacks are always evaluated locally.
+		 */
+		static Filter Custom(std::function<bool(const Object&)> predicate) {
+			Filter filter(Kind::Custom);
+			filter.custom_ = std::move(predicate);
+			return filter;
+		}
+
+		friend Filter operator&&(Filter lhs, Filter rhs) {
+			return Combine(Kind::And, std::move(lhs), std::move(rhs));
+		}
+
+		friend Filter operator||(Filter lhs, Filter rhs) {
+			return Combine(Kind::Or, std::move(lhs), std::move(rhs));
+		}
+
+		friend Filter operator!(Filter operand) {
+			Filter filter(Kind::Not);
+			filter.children_.push_back(std::move(operand));
+			return filter;
+		}
+
+		/**
+		 * \brief Returns true if the whole filter can be expressed in WQL.
+		 */
+		[[nodiscard]] bool IsExpressible() const {
+			switch (kind_) {
+			case Kind::Compare: {
+				const auto* real = std::get_if<double>(&value_);
+				return real == nullptr || std::isfinite(*real);
+			}
+			case Kind::Custom: return false;
+			default:
+				return std::all_of(children_.begin(), children_.end(), [](const Filter& child) {
+					return child.IsExpressible();
+				});
+			}
+		}
+
+		/**
+		 * \brief Renders the filter as a WQL condition.
+		 * \return The condition, or std::nullopt if the filter is not expressible in WQL.
+		 */
+		[[nodiscard]] std::optional<std::wstring> ToWql() const {
+			if (!IsExpressible()) return std::nullopt;
+			return Render();
+		}
+
+		/**
+		 * \brief Splits the filter into the parts that can be pushed into the WHERE clause of the query,
+		 * and a residual that must be evaluated locally.
+		 * The top-level conjunctions are split term by term, so that each expressible term is pushed down
+		 * even if others are not. The properties referenced by residual comparisons are added to the
+		 * projection of the query, so that they can be evaluated.
+		 * \param query The query to filter. Only queries of the form SELECT ... FROM ... [WHERE ...]
+		 * can be rewritten; for any other query, the whole filter is returned as the residual.
+		 */
+		[[nodiscard]] FilteredQuery PushDown(std::wstring_view query) const;
+
+		/**
+		 * \brief Evaluates the filter on an object.
+		 * Comparisons follow WQL semantics: strings compare case-insensitively, and comparisons
+		 * with NULL properties only match IS NULL tests.
+		 */
+		[[nodiscard]] bool Matches(const Object& object) const {
+			switch (kind_) {
+			case Kind::And:
+				return std::all_of(children_.begin(), children_.end(), [&](const Filter& child) {
+					return child.Matches(object);
+				});
+			case Kind::Or:
+				return std::any_of(children_.begin(), children_.end(), [&](const Filter& child) {
+					return child.Matches(object);
+				});
+			case Kind::Not:
+				return !children_.front().Matches(object);
+			case Kind::Custom:
+				return custom_(object);
+			default:
+				return MatchesComparison(object);
+			}
+		}
+
+	private:
+		enum class Kind {
+			Compare,
+			And,
+			Or,
+			Not,
+			Custom,
+		};
+
+		Kind kind_;
+		std::wstring property_;
+		Comparison comparison_ = Comparison::Equal;
+		Value value_;
+		std::vector<Filter> children_;
+		std::function<bool(const Object&)> custom_;
+
+		/**
+		 * \brief The compiled pattern of a LIKE comparison, shared by the copies of the filter.
+		 */
+		std::shared_ptr<const text::LikePattern> like_;
+
+		explicit Filter(const Kind kind) : kind_(kind) {}
+
+		static Filter Combine(const Kind kind, Filter lhs, Filter rhs) {
+			Filter filter(kind);
+			for (auto* operand : {&lhs, &rhs}) {
+				// Flatten nested operators of the same kind, so that conjunctions can be split term by term.
+				if (operand->kind_ == kind) {
+					for (auto& child : operand->children_) filter.children_.push_back(std::move(child));
+				}
+				else {
+					filter.children_.push_back(std::move(*operand));
+				}
+			}
+
+			return filter;
+		}
+
+		void CollectConjuncts(std::vector<const Filter*>& terms) const {
+			if (kind_ != Kind::And) {
+				terms.push_back(this);
+				return;
+			}
+
+			for (const auto& child : children_) child.CollectConjuncts(terms);
+		}
+
+		void CollectProperties(std::vector<std::wstring>& properties) const {
+			if (kind_ == Kind::Compare) {
+				// Embedded object properties are selected through their parent.
+				const auto parent = property_.substr(0, property_.find(L'.'));
+				const auto known = std::any_of(properties.begin(), properties.end(), [&](const std::wstring& p) {
+					return wql::EqualsIgnoreCase(p, parent);
+				});
+				if (!known) properties.push_back(parent);
+			}
+
+			for (const auto& child : children_) child.CollectProperties(properties);
+		}
+
+		[[nodiscard]] std::wstring Render() const {
+			switch (kind_) {
+			case Kind::And:
+			case Kind::Or: {
+				std::wstring result = L"(";
+				for (std::size_t i = 0; i < children_.size(); ++i) {
+					if (i != 0) result += kind_ == Kind::And ? L" AND " : L" OR ";
+					result += children_[i].Render();
+				}
+
+				return result + L")";
+			}
+			case Kind::Not:
+				return L"NOT (" + children_.front().Render() + L")";
+			default:
+				return RenderComparison();
+			}
+		}
+
+		[[nodiscard]] std::wstring RenderComparison() const {
+			if (std::holds_alternative<std::nullptr_t>(value_)) {
+				return property_ + (comparison_ == Comparison::NotEqual ? L" IS NOT NULL" : L" IS NULL");
+			}
+
+			static constexpr const wchar_t* kOperators[] = {L" = ", L" <> ", L" < ", L" <= ", L" > ", L" >= ", L" LIKE ", L" ISA "};
+			auto result = property_ + kOperators[static_cast<int>(comparison_)];
+			if (const auto* text = std::get_if<std::wstring>(&value_)) {
+				result += wql::Quote(*text);
+			}
+			else if (const auto* boolean = std::get_if<bool>(&value_)) {
+				result += *boolean ? L"TRUE" : L"FALSE";
+			}
+			else if (const auto* integer = std::get_if<std::int64_t>(&value_)) {
+				result += std::to_wstring(*integer);
+			}
+			else {
+				wchar_t buffer[32];
+				std::swprintf(buffer, std::size(buffer), L"%.17g", std::get<double>(value_));
+				result += buffer;
+			}
+
+			return result;
+		}
+
+		[[nodiscard]] bool MatchesComparison(const Object& object) const {
+			const auto variant = object.GetProperty<variant_t>(property_);
+			const auto is_null = !variant || variant->vt == VT_NULL || variant->vt == VT_EMPTY;
+			if (std::holds_alternative<std::nullptr_t>(value_)) {
+				return is_null == (comparison_ != Comparison::NotEqual);
+			}
+
+			if (is_null) return false;
+
+			if (comparison_ == Comparison::Isa) {
+				const auto* class_name = std::get_if<std::wstring>(&value_);
+				if (class_name == nullptr || variant->vt != VT_UNKNOWN || variant->punkVal == nullptr) return false;
+
+				CComPtr<IWbemClassObject> embedded;
+				if (FAILED(variant->punkVal->QueryInterface(IID_IWbemClassObject, reinterpret_cast<void**>(&embedded)))) {
+					return false;
+				}
+
+				CComVariant name;
+				if (SUCCEEDED(embedded->Get(L"__CLASS", 0, &name, nullptr, nullptr)) && name.vt == VT_BSTR
+						&& wql::EqualsIgnoreCase(name.bstrVal, *class_name)) {
+					return true;
+				}
+
+				return embedded->InheritsFrom(class_name->c_str()) == WBEM_S_NO_ERROR;
+			}
+
+			if (const auto* text = std::get_if<std::wstring>(&value_)) {
+				const auto converted = variant->vt == VT_BSTR ? std::nullopt : ConvertVariant<std::wstring>(*variant);
+				if (variant->vt != VT_BSTR && !converted) return false;
+
+				const auto property = variant->vt == VT_BSTR
+					? std::wstring_view(variant->bstrVal, SysStringLen(variant->bstrVal))
+					: std::wstring_view(*converted);
+				if (comparison_ == Comparison::Like) return like_->Matches(property);
+				return Satisfies(text::CompareIgnoreCase(property, *text));
+			}
+
+			if (comparison_ == Comparison::Like) return false;
+
+			// Integers are compared as such to keep the precision of 64-bit values, which WMI returns as strings.
+			if (const auto* integer = std::get_if<std::int64_t>(&value_)) {
+				if (const auto property = ConvertVariant<long long>(*variant)) {
+					return Satisfies((*property > *integer) - (*property < *integer));
+				}
+			}
+
+			const auto expected = std::holds_alternative<bool>(value_)
+				? (std::get<bool>(value_) ? 1.0 : 0.0)
+				: std::holds_alternative<std::int64_t>(value_)
+					? static_cast<double>(std::get<std::int64_t>(value_))
+					: std::get<double>(value_);
+			const auto property = variant->vt == VT_BOOL
+				? std::optional<double>(variant->boolVal != 0 ? 1.0 : 0.0)
+				: ConvertVariant<double>(*variant);
+			if (!property) return false;
+			if (std::isnan(*property) || std::isnan(expected)) return comparison_ == Comparison::NotEqual;
+			return Satisfies((*property > expected) - (*property < expected));
+		}
+
+		[[nodiscard]] bool Satisfies(const int order) const {
+			switch (comparison_) {
+			case Comparison::Equal: return order == 0;
+			case Comparison::NotEqual: return order != 0;
+			case Comparison::Less: return order < 0;
+			case Comparison::LessEqual: return order <= 0;
+			case Comparison::Greater: return order > 0;
+			case Comparison::GreaterEqual: return order >= 0;
+			default: return false;
+			}
+		}
+	};
+
+	/**
+	 * \brief The result of pushing a Filter down into a query.
+	 */
+	struct FilteredQuery {
+		/**
+		 * \brief The rewritten query, which includes every expressible part of the filter.
+		 */
+		std::wstring query;
+
+		/**
+		 * \brief The part of the filter that must still be evaluated on the returned objects.
+		 */
+		std::optional<Filter> residual;
+	};
+
+	inline FilteredQuery Filter::PushDown(const std::wstring_view query) const {
+		auto parsed = wql::ParseSelect(query);
+		if (!parsed) return {std::wstring(query), *this};
+
+		std::vector<const Filter*> terms;
+		CollectConjuncts(terms);
+
+		std::wstring pushed;
+		std::optional<Filter> residual;
+		for (const auto* term : terms) {
+			if (term->IsExpressible()) {
+				if (!pushed.empty()) pushed += L" AND ";
+				pushed += term->Render();
+			}
+			else {
+				residual = residual ? std::move(*residual) && *term : *term;
+			}
+		}
+
+		if (!pushed.empty()) {
+			parsed->where = parsed->where.empty() ? pushed : L"(" + parsed->where + L") AND " + pushed;
+		}
+
+		if (residual && !parsed->SelectsAll()) {
+			std::vector<std::wstring> properties;
+			residual->CollectProperties(properties);
+			for (auto& property : properties) {
+				if (!parsed->Selects(property)) parsed->properties.push_back(std::move(property));
+			}
+		}
+
+		return {parsed->ToString(), std::move(residual)};
+	}
+
+	/**
+	 * \brief Names a property in order to build Filter comparisons with the usual operators.
+	 * \code
+	 * const auto filter = wmipp::Property(L"Name").Like(L"svc%") && wmipp::Property(L"ProcessId") > 4;
+	 * \endcode
+	 */
+	class Property {
+	public:
+		explicit Property(std::wstring name) : name_(std::move(name)) {}
+
+		template <typename T> Filter operator==(T&& value) const { return Make(Comparison::Equal, std::forward<T>(value)); }
+		template <typename T> Filter operator!=(T&& value) const { return Make(Comparison::NotEqual, std::forward<T>(value)); }
+		template <typename T> Filter operator<(T&& value) const { return Make(Comparison::Less, std::forward<T>(value)); }
+		template <typename T> Filter operator<=(T&& value) const { return Make(Comparison::LessEqual, std::forward<T>(value)); }
+		template <typename T> Filter operator>(T&& value) const { return Make(Comparison::Greater, std::forward<T>(value)); }
+		template <typename T> Filter operator>=(T&& value) const { return Make(Comparison::GreaterEqual, std::forward<T>(value)); }
+
+		[[nodiscard]] Filter Like(std::wstring pattern) const { return Make(Comparison::Like, std::move(pattern)); }
+		[[nodiscard]] Filter Isa(std::wstring class_name) const { return Make(Comparison::Isa, std::move(class_name)); }
+		[[nodiscard]] Filter IsNull() const { return Make(Comparison::Equal, nullptr); }
+		[[nodiscard]] Filter IsNotNull() const { return Make(Comparison::NotEqual, nullptr); }
+
+	private:
+		std::wstring name_;
+
+		template <typename T>
+		[[nodiscard]] Filter Make(const Comparison comparison, T&& value) const {
+			using U = std::decay_t<T>;
+			if constexpr (std::is_same_v<U, bool> || std::is_same_v<U, std::nullptr_t>) {
+				return Filter::Compare(name_, comparison, value);
+			}
+			else if constexpr (std::is_integral_v<U>) {
+				return Filter::Compare(name_, comparison, static_cast<std::int64_t>(value));
+			}
+			else if constexpr (std::is_floating_point_v<U>) {
+				return Filter::Compare(name_, comparison, static_cast<double>(value));
+			}
+			else {
+				return Filter::Compare(name_, comparison, std::wstring(std::forward<T>(value)));
+			}
+		}
+	};
+
+	/**
+	 * \brief Encapsulates a collection of objects obtained from a query operation. 
+	 * It provides methods to access and retrieve properties from the objects in a convenient manner.
+	 * The class supports iterating over the objects using range-based for loops.
+	 */
+	class QueryResult{
+		friend class Interface;
+
+	protected:
+		QueryResult(
+			std::shared_ptr<const Interface> iface,
+			const CComPtr<IEnumWbemClassObject>& enumerator,
+			const ULONG batch_size = 1,
+			std::shared_ptr<detail::ExecutionTrace> trace = nullptr,
+			const bool fingerprint = false)
+				: iface_(std::move(iface)), trace_(std::move(trace)) {
+			if (enumerator) PopulateObjects(enumerator, (std::max)(batch_size, ULONG{1}), fingerprint);
+		}
+
+	public:
+		/**
+		 * \brief Finds and retrieves the value of a specific property in the populated objects by name.
+		 * If the property is found and its type matches the provided template type T, the value is returned.
+		 * \see Object::GetProperty for more information.
+		 * \tparam T The type of the property to retrieve.
+		 * \param name The name of the property to retrieve.
+		 * \return An optional value containing the property value if found, or an empty optional if not found.
+		 */
+		template <typename T = Value>
+		[[nodiscard]] std::optional<T> GetProperty(const std::wstring_view name) const {
+			for (const Object& obj : *this) {
+				if (auto value = obj.GetProperty<T>(name)) {
+					return value;
+				}
+			}
+
+			return std::nullopt;
+		}
+
+		/**
+		 * \brief Retrieves the value of a specific property in the object at the specified index by name.
+		 * If the property is found and its type matches the provided template type T, the value is returned.
+		 * \see Object::GetProperty for more information.
+		 * \tparam T The type of the property to retrieve.
+		 * \param name The name of the property to retrieve.
+		 * \param index The index of the object in the objects vector to retrieve the property from.
+		 * \return An optional value containing the property value exists, or an empty optional if not found.
+		 */
+		template <typename T = Value>
+		[[nodiscard]] std::optional<T> GetProperty(const std::wstring_view name, const std::size_t index) const {
+			if (index >= Count()) return std::nullopt;
+			return GetAt(index).GetProperty<T>(name);
+		}
+
+		/**
+		 * \brief Returns the number of objects in the result.
+		 */
+		[[nodiscard]] std::size_t Count() const {
+			return objects_.size();
+		}
+
+		/**
+		 * \brief Approximates the memory retained by the materialized objects.
+		 * \see Object::EstimatedSize for more information.
+		 */
+		[[nodiscard]] std::size_t EstimatedSize() const {
+			std::size_t size = objects_.capacity() * sizeof(Object);
+			for (const Object& obj : *this) {
+				size += obj.EstimatedSize();
+			}
+
+			return size;
+		}
+
+		/**
+		 * \param index The index of the object to access.
+		 * \return A const reference to the object at the specified index.
+		 * \throws std::out_of_range if the index is out of range.
+		 */
+		[[nodiscard]] const Object& GetAt(const std::size_t index) const {
+			return objects_.at(index);
+		}
+
+		/**
+		 * \param index The index of the object to access.
+		 * \return A const reference to the object at the specified index.
+		 * \throws std::out_of_range if the index is out of range.
+		 */
+		const Object& operator[](const std::size_t index) const {
+			return GetAt(index);
+		}
+
+		[[nodiscard]] std::vector<Object>::const_iterator begin() const {
+			return objects_.begin();
+		}
+
+		[[nodiscard]] std::vector<Object>::const_iterator end() const {
+			return objects_.end();
+		}
+
+		/**
+		 * \brief Returns the report of the execution of the query, including the conversions made so far.
+		 * \return The report, or std::nullopt if it was not requested with QueryOptions::report.
+		 */
+		[[nodiscard]] std::optional<ExecutionReport> GetReport() const {
+			if (trace_ == nullptr) return std::nullopt;
+			return trace_->Snapshot();
+		}
+
+		/**
+		 * \brief Returns the Fingerprint of the objects in the result, which does not depend on their order.
+		 * Two results of the same query have the same fingerprint if and only if (barring collisions)
+		 * their objects have the same property values, so it can be used as an ETag or to skip
+		 * processing results that did not change since the last poll.
+		 * If the query was executed with QueryOptions::fingerprint, the fingerprint computed during the
+		 * execution is returned. Otherwise, it is computed on each call.
+		 * \see Object::GetFingerprint for more information.
+		 */
+		[[nodiscard]] Fingerprint GetFingerprint() const {
+			return fingerprint_ ? *fingerprint_ : ComputeFingerprint();
+		}
+
+		/**
+		 * \brief Converts the result into a ColumnarTable, which can be exported through the Arrow C data interface.
+		 * \param properties The properties to convert, one column each. If empty, every non-system property
+		 * of the first object is converted.
+		 * \return The table, with one row per object.
+		 */
+		[[nodiscard]] ColumnarTable ToColumnar(std::vector<std::wstring> properties = {}) const {
+			if (properties.empty() && !objects_.empty()) properties = objects_.front().GetPropertyNames();
+
+			ColumnarTable table(properties);
+			std::vector<Value> row;
+			for (const Object& obj : *this) {
+				obj.AppendTo(table, properties, row);
+			}
+
+			return table;
+		}
+
+	private:
+		std::shared_ptr<const Interface> iface_;
+		std::vector<Object> objects_;
+		std::shared_ptr<detail::ExecutionTrace> trace_;
+		std::optional<Fingerprint> fingerprint_;
+
+		/**
+		 * \brief Removes the objects that do not match the filter.
+		 */
+		void Retain(const Filter& filter) {
+			objects_.erase(
+				std::remove_if(objects_.begin(), objects_.end(), [&](const Object& obj) { return !filter.Matches(obj); }),
+				objects_.end());
+			if (fingerprint_) fingerprint_ = ComputeFingerprint();
+		}
+
+		[[nodiscard]] Fingerprint ComputeFingerprint() const {
+			detail::FingerprintAccumulator accumulator;
+			for (const Object& obj : *this) {
+				accumulator.Add(obj.GetFingerprint());
+			}
+
+			return accumulator.Finish();
+		}
+
+		/**
+		 * \brief Makes the objects apply the given size caps when their properties are converted.
+		 */
+		void SetCaps(const std::shared_ptr<const detail::SizeCaps>& caps) {
+			for (auto& object : objects_) object.caps_ = caps;
+		}
+
+		/**
+		 * \brief Turns a copy of the result of a batch into the result of one of its queries: the objects
+		 * only expose the properties the query selected, and are detached from the report of the batch
+		 * unless the query requested one.
+		 * \param projection The properties selected by the query, or nullptr if it selected all of them.
+		 */
+		void ProjectForMember(const std::shared_ptr<const std::vector<std::wstring>>& projection, const bool report) {
+			if (!report) trace_ = nullptr;
+			for (auto& object : objects_) {
+				object.projection_ = projection;
+				if (!report) object.trace_ = nullptr;
+			}
+		}
+
+		/**
+		 * \brief Fills the objects vector by iterating over the given enumerator.
+		 * We do this here so that we don't need to clone the enumerator and wrap it into it's own ::enumerator.
+		 * Each retrieved IWbemClassObject is wrapped in an Object and added to the objects vector.
+		 * \param enumerator A pointer to the IEnumWbemClassObject enumerator.
+		 * \param batch_size The number of objects requested on each call to Next.
+		 * \param fingerprint Whether to fingerprint the objects as they are retrieved.
+		 */
+		void PopulateObjects(const CComPtr<IEnumWbemClassObject>& enumerator, const ULONG batch_size, const bool fingerprint) {
+			detail::FingerprintAccumulator accumulator;
+			std::vector<IWbemClassObject*> objects(batch_size, nullptr);
+			while (true) {
+				ULONG returned_count = 0;
+				const auto start = trace_ != nullptr ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+				const auto result = enumerator->Next(
+					WBEM_INFINITE,
+					batch_size,
+					objects.data(),
+					&returned_count);
+				if (trace_ != nullptr) trace_->RecordNext(start, returned_count);
+
+				for (ULONG i = 0; i < returned_count; ++i) {
+					CComPtr<IWbemClassObject> object;
+					object.Attach(objects[i]);
+					objects_.emplace_back(Object(iface_, std::move(object), trace_));
+					if (fingerprint) accumulator.Add(objects_.back().GetFingerprint());
+				}
+
+				if (FAILED(result) || returned_count < batch_size) {
+					break;
+				}
+			}
+
+			if (fingerprint) fingerprint_ = accumulator.Finish();
+		}
+	};
+
+	/**
+	 * \brief Streams the objects returned by a query without materializing the whole result.
+	 * Objects are pulled from the enumerator in batches. Cursors created with QueryOptions::rewindable
+	 * can be rewound with Reset, or duplicated at their current position with Clone, to make multiple
+	 * passes over the result without executing the query again.
+	 */
+	class QueryCursor{
+		friend class Interface;
+
+	protected:
+		QueryCursor(
+			std::shared_ptr<const Interface> iface,
+			CComPtr<IEnumWbemClassObject> enumerator,
+			const QueryOptions& options,
+			std::wstring class_name = {},
+			std::wstring query = {},
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(),
+			std::shared_ptr<detail::ExecutionTrace> trace = nullptr)
+				: iface_(std::move(iface)), enumerator_(std::move(enumerator)), options_(options),
+				  class_name_(std::move(class_name)), query_(std::move(query)), start_(start), trace_(std::move(trace)) {
+			if (options_.batch_size == 0) options_.batch_size = 1;
+			caps_ = detail::SizeCaps::From(options_);
+
+			// Materializing would release the enumerator that rewinding relies on.
+			if (options_.rewindable && options_.strategy == Strategy::Materialize) {
+				options_.strategy = Strategy::Stream;
+			}
+
+			if (trace_ != nullptr) {
+				trace_->report.strategy = options_.strategy;
+				trace_->report.batch_size = options_.batch_size;
+			}
+		}
+
+	public:
+		QueryCursor(const QueryCursor& other) = delete;
+		QueryCursor& operator=(const QueryCursor& other) = delete;
+
+		QueryCursor(QueryCursor&& other) noexcept = default;
+		QueryCursor& operator=(QueryCursor&& other) noexcept = default;
+
+		/**
+		 * \brief Retrieves the next object of the result.
+		 * \return The next object, or std::nullopt once the result is exhausted.
+		 */
+		[[nodiscard]] std::optional<Object> Next() {
+			while (true) {
+				if (buffer_position_ == buffer_.size() && !Fetch()) {
+					return std::nullopt;
+				}
+
+				++position_;
+				retained_ = (std::max)(retained_, position_);
+				auto& object = buffer_[buffer_position_++];
+				if (!residual_ || residual_->Matches(object)) return std::move(object);
+			}
+		}
+
+		/**
+		 * \brief Rewinds the cursor to the first object of the result.
+		 * \throws wmipp::Exception if the cursor is not rewindable or the enumerator cannot be reset.
+		 */
+		void Reset() {
+			if (!options_.rewindable) throw Exception("Cannot reset a forward-only cursor");
+			if (FAILED(enumerator_->Reset())) throw Exception("Failed to reset the enumerator");
+
+			buffer_.clear();
+			buffer_position_ = 0;
+			position_ = 0;
+			exhausted_ = false;
+			accumulator_.Reset();
+			fingerprint_.reset();
+		}
+
+		/**
+		 * \brief Creates an independent cursor positioned at the same object as this one.
+		 * \throws wmipp::Exception if the cursor is not rewindable or the enumerator cannot be cloned.
+		 */
+		[[nodiscard]] QueryCursor Clone() const {
+			if (!options_.rewindable) throw Exception("Cannot clone a forward-only cursor");
+
+			CComPtr<IEnumWbemClassObject> enumerator;
+			if (FAILED(enumerator_->Clone(&enumerator))) {
+				throw Exception("Failed to clone the enumerator");
+			}
+
+			// The clone starts where the enumerator is, which is past the objects we have
+			// prefetched but not yet returned, so hand them over as well.
+			QueryCursor clone(iface_, enumerator, options_, class_name_, query_, start_, trace_);
+			clone.buffer_.assign(buffer_.begin() + static_cast<std::ptrdiff_t>(buffer_position_), buffer_.end());
+			clone.position_ = position_;
+			clone.retained_ = retained_;
+			clone.exhausted_ = exhausted_;
+			clone.recorded_ = true;
+			clone.residual_ = residual_;
+			clone.accumulator_ = accumulator_;
+			clone.fingerprint_ = fingerprint_;
+			return clone;
+		}
+
+		/**
+		 * \brief Returns true if the cursor supports Reset and Clone.
+		 */
+		[[nodiscard]] bool IsRewindable() const {
+			return options_.rewindable;
+		}
+
+		/**
+		 * \brief Returns the strategy the cursor retrieves its objects with.
+		 */
+		[[nodiscard]] Strategy GetStrategy() const {
+			return options_.strategy;
+		}
+
+		/**
+		 * \brief Returns the number of objects requested from the enumerator on each call to Next.
+		 */
+		[[nodiscard]] ULONG GetBatchSize() const {
+			return options_.batch_size;
+		}
+
+		/**
+		 * \brief Returns the report of the execution of the query so far.
+		 * A clone shares the report of the cursor it was cloned from.
+		 * \return The report, or std::nullopt if it was not requested with QueryOptions::report.
+		 */
+		[[nodiscard]] std::optional<ExecutionReport> GetReport() const {
+			if (trace_ == nullptr) return std::nullopt;
+			return trace_->Snapshot();
+		}
+
+		/**
+		 * \brief Returns the Fingerprint of the objects the cursor returns, once they were all enumerated.
+		 * The objects are fingerprinted as they are retrieved from the enumerator, so the fingerprint is
+		 * available as soon as the last batch was fetched, possibly before its objects were returned.
+		 * \see QueryResult::GetFingerprint for more information.
+		 * \return The fingerprint, or std::nullopt if it was not requested with QueryOptions::fingerprint
+		 * or the enumeration is not complete yet.
+		 */
+		[[nodiscard]] std::optional<Fingerprint> GetFingerprint() const {
+			return fingerprint_;
+		}
+
+		/**
+		 * \brief Consumes the remaining objects of the cursor into a ColumnarTable.
+		 * Only the current batch of objects is alive at any time, so large results can be converted
+		 * without materializing their objects.
+		 * \see QueryResult::ToColumnar for more information.
+		 */
+		[[nodiscard]] ColumnarTable ToColumnar(std::vector<std::wstring> properties = {}) {
+			auto object = Next();
+			if (properties.empty() && object) properties = object->GetPropertyNames();
+
+			ColumnarTable table(properties);
+			std::vector<Value> row;
+			for (; object; object = Next()) {
+				object->AppendTo(table, properties, row);
+			}
+
+			return table;
+		}
+
+		/**
+		 * \brief Consumes the remaining objects of the cursor, feeding the values of their properties to
+		 * sketches such as HyperLogLog, CountMinSketch or TDigest.
+		 * Only the current batch of objects is alive at any time, so huge results can be summarized in
+		 * the memory of the sketches.
+		 * \param feeds Pairs of a property and a function receiving its value for every object, such as
+		 * a lambda calling the Add member of a sketch. Missing properties are passed as nulls.
+		 */
+		void Aggregate(const std::vector<std::pair<std::wstring, std::function<void(const Value&)>>>& feeds) {
+			for (auto object = Next(); object; object = Next()) {
+				for (const auto& [property, feed] : feeds) {
+					feed(object->GetProperty<Value>(property).value_or(Value()));
+				}
+			}
+		}
+
+		/**
+		 * \brief Returns the number of objects kept alive on behalf of this cursor.
+		 * For rewindable cursors this is every object returned so far, since the enumerator retains
+		 * them to be able to rewind. For forward-only cursors it is only the current batch.
+		 */
+		[[nodiscard]] std::size_t RetainedCount() const {
+			return options_.rewindable ? (std::max)(retained_, buffer_.size()) : buffer_.size();
+		}
+
+		/**
+		 * \brief Approximates the memory retained on behalf of this cursor.
+		 * The size of the retained objects is extrapolated from the first objects of the result.
+		 * \see Object::EstimatedSize for more information.
+		 */
+		[[nodiscard]] std::size_t EstimatedSize() const {
+			const auto average = sampled_count_ == 0 ? 0 : sampled_size_ / sampled_count_;
+			return RetainedCount() * (sizeof(Object) + average);
+		}
+
+		class Iterator {
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = Object;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Object*;
+			using reference = const Object&;
+
+			Iterator() = default;
+			explicit Iterator(QueryCursor* cursor) : cursor_(cursor) { ++*this; }
+
+			reference operator*() const { return *current_; }
+			pointer operator->() const { return &*current_; }
+
+			Iterator& operator++() {
+				current_ = cursor_->Next();
+				if (!current_) cursor_ = nullptr;
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const { return cursor_ == other.cursor_; }
+			bool operator!=(const Iterator& other) const { return cursor_ != other.cursor_; }
+
+		private:
+			QueryCursor* cursor_ = nullptr;
+			std::optional<Object> current_;
+		};
+
+		/**
+		 * \brief Iterates over the remaining objects of the cursor.
+		 * Iterating consumes the cursor; use Reset to iterate a rewindable cursor again.
+		 */
+		[[nodiscard]] Iterator begin() {
+			return Iterator(this);
+		}
+
+		[[nodiscard]] Iterator end() {
+			return {};
+		}
+
+	private:
+		/**
+		 * \brief The number of leading objects whose size is sampled for EstimatedSize.
+		 */
+		static constexpr std::size_t kSampledObjects = 8;
+
+		std::shared_ptr<const Interface> iface_;
+		CComPtr<IEnumWbemClassObject> enumerator_;
+		QueryOptions options_;
+
+		std::vector<Object> buffer_;
+		std::size_t buffer_position_ = 0;
+		std::size_t position_ = 0;
+		std::size_t retained_ = 0;
+		bool exhausted_ = false;
+
+		std::size_t sampled_count_ = 0;
+		std::size_t sampled_size_ = 0;
+
+		std::wstring class_name_;
+		std::wstring query_;
+		std::chrono::steady_clock::time_point start_;
+		bool recorded_ = false;
+
+		/**
+		 * \brief The part of the filter that could not be pushed into the query, evaluated on each object.
+		 */
+		std::optional<Filter> residual_;
+
+		std::shared_ptr<detail::ExecutionTrace> trace_;
+		std::shared_ptr<const detail::SizeCaps> caps_;
+
+		detail::FingerprintAccumulator accumulator_;
+		std::optional<Fingerprint> fingerprint_;
+
+		/**
+		 * \brief Replaces the buffer with the next batch of objects from the enumerator.
+		 * With Strategy::Materialize, the whole result is read into the buffer at once.
+		 * \return true if at least one object was retrieved.
+		 */
+		bool Fetch() {
+			buffer_.clear();
+			buffer_position_ = 0;
+			if (exhausted_ || enumerator_ == nullptr) return false;
+
+			if (options_.strategy == Strategy::Materialize) {
+				while (FetchBatch()) { }
+				enumerator_.Release();
+				return !buffer_.empty();
+			}
+
+			FetchBatch();
+			return !buffer_.empty();
+		}
+
+		/**
+		 * \brief Appends the next batch of objects from the enumerator to the buffer.
+		 * The execution is reported to the Interface once the enumerator is exhausted.
+		 * \return true if the enumerator may have more objects.
+		 */
+		bool FetchBatch() {
+			std::vector<IWbemClassObject*> objects(options_.batch_size, nullptr);
+			ULONG returned_count = 0;
+			const auto start = std::chrono::steady_clock::now();
+			const auto result = enumerator_->Next(
+				WBEM_INFINITE,
+				options_.batch_size,
+				objects.data(),
+				&returned_count);
+			const auto provider_time = std::chrono::steady_clock::now() - start;
+			if (trace_ != nullptr) trace_->RecordNext(start, returned_count);
+			if (FAILED(result) || returned_count < options_.batch_size) {
+				exhausted_ = true;
+			}
+
+			// A failed enumeration is incomplete and would skew the statistics.
+			if (FAILED(result)) recorded_ = true;
+
+			if (buffer_.empty()) buffer_.reserve(returned_count);
+			for (ULONG i = 0; i < returned_count; ++i) {
+				CComPtr<IWbemClassObject> object;
+				object.Attach(objects[i]);
+				buffer_.emplace_back(Object(iface_, std::move(object), trace_, caps_));
+
+				if (sampled_count_ < kSampledObjects) {
+					sampled_size_ += buffer_.back().EstimatedSize();
+					++sampled_count_;
+				}
+
+				// Only the objects that Next will return are part of the fingerprint.
+				const auto& added = buffer_.back();
+				if (options_.fingerprint && (!residual_ || residual_->Matches(added))) {
+					accumulator_.Add(added.GetFingerprint());
+				}
+			}
+
+			if (exhausted_ && options_.fingerprint && SUCCEEDED(result)) {
+				fingerprint_ = accumulator_.Finish();
+			}
+
+			// Batches are accounted as they are fetched, so that abandoned cursors are accounted too.
+			TagAccounting::Entry cost;
+			cost.tag = options_.tag;
+			cost.rows = returned_count;
+			cost.bytes = sampled_count_ == 0 ? 0 : returned_count * (sampled_size_ / sampled_count_);
+			cost.time = std::chrono::steady_clock::now() - start;
+			cost.provider_time = provider_time;
+			TagAccounting::Global().Record(cost);
+
+			if (exhausted_ && !recorded_) {
+				recorded_ = true;
+				Record(position_ + buffer_.size());
+			}
+
+			return !exhausted_;
+		}
+
+		/**
+		 * \brief Reports a complete enumeration to the statistics of the Interface.
+		 * \param rows The total number of objects in the result.
+		 */
+		void Record(std::size_t rows);
+	};
+
+	/**
+	 * \brief Controls when an Interface establishes its connection to the WMI service.
+	 */
+	enum class ConnectMode {
+		/**
+		 * \brief The COM library is initialized and the namespace is connected in the constructor.
+		 */
+		Eager,
+
+		/**
+		 * \brief COM and WMI setup is deferred until the first query (or an explicit WarmUp).
+		 * Lazy connections live in the process-wide multithreaded apartment, which is kept
+		 * alive for as long as the Interface exists.
+		 */
+		Lazy,
+	};
+
+	enum class HealthState {
+		/**
+		 * \brief The connection has not been probed yet.
+		 */
+		Unknown,
+
+		/**
+		 * \brief The last probe succeeded, possibly after rebuilding the connection.
+		 */
+		Healthy,
+
+		/**
+		 * \brief The last probe failed and the connection could not be rebuilt.
+		 */
+		Unhealthy,
+	};
+
+	/**
+	 * \brief The health of the connection of an Interface, as observed by its probes.
+	 * \see Interface::EnableKeepAlive
+	 */
+	struct ConnectionHealth {
+		HealthState state = HealthState::Unknown;
+
+		/**
+		 * \brief The number of probes, and how many of them failed before any reconnection.
+		 */
+		std::uint64_t probes = 0;
+		std::uint64_t failures = 0;
+
+		/**
+		 * \brief The number of times the connection was rebuilt after a failed probe.
+		 */
+		std::uint64_t reconnects = 0;
+
+		/**
+		 * \brief How long the last probe took, including any reconnection.
+		 */
+		std::chrono::nanoseconds last_probe_time{};
+	};
+
+	/**
+	 * \brief Manages a connection to the WMI service and provides a convenient interface
+	 * to query WMI objects.
+	 * This class also handles COM initialization and cleanup.
+	 */
+	class Interface : public std::enable_shared_from_this<const Interface> {
+		friend class QueryCursor;
+
+	public:
+		/**
+		 * Initializes the COM library and creates a connection to the WMI service.
+		 * \param path The path to the WMI namespace to connect to.
+		 * \param mode Whether to connect immediately or on first use.
+		 * \throws wmipp::Exception if the COM library fails to initialize or the connection
+		 * to the WMI service fails. With ConnectMode::Lazy these errors are deferred to the
+		 * first query instead.
+		 */
+		static std::shared_ptr<Interface> Create(
+			std::string_view path = "cimv2",
+			ConnectMode mode = ConnectMode::Eager);
+
+		/**
+		 * \brief Interfaces are not copyable: they own a connection and its COM initialization, which a copy
+		 * would release a second time, along with state shared by their queries such as the class statistics.
+		 * Share the std::shared_ptr returned by Create instead.
+		 */
+		Interface(const Interface& other) = delete;
+		Interface& operator=(const Interface& other) = delete;
+
+		Interface(Interface&& other) noexcept = delete;
+		Interface& operator=(Interface&& other) noexcept = delete;
+
+		/**
+		 * \brief Starts connecting a lazy Interface on a background thread and returns immediately.
+		 * Call this on several Interfaces to connect their namespaces in parallel. Queries issued
+		 * while the warm-up is still running only wait for the connection of their own Interface.
+		 * \return A future that becomes ready once the connection attempt completes, and rethrows its error.
+		 * Like any future returned by std::async, destroying it waits for the attempt, so that the background
+		 * thread never outlives its owner. The Interface is kept alive until then.
+		 * \note The future is ready immediately for eagerly connected Interfaces, or if the connection was
+		 * already made. If the background connection fails, the next query retries it.
+		 */
+		[[nodiscard]] std::future<void> WarmUp() const {
+			if (mode_ != ConnectMode::Lazy || connected_.load(std::memory_order_acquire)) {
+				std::promise<void> connected;
+				connected.set_value();
+				return connected.get_future();
+			}
+
+			return std::async(std::launch::async, [self = shared_from_this()] { self->Services(); });
+		}
+
+		/**
+		 * \brief Returns true if the connection to the WMI service has been established.
+		 */
+		[[nodiscard]] bool IsConnected() const {
+			return connected_.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * \brief Executes a WQL query and returns the result.
+		 * \param query The WQL query to execute.
+		 * \return A QueryResult instance containing the result of the query.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] QueryResult ExecuteQuery(const std::wstring_view query) const {
+			return ExecuteQuery(query, QueryOptions{});
+		}
+
+		/**
+		 * \brief Executes a WQL query and returns the result.
+		 * The whole result is always materialized, so QueryOptions::strategy and QueryOptions::rewindable
+		 * are ignored.
+		 * \param query The WQL query to execute.
+		 * \param options Options controlling how the result is enumerated.
+		 * \return A QueryResult instance containing the result of the query.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] QueryResult ExecuteQuery(const std::wstring_view query, const QueryOptions& options) const {
+			if (options.lint) ThrowOnLintErrors(query);
+
+			const auto tagged = Tagged(options);
+			const auto start = std::chrono::steady_clock::now();
+			const auto account = [&](const bool failed) {
+				TagAccounting::Entry cost;
+				cost.tag = tagged.tag;
+				cost.queries = 1;
+				cost.failures = failed ? 1 : 0;
+				cost.time = std::chrono::steady_clock::now() - start;
+				TagAccounting::Global().Record(cost);
+			};
+
+			// Batched queries share their objects, so the caps of each caller are set on its own copy.
+			auto result = [&] {
+				try {
+					// The fingerprint of a batch would cover the properties of every member, and change
+					// with the composition of the batch, so fingerprinted queries are executed on their own.
+					const auto window = std::chrono::microseconds(batching_window_.load(std::memory_order_relaxed));
+					if (window.count() > 0 && !options.fingerprint) {
+						if (const auto parsed = wql::ParseSelect(query)) {
+							return ExecuteBatched(query, *parsed, window, tagged);
+						}
+					}
+
+					return ExecuteDirect(query, tagged);
+				}
+				catch (...) {
+					account(true);
+					throw;
+				}
+			}();
+
+			account(false);
+			if (auto caps = detail::SizeCaps::From(options)) result.SetCaps(caps);
+			return result;
+		}
+
+		/**
+		 * \brief Executes a WQL query, keeping only the objects that match the filter.
+		 * Every part of the filter that WQL can express is pushed into the WHERE clause of the query,
+		 * and only the residual is evaluated on the returned objects.
+		 * \see Filter::PushDown for more information.
+		 * \param query The WQL query to execute.
+		 * \param filter The filter to apply.
+		 * \param options Options controlling how the result is enumerated.
+		 * \return A QueryResult instance containing the matching objects.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] QueryResult ExecuteQuery(
+			const std::wstring_view query,
+			const Filter& filter,
+			const QueryOptions& options = {}) const {
+			const auto pushdown = filter.PushDown(query);
+			auto result = ExecuteQuery(pushdown.query, options);
+			if (pushdown.residual) {
+				if (result.trace_ != nullptr) result.trace_->report.local_filter = true;
+				result.Retain(*pushdown.residual);
+			}
+
+			return result;
+		}
+
+		/**
+		 * \brief Enables micro-batching of the queries executed with ExecuteQuery.
+		 * The first SELECT query on a class waits for the given window, and every other query on the same
+		 * class with the same WHERE clause and QueryOptions::batch_size issued in the meantime joins it.
+		 * The batch is then executed as a single query projecting the union of the selected properties,
+		 * and each caller receives its own QueryResult over the shared objects, in which the properties it
+		 * did not select read as null. Only the callers that requested an ExecutionReport get one, and
+		 * queries with QueryOptions::fingerprint are never batched.
+		 * \param window How long the first query of a batch waits for others to join. Zero disables batching.
+		 * \note Batching adds up to the window to the latency of every batched query, so it only pays
+		 * off when many threads issue small queries on the same classes at about the same time.
+		 */
+		void EnableBatching(const std::chrono::microseconds window) const {
+			batching_window_.store((std::max)(window.count(), std::int64_t{0}), std::memory_order_relaxed);
+		}
+
+		void DisableBatching() const {
+			EnableBatching(std::chrono::microseconds::zero());
+		}
+
+		/**
+		 * \brief Starts probing the connection on a background thread, so that proxies torn down by DCOM
+		 * after a quiet period are rebuilt before the next query needs them.
+		 * Probes are skipped while queries keep the connection busy.
+		 * \see ProbeHealth for how the connection is probed.
+		 * \param interval The time between probes. Zero stops probing.
+		 * \note Destroying the Interface waits for a running probe to complete.
+		 */
+		void EnableKeepAlive(const std::chrono::milliseconds interval) const {
+			const std::lock_guard lock(keep_alive_mutex_);
+			keep_alive_interval_ = (std::max)(interval, std::chrono::milliseconds::zero());
+			keep_alive_condition_.notify_all();
+
+			if (keep_alive_interval_.count() != 0 && !keep_alive_thread_.joinable()) {
+				keep_alive_thread_ = std::thread([this] { KeepAlive(); });
+			}
+		}
+
+		void DisableKeepAlive() const {
+			EnableKeepAlive(std::chrono::milliseconds::zero());
+		}
+
+		/**
+		 * \brief Checks the connection with a cheap call to the WMI service, and rebuilds it if the call fails.
+		 * A lazy Interface that is not connected yet is connected by the probe.
+		 * \return The health of the connection after the probe.
+		 */
+		ConnectionHealth ProbeHealth() const {
+			const auto start = std::chrono::steady_clock::now();
+
+			// Reading the definition of __SystemClass is a round trip to the service that providers never see.
+			auto healthy = false;
+			try {
+				const auto services = Services();
+				CComPtr<IWbemClassObject> definition;
+				healthy = SUCCEEDED(services->GetObject(
+					bstr_t(L"__SystemClass"), WBEM_FLAG_RETURN_WBEM_COMPLETE, nullptr, &definition, nullptr));
+			}
+			catch (const Exception&) { }
+
+			auto reconnected = false;
+			if (!healthy && connected_.load(std::memory_order_acquire)) {
+				try {
+					Connect();
+					reconnected = true;
+				}
+				catch (const Exception&) { }
+			}
+
+			const std::lock_guard lock(health_mutex_);
+			++health_.probes;
+			if (!healthy) ++health_.failures;
+			if (reconnected) ++health_.reconnects;
+			health_.state = healthy || reconnected ? HealthState::Healthy : HealthState::Unhealthy;
+			health_.last_probe_time = std::chrono::steady_clock::now() - start;
+			return health_;
+		}
+
+		/**
+		 * \brief Returns the health of the connection as of the last probe.
+		 */
+		[[nodiscard]] ConnectionHealth GetHealth() const {
+			const std::lock_guard lock(health_mutex_);
+			return health_;
+		}
+
+		/**
+		 * \brief Executes a WQL query and returns a cursor that streams its result.
+		 * \param query The WQL query to execute.
+		 * \param options Options controlling how the result is enumerated.
+		 * \return A QueryCursor positioned before the first object of the result.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] QueryCursor StreamQuery(const std::wstring_view query, const QueryOptions& options = {}) const {
+			if (options.lint) ThrowOnLintErrors(query);
+
+			const auto trace = options.report ? std::make_shared<detail::ExecutionTrace>() : nullptr;
+			if (trace != nullptr) trace->report.query = query;
+
+			auto planned = Tagged(options);
+			if (planned.strategy == Strategy::Auto) {
+				const auto plan = PlanQuery(query, options);
+				planned.strategy = plan.strategy;
+				planned.batch_size = plan.batch_size;
+				if (trace != nullptr) trace->report.from_statistics = plan.from_statistics;
+			}
+
+			long flags = WBEM_FLAG_RETURN_IMMEDIATELY;
+			if (!planned.rewindable) flags |= WBEM_FLAG_FORWARD_ONLY;
+
+			// The objects are fetched, and accounted, by the cursor.
+			TagAccounting::Entry cost;
+			cost.tag = planned.tag;
+			cost.queries = 1;
+
+			const auto start = std::chrono::steady_clock::now();
+			CComPtr<IEnumWbemClassObject> enumerator;
+			try { enumerator = Execute(query, flags, trace.get()); }
+			catch (...) {
+				cost.failures = 1;
+				cost.time = cost.provider_time = std::chrono::steady_clock::now() - start;
+				TagAccounting::Global().Record(cost);
+				throw;
+			}
+
+			cost.time = cost.provider_time = std::chrono::steady_clock::now() - start;
+			TagAccounting::Global().Record(cost);
+			return {shared_from_this(), std::move(enumerator), planned, QueryClassName(query), std::wstring(query), start, trace};
+		}
+
+		/**
+		 * \brief Executes a WQL query and returns a cursor that streams the objects matching the filter.
+		 * \see ExecuteQuery(std::wstring_view, const Filter&) for more information on filtering.
+		 * \param query The WQL query to execute.
+		 * \param filter The filter to apply.
+		 * \param options Options controlling how the result is enumerated.
+		 * \return A QueryCursor positioned before the first matching object of the result.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] QueryCursor StreamQuery(
+			const std::wstring_view query,
+			const Filter& filter,
+			const QueryOptions& options = {}) const {
+			auto pushdown = filter.PushDown(query);
+			auto cursor = StreamQuery(pushdown.query, options);
+			if (cursor.trace_ != nullptr) cursor.trace_->report.local_filter = pushdown.residual.has_value();
+			cursor.residual_ = std::move(pushdown.residual);
+			return cursor;
+		}
+
+		/**
+		 * \brief Executes a WQL query as StreamQuery would, enumerates the whole result and reports
+		 * how it was executed.
+		 * \param query The WQL query to explain.
+		 * \param options The options the query is executed with. QueryOptions::report is implied.
+		 * \return The report of the execution. Since the objects are not read, no conversions are reported.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] ExecutionReport Explain(const std::wstring_view query, QueryOptions options = {}) const {
+			options.report = true;
+			auto cursor = StreamQuery(query, options);
+			while (cursor.Next()) { }
+			return *cursor.GetReport();
+		}
+
+		/**
+		 * \brief Executes a WQL query and returns the relative paths (__RELPATH) of the matching instances.
+		 * SELECT queries are rewritten to project only the key properties of their class, and the returned
+		 * objects are released batch by batch without being wrapped in Objects, so memory stays proportional
+		 * to the keys rather than to whole instances.
+		 * \see ObjectPath::Parse to read the keys of the returned paths.
+		 * \param query The WQL query to execute. Its selected properties are ignored.
+		 * \param options Options controlling how the result is enumerated. Only batch_size and lint are used.
+		 * \return The relative paths of the instances, in enumeration order.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] std::vector<std::wstring> ExecuteKeys(
+			const std::wstring_view query,
+			const QueryOptions& options = {}) const {
+			std::vector<std::wstring> paths;
+			EnumerateKeys(query, options, [&](IWbemClassObject* object) {
+				CComVariant variant;
+				if (SUCCEEDED(object->Get(L"__RELPATH", 0, &variant, nullptr, nullptr)) && variant.vt == VT_BSTR) {
+					paths.emplace_back(variant.bstrVal, SysStringLen(variant.bstrVal));
+				}
+			});
+
+			return paths;
+		}
+
+		/**
+		 * \brief Executes a WQL query and returns the number of matching instances.
+		 * \see ExecuteKeys for how the query is projected and enumerated.
+		 * \param query The WQL query to execute. Its selected properties are ignored.
+		 * \param options Options controlling how the result is enumerated. Only batch_size and lint are used.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		[[nodiscard]] std::size_t ExecuteCount(const std::wstring_view query, const QueryOptions& options = {}) const {
+			std::size_t count = 0;
+			EnumerateKeys(query, options, [&](IWbemClassObject*) { ++count; });
+			return count;
+		}
+
+		/**
+		 * \brief Returns true if the namespace defines the given class.
+		 * Missing classes are remembered in the CapabilityCache, so that probing for optional classes only
+		 * costs a round trip to the service once per time-to-live.
+		 * \param class_name The name of the class, case-insensitively.
+		 * \throws wmipp::Exception if the class definition cannot be read for another reason, such as a
+		 * lazy Interface failing to connect.
+		 */
+		[[nodiscard]] bool HasClass(const std::wstring_view class_name) const {
+			auto& capabilities = CapabilityCache::Global();
+			if (capabilities.IsClassMissing(namespace_, class_name)) return false;
+
+			CComPtr<IWbemClassObject> definition;
+			const auto services = Services();
+			const auto result = services->GetObject(
+				bstr_t(std::wstring(class_name).c_str()), 0, nullptr, &definition, nullptr);
+			if (SUCCEEDED(result)) return true;
+
+			if (result == WBEM_E_NOT_FOUND || result == WBEM_E_INVALID_CLASS) {
+				capabilities.RecordMissingClass(namespace_, class_name);
+				return false;
+			}
+
+			throw Exception("Failed to read the class definition");
+		}
+
+		/**
+		 * \brief Analyzes a query for patterns that are known to be expensive, without executing it.
+		 * Besides the built-in knowledge about notoriously expensive classes, the key properties of the
+		 * queried class are read from the namespace, and classes whose past results on this Interface
+		 * were large are linted as such.
+		 * \see wql::Lint for more information.
+		 * \param query The WQL query to analyze.
+		 * \return The findings, ordered from the most to the least severe.
+		 * \throws wmipp::Exception if a lazy Interface fails to connect.
+		 */
+		[[nodiscard]] std::vector<wql::LintFinding> Lint(const std::wstring_view query) const {
+			const auto class_name = QueryClassName(query);
+			if (class_name.empty()) return wql::Lint(query);
+
+			auto metadata = wql::KnownClassMetadata(class_name);
+			if (!metadata) metadata = GetClassMetadata(class_name);
+
+			if (const auto statistics = GetStatistics(class_name)) {
+				metadata->large |= statistics->rows >= kLargeClassRows;
+			}
+
+			return wql::Lint(query, std::move(metadata));
+		}
+
+		/**
+		 * \brief Chooses how a streamed query should be executed, based on the statistics collected
+		 * about its class in past executions on this Interface.
+		 * Small results are materialized in a single round trip. Large results are streamed, with
+		 * batches sized to bound their memory and, for slow providers, the latency of each batch.
+		 * Without statistics, the strategy and batch size of the options are used as they are.
+		 * \param query The WQL query to plan.
+		 * \param options The options the query would be executed with.
+		 * \return The chosen plan. Strategy::Auto is never returned.
+		 */
+		[[nodiscard]] QueryPlan PlanQuery(const std::wstring_view query, const QueryOptions& options = {}) const {
+			QueryPlan plan;
+			plan.strategy = options.strategy == Strategy::Auto ? Strategy::Stream : options.strategy;
+			plan.batch_size = options.batch_size == 0 ? 1 : options.batch_size;
+
+			const auto statistics = GetStatistics(QueryClassName(query));
+			if (!statistics) return plan;
+
+			plan.from_statistics = true;
+			const auto expected_bytes = statistics->rows * statistics->bytes_per_row;
+			if (!options.rewindable && expected_bytes <= kMaterializeBytes) {
+				plan.strategy = Strategy::Materialize;
+				plan.batch_size = ClampBatchSize(statistics->rows + 1.0);
+				return plan;
+			}
+
+			plan.strategy = Strategy::Stream;
+			auto batch_size = statistics->bytes_per_row > 0.0
+				? kBatchBytes / statistics->bytes_per_row
+				: static_cast<double>(kMaxBatchSize);
+			if (statistics->seconds_per_row > 0.0) {
+				batch_size = (std::min)(batch_size, kBatchSeconds / statistics->seconds_per_row);
+			}
+
+			plan.batch_size = ClampBatchSize(batch_size);
+			return plan;
+		}
+
+		/**
+		 * \brief Retrieves the statistics collected about a class in past executions on this Interface.
+		 * \param class_name The name of the class, case-insensitively.
+		 * \return The statistics, or std::nullopt if no query on the class completed yet.
+		 */
+		[[nodiscard]] std::optional<ClassStatistics> GetStatistics(const std::wstring_view class_name) const {
+			const std::lock_guard lock(statistics_mutex_);
+			const auto it = statistics_.find(ToLower(class_name));
+			if (it == statistics_.end()) return std::nullopt;
+			return it->second.statistics;
+		}
+
+	private:
+		struct MakeSharedEnabler;
+
+		/**
+		 * \brief Per-class statistics, along with the state needed to keep them up to date.
+		 */
+		struct StatisticsEntry {
+			ClassStatistics statistics;
+			std::size_t last_rows = 0;
+			std::optional<Fingerprint> last_fingerprint;
+
+			/**
+			 * \brief The query of the last execution. Fingerprints only reflect the projected properties,
+			 * so they are only compared between executions of the same query.
+			 */
+			std::wstring last_query;
+		};
+
+		/**
+		 * \brief The weight of the most recent execution in the exponentially weighted averages.
+		 */
+		static constexpr double kStatisticsWeight = 0.25;
+
+		/**
+		 * \brief The largest expected result, in bytes, that the planner materializes at once.
+		 */
+		static constexpr double kMaterializeBytes = 1024.0 * 1024.0;
+
+		/**
+		 * \brief The planner sizes streamed batches to hold about this many bytes.
+		 */
+		static constexpr double kBatchBytes = 256.0 * 1024.0;
+
+		/**
+		 * \brief The planner sizes streamed batches to take about this many seconds to retrieve.
+		 */
+		static constexpr double kBatchSeconds = 0.05;
+
+		static constexpr ULONG kMaxBatchSize = 4096;
+
+		/**
+		 * \brief Classes that returned this many objects on average are linted as large.
+		 */
+		static constexpr double kLargeClassRows = 10000.0;
+
+		/**
+		 * \brief The number of leading objects whose size is sampled for the statistics.
+		 */
+		static constexpr std::size_t kSampledObjects = 8;
+
+		/**
+		 * \brief Queries waiting to be executed together as a single projection query.
+		 */
+		struct PendingBatch {
+			/**
+			 * \brief The text of the first query, executed as it is if no other query joins.
+			 */
+			std::wstring query;
+
+			/**
+			 * \brief The merged query, selecting the union of the properties of all members.
+			 */
+			wql::SelectQuery merged;
+			bool selects_all = false;
+			std::size_t members = 0;
+
+			/**
+			 * \brief True if any member requested an ExecutionReport, which is only handed to those that did.
+			 */
+			bool report = false;
+
+			/**
+			 * \brief The tags of the members, between which the cost of the execution is split.
+			 */
+			std::vector<std::wstring> tags;
+
+			std::promise<QueryResult> promise;
+			std::shared_future<QueryResult> result;
+
+			void Add(const wql::SelectQuery& member) {
+				++members;
+				if (selects_all) return;
+				if (member.SelectsAll()) {
+					selects_all = true;
+					merged.properties.clear();
+					return;
+				}
+
+				for (const auto& property : member.properties) {
+					const auto& selected = merged.properties;
+					const auto duplicate = std::any_of(selected.begin(), selected.end(), [&](const std::wstring& p) {
+						return wql::EqualsIgnoreCase(p, property);
+					});
+					if (!duplicate) merged.properties.push_back(property);
+				}
+			}
+		};
+
+		std::string path_;
+		ConnectMode mode_;
+
+		/**
+		 * \brief The full path of the namespace, as recorded in the CapabilityCache.
+		 */
+		std::wstring namespace_;
+
+		mutable std::once_flag connect_flag_;
+		mutable std::atomic<bool> connected_ = false;
+		mutable CO_MTA_USAGE_COOKIE mta_cookie_ = nullptr;
+
+		mutable std::mutex services_mutex_;
+		mutable CComPtr<IWbemLocator> locator_;
+		mutable CComPtr<IWbemServices> services_;
+
+		/**
+		 * \brief When the connection was last known to work, as a steady_clock tick count.
+		 */
+		mutable std::atomic<std::chrono::steady_clock::rep> last_use_ = 0;
+
+		mutable std::mutex health_mutex_;
+		mutable ConnectionHealth health_;
+
+		mutable std::mutex keep_alive_mutex_;
+		mutable std::condition_variable keep_alive_condition_;
+		mutable std::chrono::milliseconds keep_alive_interval_{};
+		mutable bool keep_alive_stop_ = false;
+		mutable std::thread keep_alive_thread_;
+
+		mutable std::mutex statistics_mutex_;
+		mutable std::unordered_map<std::wstring, StatisticsEntry> statistics_;
+
+		mutable std::mutex metadata_mutex_;
+		mutable std::unordered_map<std::wstring, wql::ClassMetadata> metadata_;
+
+		mutable std::atomic<std::int64_t> batching_window_ = 0;
+		mutable std::mutex batches_mutex_;
+		mutable std::unordered_map<std::wstring, std::shared_ptr<PendingBatch>> batches_;
+
+		Interface(const std::string_view path, const ConnectMode mode)
+				: path_(path), mode_(mode), namespace_(static_cast<const wchar_t*>(bstr_t((R"(root\)" + path_).c_str()))) {
+			if (mode_ == ConnectMode::Lazy) return;
+
+			const auto result = CoInitializeEx(nullptr, 0);
+			if (FAILED(result)) throw Exception("Failed to initialize the COM library");
+
+			try { Connect(); }
+			catch (...) {
+				CoUninitialize();
+				throw;
+			}
+		}
+
+		/**
+		 * \brief Returns the connected WMI services, connecting a lazy Interface first if needed.
+		 * Concurrent callers block until the (single) connection attempt completes. A failed
+		 * attempt is retried by the next caller.
+		 * \throws wmipp::Exception if the connection to the WMI service fails.
+		 */
+		CComPtr<IWbemServices> Services() const {
+			if (!connected_.load(std::memory_order_acquire)) {
+				std::call_once(connect_flag_, [this] {
+					// Keep the multithreaded apartment alive independently of the threads that
+					// happen to use this Interface, so that connecting on a background thread
+					// and querying on another one works without any per-thread initialization.
+					if (mta_cookie_ == nullptr && FAILED(CoIncrementMTAUsage(&mta_cookie_))) {
+						mta_cookie_ = nullptr;
+						throw Exception("Failed to initialize the COM library");
+					}
+
+					Connect();
+				});
+			}
+
+			// The keep-alive may rebuild the connection at any time, so callers hold their own reference.
+			const std::lock_guard lock(services_mutex_);
+			return services_;
+		}
+
+		/**
+		 * \brief Probes the connection every keep-alive interval, unless a query used it in the meantime.
+		 * Runs on the keep-alive thread until the Interface is destroyed.
+		 */
+		void KeepAlive() const {
+			std::unique_lock lock(keep_alive_mutex_);
+			while (!keep_alive_stop_) {
+				const auto interval = keep_alive_interval_;
+				if (interval.count() == 0) {
+					keep_alive_condition_.wait(lock);
+					continue;
+				}
+
+				const auto changed = keep_alive_condition_.wait_for(lock, interval, [&] {
+					return keep_alive_stop_ || keep_alive_interval_ != interval;
+				});
+				if (changed) continue;
+
+				const auto idle = std::chrono::steady_clock::now().time_since_epoch() -
+					std::chrono::steady_clock::duration(last_use_.load(std::memory_order_relaxed));
+				if (idle < interval) continue;
+
+				lock.unlock();
+				ProbeHealth();
+				lock.lock();
+			}
+		}
+
+		/**
+		 * \brief Executes a WQL query without batching and returns its materialized result.
+		 * \param tags The tags the cost of the execution is split between, one per batched query.
+		 * If empty, it is attributed to the tag of the options.
+		 */
+		[[nodiscard]] QueryResult ExecuteDirect(
+			const std::wstring_view query,
+			const QueryOptions& options,
+			const std::vector<std::wstring>& tags = {}) const {
+			const auto trace = options.report ? std::make_shared<detail::ExecutionTrace>() : nullptr;
+			if (trace != nullptr) {
+				trace->report.query = query;
+				trace->report.batch_size = (std::max)(options.batch_size, ULONG{1});
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			auto enumerator = Execute(query, WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, trace.get());
+			QueryResult result(shared_from_this(), enumerator, options.batch_size, trace, options.fingerprint);
+			const auto provider_time = std::chrono::steady_clock::now() - start;
+
+			std::size_t sampled_size = 0;
+			const auto sampled_count = (std::min)(result.Count(), kSampledObjects);
+			for (std::size_t i = 0; i < sampled_count; ++i) {
+				sampled_size += result[i].EstimatedSize();
+			}
+
+			const auto bytes_per_row = sampled_count == 0
+				? 0.0
+				: static_cast<double>(sampled_size) / static_cast<double>(sampled_count);
+			RecordExecution(
+				QueryClassName(query),
+				query,
+				result.Count(),
+				bytes_per_row,
+				std::chrono::steady_clock::now() - start,
+				result.fingerprint_);
+
+			TagAccounting::Entry cost;
+			cost.rows = result.Count();
+			cost.bytes = static_cast<std::uint64_t>(bytes_per_row * static_cast<double>(result.Count()));
+			cost.provider_time = provider_time;
+			TagAccounting::Global().Record(tags.empty() ? std::vector<std::wstring>{options.tag} : tags, cost);
+			return result;
+		}
+
+		/**
+		 * \brief Executes a query projected on the keys of its class, and passes each returned object to
+		 * the callback before releasing it.
+		 * Since the projected objects are not representative of whole instances, the execution is not
+		 * recorded in the statistics of the class.
+		 */
+		template <typename Callback>
+		void EnumerateKeys(const std::wstring_view query, const QueryOptions& options, Callback&& callback) const {
+			// Without the keys, WMI cannot compute __RELPATH, so fall back to selecting it when they are unknown.
+			std::wstring projected(query);
+			if (auto parsed = wql::ParseSelect(query)) {
+				parsed->properties = GetClassMetadata(parsed->class_name).keys;
+				if (parsed->properties.empty()) parsed->properties.emplace_back(L"__RELPATH");
+				projected = parsed->ToString();
+			}
+
+			if (options.lint) ThrowOnLintErrors(projected);
+
+			TagAccounting::Entry cost;
+			cost.tag = Tagged(options).tag;
+			cost.queries = 1;
+
+			const auto start = std::chrono::steady_clock::now();
+			const auto account = [&] {
+				cost.time = std::chrono::steady_clock::now() - start;
+				TagAccounting::Global().Record(cost);
+			};
+
+			CComPtr<IEnumWbemClassObject> enumerator;
+			try { enumerator = Execute(projected, WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY); }
+			catch (...) {
+				cost.failures = 1;
+				cost.provider_time = std::chrono::steady_clock::now() - start;
+				account();
+				throw;
+			}
+
+			cost.provider_time = std::chrono::steady_clock::now() - start;
+			const auto batch_size = (std::max)(options.batch_size, ULONG{1});
+			std::vector<IWbemClassObject*> objects(batch_size, nullptr);
+			while (true) {
+				ULONG returned_count = 0;
+				const auto next_start = std::chrono::steady_clock::now();
+				const auto result = enumerator->Next(WBEM_INFINITE, batch_size, objects.data(), &returned_count);
+				cost.provider_time += std::chrono::steady_clock::now() - next_start;
+				cost.rows += returned_count;
+
+				std::vector<CComPtr<IWbemClassObject>> batch(returned_count);
+				for (ULONG i = 0; i < returned_count; ++i) batch[i].Attach(objects[i]);
+				for (const auto& object : batch) callback(object.p);
+
+				if (FAILED(result) || returned_count < batch_size) {
+					break;
+				}
+			}
+
+			account();
+		}
+
+		/**
+		 * \brief Joins (or starts) the pending batch of the query's class, WHERE clause and batch size,
+		 * and waits for its merged result, projected on the properties the query selected.
+		 * \see EnableBatching for more information.
+		 */
+		[[nodiscard]] QueryResult ExecuteBatched(
+			const std::wstring_view query,
+			const wql::SelectQuery& parsed,
+			const std::chrono::microseconds window,
+			const QueryOptions& options) const {
+			// The other options either do not affect the execution, or are applied to each member's copy.
+			const auto key = ToLower(parsed.class_name) + L'\n' + parsed.where + L'\n' + std::to_wstring(options.batch_size);
+
+			std::shared_ptr<PendingBatch> batch;
+			auto leader = false;
+			{
+				const std::lock_guard lock(batches_mutex_);
+				auto& slot = batches_[key];
+				if (slot == nullptr) {
+					slot = std::make_shared<PendingBatch>();
+					slot->query = query;
+					slot->merged = parsed;
+					slot->merged.properties.clear();
+					slot->result = slot->promise.get_future().share();
+					leader = true;
+				}
+
+				batch = slot;
+				batch->Add(parsed);
+				batch->report |= options.report;
+				batch->tags.push_back(options.tag);
+			}
+
+			const auto member_result = [&] {
+				auto result = batch->result.get();
+				if (batch->members > 1) {
+					const auto projection = parsed.SelectsAll()
+						? nullptr
+						: std::make_shared<const std::vector<std::wstring>>(parsed.properties);
+					result.ProjectForMember(projection, options.report);
+				}
+
+				return result;
+			};
+
+			if (!leader) return member_result();
+
+			std::this_thread::sleep_for(window);
+
+			// Once the batch is removed, new queries start another one and the merged query is final.
+			std::wstring merged;
+			auto merged_options = options;
+			std::vector<std::wstring> tags;
+			{
+				const std::lock_guard lock(batches_mutex_);
+				batches_.erase(key);
+				merged = batch->members == 1 ? batch->query : batch->merged.ToString();
+				merged_options.report = batch->report;
+				tags = batch->tags;
+			}
+
+			try {
+				auto result = ExecuteDirect(merged, merged_options, tags);
+				if (result.trace_ != nullptr) result.trace_->report.batch_members = batch->members;
+				batch->promise.set_value(std::move(result));
+			}
+			catch (...) { batch->promise.set_exception(std::current_exception()); }
+			return member_result();
+		}
+
+		/**
+		 * \brief Folds a complete execution into the statistics of the queried class.
+		 * \param class_name The queried class. Executions without a known class are ignored.
+		 * \param query The executed query.
+		 * \param rows The number of objects in the result.
+		 * \param bytes_per_row The average estimated size of an object in the result.
+		 * \param elapsed The time from the execution of the query to the end of its enumeration.
+		 * \param fingerprint The fingerprint of the result, if it was computed.
+		 */
+		void RecordExecution(
+			const std::wstring_view class_name,
+			const std::wstring_view query,
+			const std::size_t rows,
+			const double bytes_per_row,
+			const std::chrono::steady_clock::duration elapsed,
+			const std::optional<Fingerprint>& fingerprint = std::nullopt) const {
+			if (class_name.empty()) return;
+
+			const auto seconds = std::chrono::duration<double>(elapsed).count();
+			const auto seconds_per_row = seconds / static_cast<double>((std::max)(rows, std::size_t{1}));
+
+			const std::lock_guard lock(statistics_mutex_);
+			auto& entry = statistics_[ToLower(class_name)];
+			auto& statistics = entry.statistics;
+			if (statistics.executions == 0) {
+				statistics.rows = static_cast<double>(rows);
+				statistics.bytes_per_row = bytes_per_row;
+				statistics.seconds_per_row = seconds_per_row;
+			}
+			else {
+				const auto changed = fingerprint && entry.last_fingerprint && entry.last_query == query
+					? (*fingerprint != *entry.last_fingerprint ? 1.0 : 0.0)
+					: (rows != entry.last_rows ? 1.0 : 0.0);
+				statistics.rows += kStatisticsWeight * (static_cast<double>(rows) - statistics.rows);
+				statistics.seconds_per_row += kStatisticsWeight * (seconds_per_row - statistics.seconds_per_row);
+				statistics.change_rate += kStatisticsWeight * (changed - statistics.change_rate);
+				if (rows != 0) {
+					statistics.bytes_per_row += kStatisticsWeight * (bytes_per_row - statistics.bytes_per_row);
+				}
+			}
+
+			entry.last_rows = rows;
+			entry.last_fingerprint = fingerprint;
+			entry.last_query = query;
+			++statistics.executions;
+		}
+
+		/**
+		 * \brief Returns a copy of the options tagged with the ScopedTag of the calling thread, unless
+		 * they already have a tag.
+		 */
+		static QueryOptions Tagged(const QueryOptions& options) {
+			auto tagged = options;
+			if (tagged.tag.empty()) tagged.tag = TagAccounting::CurrentTag();
+			return tagged;
+		}
+
+		/**
+		 * \brief Extracts the name of the class a WQL query selects from.
+		 * \return The class name, or an empty string if the query has no FROM clause.
+		 */
+		static std::wstring QueryClassName(const std::wstring_view query) {
+			const auto tokens = wql::Tokenize(query);
+			if (!tokens) return {};
+
+			for (std::size_t i = 0; i + 1 < tokens->size(); ++i) {
+				if (wql::IsKeyword((*tokens)[i], L"FROM") && (*tokens)[i + 1].kind == wql::TokenKind::Identifier) {
+					return std::wstring((*tokens)[i + 1].text);
+				}
+			}
+
+			return {};
+		}
+
+		/**
+		 * \brief Reads the key properties of a class from the namespace, caching them for later lints
+		 * and key projections. Classes that cannot be read are linted without metadata.
+		 */
+		wql::ClassMetadata GetClassMetadata(const std::wstring_view class_name) const {
+			const auto key = ToLower(class_name);
+			{
+				const std::lock_guard lock(metadata_mutex_);
+				if (const auto it = metadata_.find(key); it != metadata_.end()) return it->second;
+			}
+
+			wql::ClassMetadata metadata;
+			CComPtr<IWbemClassObject> definition;
+			SAFEARRAY* names = nullptr;
+			const auto services = Services();
+			if (SUCCEEDED(services->GetObject(bstr_t(std::wstring(class_name).c_str()), 0, nullptr, &definition, nullptr)) &&
+				SUCCEEDED(definition->GetNames(nullptr, WBEM_FLAG_KEYS_ONLY, nullptr, &names))) {
+				metadata.keys = detail::TakeStringArray(names);
+			}
+
+			const std::lock_guard lock(metadata_mutex_);
+			return metadata_.emplace(key, std::move(metadata)).first->second;
+		}
+
+		/**
+		 * \throws wmipp::Exception with the message of the most severe finding, if it is an error.
+		 */
+		void ThrowOnLintErrors(const std::wstring_view query) const {
+			const auto findings = Lint(query);
+			if (findings.empty() || findings.front().severity != wql::Severity::Error) return;
+
+			const auto& finding = findings.front();
+			throw Exception(std::string(bstr_t((finding.rule + L": " + finding.message).c_str())));
+		}
+
+		static std::wstring ToLower(const std::wstring_view text) {
+			std::wstring result(text);
+			std::transform(result.begin(), result.end(), result.begin(), [](const wchar_t c) {
+				return static_cast<wchar_t>(std::towlower(c));
+			});
+			return result;
+		}
+
+		static ULONG ClampBatchSize(const double batch_size) {
+			return static_cast<ULONG>(std::clamp(batch_size, 1.0, static_cast<double>(kMaxBatchSize)));
+		}
+
+		/**
+		 * \brief Executes a WQL query with the given flags and returns its enumerator.
+		 * \throws wmipp::Exception if the query fails to execute.
+		 */
+		CComPtr<IEnumWbemClassObject> Execute(
+			const std::wstring_view query,
+			const long flags,
+			detail::ExecutionTrace* trace = nullptr) const {
+			// Queries on classes known to be missing fail without a round trip to the service.
+			auto& capabilities = CapabilityCache::Global();
+			const auto class_name = capabilities.empty() ? std::wstring() : QueryClassName(query);
+			if (!class_name.empty() && capabilities.IsClassMissing(namespace_, class_name)) {
+				throw Exception("Failed to execute WQL query: the class is known to be missing");
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			const auto services = Services();
+			if (trace != nullptr) {
+				const auto now = std::chrono::steady_clock::now();
+				trace->report.connect_time = now - start;
+				start = now;
+			}
+
+			CComPtr<IEnumWbemClassObject> enumerator;
+			const auto result = services->ExecQuery(
+				bstr_t("WQL"),
+				bstr_t(std::wstring(query).c_str()),
+				flags,
+				nullptr,
+				&enumerator);
+			if (trace != nullptr) trace->report.execute_time = std::chrono::steady_clock::now() - start;
+			if (FAILED(result)) {
+				if (result == WBEM_E_INVALID_CLASS) {
+					const auto missing = class_name.empty() ? QueryClassName(query) : class_name;
+					if (!missing.empty()) capabilities.RecordMissingClass(namespace_, missing);
+				}
+
+				throw Exception("Failed to execute WQL query");
+			}
+
+			last_use_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+			return enumerator;
+		}
+
+		/**
+		 * \brief Creates the WbemLocator, connects to the namespace and sets the proxy blanket.
+		 * \throws wmipp::Exception if any of the steps fails.
+		 */
+		void Connect() const {
+			auto& capabilities = CapabilityCache::Global();
+			if (capabilities.IsNamespaceMissing(namespace_)) {
+				throw Exception("Could not connect to WMI service: the namespace is known to be missing");
+			}
+
+			CComPtr<IWbemLocator> locator;
+			auto result = CoCreateInstance(
+				CLSID_WbemLocator,
+				nullptr,
+				CLSCTX_INPROC_SERVER,
+				IID_IWbemLocator,
+				reinterpret_cast<LPVOID*>(&locator));
+			if (FAILED(result)) throw Exception("Failed to create WbemLocator object");
+
+			CComPtr<IWbemServices> services;
+			result = locator->ConnectServer(
+				bstr_t(R"(\\.\root\)") + bstr_t(path_.c_str()),
+				nullptr,
+				nullptr,
+				nullptr,
+				0,
+				nullptr,
+				nullptr,
+				&services);
+			if (FAILED(result)) {
+				if (result == WBEM_E_INVALID_NAMESPACE) capabilities.RecordMissingNamespace(namespace_);
+				throw Exception("Could not connect to WMI service");
+			}
+
+			result = CoSetProxyBlanket(
+				services,
+				RPC_C_AUTHN_DEFAULT,
+				RPC_C_AUTHZ_NONE,
+				COLE_DEFAULT_PRINCIPAL,
+				RPC_C_AUTHN_LEVEL_DEFAULT,
+				RPC_C_IMP_LEVEL_IMPERSONATE,
+				nullptr,
+				EOAC_NONE);
+			if (FAILED(result)) throw Exception("Could not set proxy blanket");
+
+			{
+				const std::lock_guard lock(services_mutex_);
+				locator_ = locator;
+				services_ = services;
+			}
+
+			connected_.store(true, std::memory_order_release);
+		}
+
+		/**
+		 * \brief Uninitializes the COM library and releases the WMI service connection.
+		 * \note This function should never be called manually, as the lifetime of the
+		 * instances of this class is automatically managed by std::shared_ptr.
+		 */
+		~Interface() {
+			{
+				const std::lock_guard lock(keep_alive_mutex_);
+				keep_alive_stop_ = true;
+				keep_alive_condition_.notify_all();
+			}
+
+			if (keep_alive_thread_.joinable()) keep_alive_thread_.join();
+
+			if (services_) services_.Release();
+			if (locator_) locator_.Release();
+
+			if (mode_ == ConnectMode::Lazy) {
+				if (mta_cookie_ != nullptr) CoDecrementMTAUsage(mta_cookie_);
+			}
+			else {
+				CoUninitialize();
+			}
+		}
+	};
+
+	/**
+	 * \see https://stackoverflow.com/questions/8147027/how-do-i-call-stdmake-shared-on-a-class-with-only-protected-or-private-const/8147213#8147213
+	 */
+	struct Interface::MakeSharedEnabler : Interface {
+		template <typename... Args>
+		explicit MakeSharedEnabler(Args&&... args) : Interface(std::forward<Args>(args)...) {}
+	};
+
+	inline std::shared_ptr<Interface> Interface::Create(const std::string_view path, const ConnectMode mode) {
+		return std::make_shared<MakeSharedEnabler>(path, mode);
+	}
 
-	inline std::shared_ptr<Interface> Interface::Create(const std::string_view path) {
-		return std::make_shared<MakeSharedEnabler>(path);
+	inline void QueryCursor::Record(const std::size_t rows) {
+		const auto average = sampled_count_ == 0
+			? 0.0
+			: static_cast<double>(sampled_size_) / static_cast<double>(sampled_count_);
+		iface_->RecordExecution(class_name_, query_, rows, average, std::chrono::steady_clock::now() - start_, fingerprint_);
 	}
 } // namespace wmipp
 
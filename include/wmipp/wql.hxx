@@ -0,0 +1,253 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ */
+
+#ifndef SD_WMIPP_WQL_HXX
+#define SD_WMIPP_WQL_HXX
+
+#include <algorithm>
+#include <cwctype>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "casefold.hxx"
+
+namespace wmipp::wql
+{
+	enum class TokenKind {
+		Identifier,
+		String,
+		Number,
+		Operator,
+		Comma,
+		LeftParen,
+		RightParen,
+		Star,
+	};
+
+	/**
+	 * \brief A lexical token of a WQL query. The text is a view into the tokenized query, and
+	 * string tokens include their quotes.
+	 */
+	struct Token {
+		TokenKind kind;
+		std::wstring_view text;
+	};
+
+	/**
+	 * \brief Compares two strings case-insensitively, as WQL does for keywords and names.
+	 */
+	[[nodiscard]] inline bool EqualsIgnoreCase(const std::wstring_view a, const std::wstring_view b) {
+		return wmipp::text::EqualsIgnoreCase(a, b);
+	}
+
+	/**
+	 * \brief Returns true if the token is the given keyword.
+	 */
+	[[nodiscard]] inline bool IsKeyword(const Token& token, const std::wstring_view keyword) {
+		return token.kind == TokenKind::Identifier && EqualsIgnoreCase(token.text, keyword);
+	}
+
+	/**
+	 * \brief Evaluates the WQL LIKE operator, case-insensitively.
+	 * \param text The text to match.
+	 * \param pattern The LIKE pattern, without quotes.
+	 * \return true if the whole text matches the pattern.
+	 * \see text::LikePattern for the supported syntax, and to compile a pattern matched against many texts.
+	 */
+	[[nodiscard]] inline bool Like(const std::wstring_view text, const std::wstring_view pattern) {
+		return wmipp::text::LikePattern(pattern).Matches(text);
+	}
+
+	/**
+	 * \brief Quotes a string as a WQL string literal, escaping quotes and backslashes.
+	 */
+	[[nodiscard]] inline std::wstring Quote(const std::wstring_view text) {
+		std::wstring result;
+		result.reserve(text.size() + 2);
+		result += L'\'';
+		for (const auto c : text) {
+			if (c == L'\'' || c == L'\\') result += L'\\';
+			result += c;
+		}
+
+		result += L'\'';
+		return result;
+	}
+
+	/**
+	 * \brief Splits a WQL query into tokens.
+	 * Identifiers may contain dots, to support embedded object properties such as TargetInstance.Name.
+	 * \param query The query to tokenize. It must outlive the returned tokens.
+	 * \return The tokens of the query, or std::nullopt if it contains an unterminated string or
+	 * an unexpected character.
+	 */
+	[[nodiscard]] inline std::optional<std::vector<Token>> Tokenize(const std::wstring_view query) {
+		const auto is_identifier = [](const wchar_t c) {
+			return std::iswalnum(c) != 0 || c == L'_' || c == L'.';
+		};
+
+		std::vector<Token> tokens;
+		std::size_t i = 0;
+		while (i < query.size()) {
+			const auto c = query[i];
+			const auto start = i;
+			if (std::iswspace(c)) {
+				++i;
+				continue;
+			}
+
+			if (c == L'\'' || c == L'"') {
+				// Strings use backslashes to escape the quote character and the backslash itself.
+				for (++i; i < query.size() && query[i] != c; ++i) {
+					if (query[i] == L'\\') ++i;
+				}
+				if (i >= query.size()) return std::nullopt;
+				tokens.push_back({TokenKind::String, query.substr(start, ++i - start)});
+			}
+			else if (std::iswdigit(c) || (c == L'-' && i + 1 < query.size() && std::iswdigit(query[i + 1]))) {
+				for (++i; i < query.size() && (std::iswalnum(query[i]) || query[i] == L'.'); ++i) { }
+				tokens.push_back({TokenKind::Number, query.substr(start, i - start)});
+			}
+			else if (std::iswalpha(c) || c == L'_') {
+				while (i < query.size() && is_identifier(query[i])) ++i;
+				tokens.push_back({TokenKind::Identifier, query.substr(start, i - start)});
+			}
+			else if (c == L'<' || c == L'>' || c == L'!' || c == L'=') {
+				++i;
+				if (i < query.size() && (query[i] == L'=' || (c == L'<' && query[i] == L'>'))) ++i;
+				tokens.push_back({TokenKind::Operator, query.substr(start, i - start)});
+			}
+			else {
+				TokenKind kind;
+				switch (c) {
+				case L',': kind = TokenKind::Comma; break;
+				case L'(': kind = TokenKind::LeftParen; break;
+				case L')': kind = TokenKind::RightParen; break;
+				case L'*': kind = TokenKind::Star; break;
+				default: return std::nullopt;
+				}
+
+				tokens.push_back({kind, query.substr(start, ++i - start)});
+			}
+		}
+
+		return tokens;
+	}
+
+	/**
+	 * \brief Joins a range of tokens with single spaces, producing a normalized form of the source text.
+	 */
+	[[nodiscard]] inline std::wstring JoinTokens(
+		const std::vector<Token>& tokens,
+		const std::size_t first,
+		const std::size_t last) {
+		std::wstring result;
+		for (auto i = first; i < last; ++i) {
+			if (i != first) result += L' ';
+			result += tokens[i].text;
+		}
+
+		return result;
+	}
+
+	/**
+	 * \brief A parsed data query of the form SELECT properties FROM class [WHERE condition].
+	 */
+	struct SelectQuery {
+		/**
+		 * \brief The selected properties, or an empty vector for SELECT *.
+		 */
+		std::vector<std::wstring> properties;
+
+		std::wstring class_name;
+
+		/**
+		 * \brief The condition of the WHERE clause with normalized whitespace, or an empty string.
+		 */
+		std::wstring where;
+
+		[[nodiscard]] bool SelectsAll() const {
+			return properties.empty();
+		}
+
+		/**
+		 * \brief Returns true if the property is selected, either by name or by SELECT *.
+		 */
+		[[nodiscard]] bool Selects(const std::wstring_view property) const {
+			return SelectsAll() || std::any_of(properties.begin(), properties.end(), [&](const std::wstring& p) {
+				return EqualsIgnoreCase(p, property);
+			});
+		}
+
+		/**
+		 * \brief Builds the WQL text of the query.
+		 */
+		[[nodiscard]] std::wstring ToString() const {
+			std::wstring result = L"SELECT ";
+			if (SelectsAll()) {
+				result += L'*';
+			}
+			else {
+				for (std::size_t i = 0; i < properties.size(); ++i) {
+					if (i != 0) result += L", ";
+					result += properties[i];
+				}
+			}
+
+			result += L" FROM ";
+			result += class_name;
+			if (!where.empty()) {
+				result += L" WHERE ";
+				result += where;
+			}
+
+			return result;
+		}
+	};
+
+	/**
+	 * \brief Parses a data query of the form SELECT properties FROM class [WHERE condition].
+	 * \param query The WQL query to parse.
+	 * \return The parsed query, or std::nullopt if the query does not have this form (for example
+	 * event queries with WITHIN, or ASSOCIATORS OF and REFERENCES OF queries).
+	 */
+	[[nodiscard]] inline std::optional<SelectQuery> ParseSelect(const std::wstring_view query) {
+		const auto tokens = Tokenize(query);
+		if (!tokens || tokens->empty() || !IsKeyword(tokens->front(), L"SELECT")) return std::nullopt;
+
+		SelectQuery result;
+		std::size_t i = 1;
+		if (i < tokens->size() && (*tokens)[i].kind == TokenKind::Star) {
+			++i;
+		}
+		else {
+			while (true) {
+				if (i >= tokens->size() || (*tokens)[i].kind != TokenKind::Identifier) return std::nullopt;
+				result.properties.emplace_back((*tokens)[i++].text);
+				if (i >= tokens->size() || (*tokens)[i].kind != TokenKind::Comma) break;
+				++i;
+			}
+		}
+
+		if (i + 1 >= tokens->size() || !IsKeyword((*tokens)[i], L"FROM")) return std::nullopt;
+		if ((*tokens)[i + 1].kind != TokenKind::Identifier) return std::nullopt;
+		result.class_name = (*tokens)[i + 1].text;
+		i += 2;
+
+		if (i < tokens->size()) {
+			if (!IsKeyword((*tokens)[i], L"WHERE") || i + 1 >= tokens->size()) return std::nullopt;
+			result.where = JoinTokens(*tokens, i + 1, tokens->size());
+		}
+
+		return result;
+	}
+} // namespace wmipp::wql
+
+#endif // SD_WMIPP_WQL_HXX
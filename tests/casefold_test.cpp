@@ -0,0 +1,252 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ *
+ * Differential test of the case-insensitive kernels and of LIKE patterns against straightforward
+ * scalar implementations, on random strings. Build and run it with and without SD_WMIPP_NO_SIMD:
+ *
+ *   g++ -std=c++17 -O2 -I include tests/casefold_test.cpp -o casefold_test && ./casefold_test
+ *   g++ -std=c++17 -O2 -I include -DSD_WMIPP_NO_SIMD tests/casefold_test.cpp -o casefold_test && ./casefold_test
+ *
+ * The SSE2 kernels only handle 16-bit code units, so they are run on char16_t strings, which covers them
+ * where wchar_t is 32-bit. Where wchar_t is 16-bit, LIKE patterns run on them as well.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <wmipp/casefold.hxx>
+
+namespace
+{
+	using wmipp::text::Fold;
+
+	int failures = 0;
+
+	void Check(const bool condition, const char* what, const std::size_t iteration) {
+		if (condition) return;
+
+		std::fprintf(stderr, "FAILED: %s (iteration %zu)\n", what, iteration);
+		++failures;
+	}
+
+	/**
+	 * \brief Units around the edges of the ASCII letters, non-ASCII letters that fold, and units whose
+	 * sign bit is set, which the SIMD comparisons treat as negative.
+	 */
+	constexpr char16_t kAlphabet[] = {
+		u'a', u'A', u'b', u'B', u'z', u'Z', u'@', u'[', u'`', u'{', u'0', u' ',
+		0x00C0, 0x00E0, 0x0130, 0x0391, 0x03B1, 0x7FFF, 0x8000, 0xD800, 0xDC00, 0xFF21, 0xFF41, 0xFFFF,
+	};
+
+	template <typename Char>
+	std::basic_string<Char> RandomString(std::mt19937& random, const std::size_t max_length) {
+		std::basic_string<Char> text(random() % (max_length + 1), Char());
+		for (auto& c : text) {
+			// Mostly ASCII letters, so that the blocks of eight units are often equal once folded.
+			const auto pick = random() % 8 < 6 ? random() % 6 : random() % std::size(kAlphabet);
+			c = static_cast<Char>(kAlphabet[pick]);
+		}
+
+		return text;
+	}
+
+	/**
+	 * \brief Flips the case of some ASCII letters, and sometimes replaces a unit.
+	 */
+	template <typename Char>
+	std::basic_string<Char> Mutate(std::mt19937& random, std::basic_string<Char> text) {
+		for (auto& c : text) {
+			if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+				if (random() % 2 == 0) c = static_cast<Char>(c ^ 0x20);
+			}
+		}
+
+		if (!text.empty() && random() % 4 == 0) {
+			text[random() % text.size()] = static_cast<Char>(kAlphabet[random() % std::size(kAlphabet)]);
+		}
+
+		return text;
+	}
+
+	std::vector<char16_t> Exact(const std::u16string& text) {
+		return std::vector<char16_t>(text.begin(), text.end());
+	}
+
+	template <typename Char>
+	bool ScalarEquals(const Char* a, const Char* b, const std::size_t size) {
+		for (std::size_t i = 0; i < size; ++i) {
+			if (Fold(a[i]) != Fold(b[i])) return false;
+		}
+
+		return true;
+	}
+
+	template <typename Char>
+	int ScalarCompare(const Char* a, const Char* b, const std::size_t size) {
+		for (std::size_t i = 0; i < size; ++i) {
+			const auto x = Fold(a[i]), y = Fold(b[i]);
+			if (x != y) return x < y ? -1 : 1;
+		}
+
+		return 0;
+	}
+
+	template <typename Char>
+	std::size_t ScalarFind(const Char* text, const std::size_t size, const Char* needle, const std::size_t length) {
+		if (length > size) return std::wstring_view::npos;
+
+		for (std::size_t i = 0; i + length <= size; ++i) {
+			if (ScalarEquals(text + i, needle, length)) return i;
+		}
+
+		return std::wstring_view::npos;
+	}
+
+	/**
+	 * \brief Matches a LIKE pattern by backtracking over the text, unit by unit.
+	 */
+	bool ScalarLike(const std::wstring_view text, const std::wstring_view pattern) {
+		if (pattern.empty()) return text.empty();
+
+		if (pattern[0] == L'%') {
+			for (std::size_t i = 0; i <= text.size(); ++i) {
+				if (ScalarLike(text.substr(i), pattern.substr(1))) return true;
+			}
+
+			return false;
+		}
+
+		if (pattern[0] == L'[') {
+			std::size_t p = 1;
+			const auto negated = p < pattern.size() && pattern[p] == L'^';
+			if (negated) ++p;
+
+			auto matched = false;
+			const auto c = text.empty() ? L'\0' : Fold(text[0]);
+			for (; p < pattern.size() && pattern[p] != L']'; ++p) {
+				if (p + 2 < pattern.size() && pattern[p + 1] == L'-' && pattern[p + 2] != L']') {
+					matched |= c >= Fold(pattern[p]) && c <= Fold(pattern[p + 2]);
+					p += 2;
+				}
+				else {
+					matched |= c == Fold(pattern[p]);
+				}
+			}
+
+			// Malformed sets match nothing, even in the rest of the pattern.
+			if (p >= pattern.size()) return false;
+			if (text.empty() || matched == negated) return false;
+			return ScalarLike(text.substr(1), pattern.substr(p + 1));
+		}
+
+		if (text.empty()) return false;
+		if (pattern[0] != L'_' && Fold(pattern[0]) != Fold(text[0])) return false;
+		return ScalarLike(text.substr(1), pattern.substr(1));
+	}
+
+	/**
+	 * \brief A malformed set anywhere in the pattern makes it match nothing.
+	 */
+	bool Malformed(const std::wstring_view pattern) {
+		for (std::size_t p = 0; p < pattern.size(); ++p) {
+			if (pattern[p] != L'[') continue;
+
+			p = pattern.find(L']', p + 1 + (p + 1 < pattern.size() && pattern[p + 1] == L'^'));
+			if (p == std::wstring_view::npos) return true;
+		}
+
+		return false;
+	}
+
+	void TestKernels(std::mt19937& random) {
+		using namespace wmipp::text::detail;
+
+		for (std::size_t iteration = 0; iteration < 200000; ++iteration) {
+			// Buffers of the exact size let a sanitizer catch loads past the end.
+			const auto a = Exact(RandomString<char16_t>(random, 40));
+			const auto b = Exact(random() % 2 == 0 ? Mutate(random, std::u16string(a.begin(), a.end())) : RandomString<char16_t>(random, 40));
+
+			// Offsets make the loads unaligned, and lengths that are not multiples of eight leave a tail.
+			const auto offset = a.empty() ? 0 : random() % (a.size() + 1);
+			const auto size = (std::min)(a.size(), b.size()) - (std::min)(offset, (std::min)(a.size(), b.size()));
+			const auto x = a.data() + offset, y = b.data() + (std::min)(offset, b.size());
+
+			Check(EqualsIgnoreCase(x, y, size) == ScalarEquals(x, y, size), "EqualsIgnoreCase", iteration);
+			Check(CompareIgnoreCase(x, y, size) == ScalarCompare(x, y, size), "CompareIgnoreCase", iteration);
+
+			const auto needle = Exact(std::u16string(b.begin() + static_cast<std::ptrdiff_t>(random() % (b.size() + 1)), b.end()));
+			const auto length = (std::min)(needle.size(), static_cast<std::size_t>(random() % 12));
+			Check(FindIgnoreCase(a.data(), a.size(), needle.data(), length) == ScalarFind(a.data(), a.size(), needle.data(), length),
+				"FindIgnoreCase", iteration);
+
+			// Needles that do occur, with their case changed.
+			if (!a.empty()) {
+				const auto begin = a.begin() + static_cast<std::ptrdiff_t>(random() % a.size());
+				const auto found = Exact(Mutate(random, std::u16string(begin, begin + (std::min)(a.end() - begin, static_cast<std::ptrdiff_t>(random() % 10)))));
+				Check(FindIgnoreCase(a.data(), a.size(), found.data(), found.size()) == ScalarFind(a.data(), a.size(), found.data(), found.size()),
+					"FindIgnoreCase (present)", iteration);
+			}
+		}
+	}
+
+	void TestLike(std::mt19937& random) {
+		constexpr wchar_t kPattern[] = {L'a', L'B', L'c', L'%', L'%', L'_', L'[', L']', L'^', L'-', L'x', 0x00C0};
+		constexpr wchar_t kText[] = {L'a', L'A', L'b', L'B', L'c', L'C', L'x', L'-', L'^', L']', 0x00C0, 0x00E0};
+
+		for (std::size_t iteration = 0; iteration < 200000; ++iteration) {
+			std::wstring pattern(random() % 10, L'\0'), text(random() % 24, L'\0');
+			for (auto& c : pattern) c = kPattern[random() % std::size(kPattern)];
+			for (auto& c : text) c = kText[random() % std::size(kText)];
+
+			const auto expected = !Malformed(pattern) && ScalarLike(text, pattern);
+			Check(wmipp::text::LikePattern(pattern).Matches(text) == expected, "LikePattern::Matches", iteration);
+		}
+	}
+
+	void TestPublic() {
+		using namespace wmipp::text;
+
+		Check(EqualsIgnoreCase(L"Win32_Process.Handle", L"WIN32_PROCESS.handle"), "EqualsIgnoreCase", 0);
+		Check(!EqualsIgnoreCase(L"Win32_Process.Handle", L"Win32_Process.Handlf"), "EqualsIgnoreCase", 0);
+		Check(CompareIgnoreCase(L"abcdefghij", L"ABCDEFGHIK") < 0, "CompareIgnoreCase", 0);
+		Check(CompareIgnoreCase(L"abcdefghij", L"ABCDEFGHI") > 0, "CompareIgnoreCase", 0);
+		Check(FindIgnoreCase(L"C:\\Windows\\System32\\SVCHOST.exe", L"svchost") == 20, "FindIgnoreCase", 0);
+		Check(LikePattern(L"svc%.EXE").Matches(L"svchost.exe"), "LikePattern", 0);
+		Check(!LikePattern(L"a[bc").Matches(L"abc"), "LikePattern", 0);
+
+		// Non-ASCII letters fold the same way whatever the locale, which this test leaves as "C".
+		Check(EqualsIgnoreCase(L"\u00C9COLE \u0391\u0392\u0393 \u0416\u0401 \uFF37\uFF2D\uFF29", L"\u00E9cole \u03B1\u03B2\u03B3 \u0436\u0451 \uFF57\uFF4D\uFF49"),
+			"EqualsIgnoreCase (non-ASCII)", 0);
+		Check(Fold(L'\u00D7') == L'\u00D7' && Fold(L'\u0130') == L'i' && Fold(L'\u0178') == L'\u00FF', "Fold (exceptions)", 0);
+		Check(Fold(L'\u0100') == L'\u0101' && Fold(L'\u0139') == L'\u013A' && Fold(L'\u013A') == L'\u013A', "Fold (Latin Extended-A)", 0);
+		Check(Fold(L'\u0386') == L'\u03AC' && Fold(L'\u038F') == L'\u03CE' && Fold(L'\u03A2') == L'\u03A2', "Fold (Greek)", 0);
+	}
+} // namespace
+
+int main() {
+	std::mt19937 random(20240611);
+	TestPublic();
+	TestKernels(random);
+	TestLike(random);
+
+#if defined(SD_WMIPP_SSE2)
+	const char* kernels = "SSE2";
+#else
+	const char* kernels = "scalar";
+#endif
+
+	if (failures != 0) return EXIT_FAILURE;
+	std::printf("casefold_test: ok (%s kernels)\n", kernels);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ *
+ * Test of the SMBIOS decoder on the raw tables in tests/data, which have the layout of
+ * MSSmBios_RawSMBiosTables.SMBiosData and of /sys/firmware/dmi/tables/DMI on Linux:
+ *
+ *   g++ -std=c++17 -O2 -I include tests/smbios_test.cpp -o smbios_test && ./smbios_test [tests/data]
+ *
+ * The tables were written structure by structure after real firmware: smbios-2.8-qemu.bin after the tables of
+ * QEMU's SeaBIOS, and smbios-3.3-server.bin after the AMI firmware of a server with two 128-core processors
+ * and 64 GiB modules. Dumps of other machines can be added from /sys/firmware/dmi/tables/DMI.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <wmipp/smbios.hxx>
+
+namespace
+{
+	using namespace wmipp::smbios;
+
+	int failures = 0;
+
+	template <typename T, typename U>
+	void Expect(const T& actual, const U& expected, const char* what) {
+		if (actual == expected) return;
+
+		std::fprintf(stderr, "FAILED: %s\n", what);
+		++failures;
+	}
+
+	std::string directory;
+
+	std::vector<char> Load(const char* name) {
+		std::ifstream input(directory + "/" + name, std::ios::binary);
+		if (!input) {
+			std::fprintf(stderr, "FAILED: cannot read %s/%s\n", directory.c_str(), name);
+			std::exit(EXIT_FAILURE);
+		}
+
+		return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+	}
+
+	void TestSmbios28() {
+		const auto data = Load("smbios-2.8-qemu.bin");
+		const Table table(data.data(), data.size());
+
+		// Every structure up to the end-of-table one, which is not iterated.
+		Expect(std::distance(table.begin(), table.end()), 8, "2.8: structure count");
+
+		const auto bios = DecodeBios(*table.Find(Type::Bios));
+		Expect(bios.vendor, "SeaBIOS", "2.8: BIOS vendor");
+		Expect(bios.version, "rel-1.16.3-0-ga6ed6b701f0a-prebuilt.qemu.org", "2.8: BIOS version");
+		Expect(bios.release_date, "04/01/2014", "2.8: BIOS release date");
+		Expect(bios.major_release, std::optional<std::uint8_t>(0), "2.8: BIOS major release");
+		Expect(bios.minor_release, std::optional<std::uint8_t>(0), "2.8: BIOS minor release");
+
+		const auto system = table.Find(Type::System);
+		const auto decoded = DecodeSystem(*system);
+		Expect(decoded.manufacturer, "QEMU", "2.8: system manufacturer");
+		Expect(decoded.product_name, "Standard PC (i440FX + PIIX, 1996)", "2.8: system product name");
+		Expect(decoded.serial_number, "", "2.8: absent serial number");
+		Expect(decoded.uuid, std::optional<std::string>("6A8B3F0E-1C2D-4E5F-8A9B-0C1D2E3F4A5B"), "2.8: system UUID");
+
+		// The first three fields of the UUID are stored little-endian, and the last two as bytes.
+		Expect(system->Byte(0x08), std::optional<std::uint8_t>(0x0E), "2.8: first byte of the stored UUID");
+		Expect(system->Byte(0x10), std::optional<std::uint8_t>(0x8A), "2.8: eighth byte of the stored UUID");
+
+		// SMBIOS 2.8 processors have no 16-bit counts, so the 8-bit ones are the counts.
+		const auto processor = DecodeProcessor(*table.Find(Type::Processor));
+		Expect(processor.socket, "CPU 0", "2.8: processor socket");
+		Expect(processor.max_speed_mhz, std::optional<std::uint16_t>(2000), "2.8: processor maximum speed");
+		Expect(processor.core_count, std::optional<std::uint16_t>(4), "2.8: processor core count");
+		Expect(processor.thread_count, std::optional<std::uint16_t>(4), "2.8: processor thread count");
+
+		const auto modules = table.FindAll(Type::MemoryDevice);
+		Expect(modules.size(), 1u, "2.8: memory device count");
+
+		const auto memory = DecodeMemoryDevice(modules[0]);
+		Expect(memory.size, std::optional<std::uint64_t>(16ull << 30), "2.8: memory size");
+		Expect(memory.device_locator, "DIMM 0", "2.8: memory device locator");
+		Expect(memory.bank_locator, "", "2.8: absent memory bank locator");
+		Expect(memory.manufacturer, "QEMU", "2.8: memory manufacturer");
+	}
+
+	void TestSmbios33() {
+		const auto data = Load("smbios-3.3-server.bin");
+		const Table table(data.data(), data.size());
+		Expect(std::distance(table.begin(), table.end()), 11, "3.3: structure count");
+
+		const auto bios = DecodeBios(*table.Find(Type::Bios));
+		Expect(bios.vendor, "American Megatrends International, LLC.", "3.3: BIOS vendor");
+		Expect(bios.version, "2.1", "3.3: BIOS version");
+		Expect(bios.release_date, "11/14/2023", "3.3: BIOS release date");
+		Expect(bios.major_release, std::optional<std::uint8_t>(5), "3.3: BIOS major release");
+		Expect(bios.minor_release, std::optional<std::uint8_t>(27), "3.3: BIOS minor release");
+
+		const auto system = DecodeSystem(*table.Find(Type::System));
+		Expect(system.manufacturer, "To Be Filled By O.E.M.", "3.3: system manufacturer");
+		Expect(system.product_name, "H13DSH", "3.3: system product name");
+		Expect(system.sku_number, "Default string", "3.3: system SKU number");
+		Expect(system.family, "To Be Filled By O.E.M.", "3.3: system family");
+
+		// Stored as 33 22 11 00 55 44 77 66 88 99 AA BB CC DD EE FF.
+		Expect(system.uuid, std::optional<std::string>("00112233-4455-6677-8899-AABBCCDDEEFF"), "3.3: system UUID");
+
+		const auto chassis = DecodeChassis(*table.Find(Type::Chassis));
+		Expect(chassis.type, std::optional<std::uint8_t>(0x17), "3.3: rack mount chassis");
+
+		// 256 threads do not fit in the 8-bit count, which is 0xFF, so the SMBIOS 3.0 count is used.
+		const auto processors = table.FindAll(Type::Processor);
+		Expect(processors.size(), 2u, "3.3: processor count");
+		for (const auto& structure : processors) {
+			Expect(structure.Byte(0x25), std::optional<std::uint8_t>(0xFF), "3.3: 8-bit thread count");
+
+			const auto processor = DecodeProcessor(structure);
+			Expect(processor.version, "AMD EPYC 9754 128-Core Processor", "3.3: processor version");
+			Expect(processor.current_speed_mhz, std::optional<std::uint16_t>(2250), "3.3: processor current speed");
+			Expect(processor.core_count, std::optional<std::uint16_t>(128), "3.3: processor core count");
+			Expect(processor.thread_count, std::optional<std::uint16_t>(256), "3.3: processor thread count");
+		}
+
+		Expect(DecodeProcessor(processors[1]).socket, "P1", "3.3: second processor socket");
+
+		const auto modules = table.FindAll(Type::MemoryDevice);
+		Expect(modules.size(), 4u, "3.3: memory device count");
+
+		// 64 GiB modules store 0x7FFF in the size field, and their size in megabytes in the extended one.
+		const auto first = DecodeMemoryDevice(modules[0]);
+		Expect(modules[0].Word(0x0C), std::optional<std::uint16_t>(0x7FFF), "3.3: size field of a 64 GiB module");
+		Expect(first.size, std::optional<std::uint64_t>(64ull << 30), "3.3: extended memory size");
+		Expect(first.memory_type, std::optional<std::uint8_t>(0x22), "3.3: DDR5 memory type");
+		Expect(first.speed_mts, std::optional<std::uint16_t>(4800), "3.3: memory speed");
+		Expect(first.configured_speed_mts, std::optional<std::uint16_t>(4800), "3.3: configured memory speed");
+		Expect(first.part_number, "M321R8GA0BB0-CQKVG", "3.3: memory part number");
+		Expect(DecodeMemoryDevice(modules[1]).size, std::optional<std::uint64_t>(64ull << 30), "3.3: second extended memory size");
+
+		const auto empty = DecodeMemoryDevice(modules[2]);
+		Expect(empty.size, std::optional<std::uint64_t>(0), "3.3: empty slot");
+		Expect(empty.device_locator, "P0 CHANNEL C", "3.3: empty slot locator");
+
+		Expect(DecodeMemoryDevice(modules[3]).size, std::optional<std::uint64_t>(16ull << 30), "3.3: memory size below 32 GiB");
+	}
+
+	void TestTruncated() {
+		const auto data = Load("smbios-3.3-server.bin");
+
+		// A table cut in the strings of its last memory device, before the end-of-table structure (6 bytes),
+		// stops before that device instead of reading past the end.
+		const Table table(data.data(), data.size() - 10);
+		Expect(std::distance(table.begin(), table.end()), 10, "truncated table");
+		Expect(table.FindAll(Type::MemoryDevice).size(), 3u, "truncated table: memory devices");
+	}
+} // namespace
+
+int main(const int argc, char* argv[]) {
+	if (argc > 1) {
+		directory = argv[1];
+	}
+	else {
+		// By default, the data next to this file.
+		const std::string_view file = __FILE__;
+		const auto slash = file.find_last_of("/\\");
+		directory = std::string(slash == std::string_view::npos ? "." : file.substr(0, slash)) + "/data";
+	}
+
+	TestSmbios28();
+	TestSmbios33();
+	TestTruncated();
+
+	if (failures != 0) return EXIT_FAILURE;
+	std::printf("smbios_test: ok\n");
+	return EXIT_SUCCESS;
+}
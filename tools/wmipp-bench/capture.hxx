@@ -0,0 +1,238 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ *
+ * Captured query results, which wmipp-bench records on Windows with --capture and replays on any
+ * platform with --replay.
+ *
+ * A capture is a UTF-8 text file. Its first line is "wmipp-capture 1", followed by a "query" line with
+ * the text of the query, a "columns" line with the name and numeric CIM type of every property (as in
+ * "Name:8"), and one line per object. Every line is made of fields separated by tabs. In fields, "\N"
+ * is a null, backslashes, tabs, carriage returns and line feeds are escaped as "\\", "\t", "\r" and
+ * "\n", and the elements of arrays are separated by commas, which are escaped as "\," within elements.
+ * An empty array is "\E". Numbers are written in decimal, and booleans as 0 or 1.
+ */
+
+#ifndef SD_WMIPP_BENCH_CAPTURE_HXX
+#define SD_WMIPP_BENCH_CAPTURE_HXX
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <wmipp/columnar.hxx>
+#include <wmipp/value.hxx>
+
+namespace wmipp::bench
+{
+	/**
+	 * \brief The result of a query, with the values of every object in the order of the columns.
+	 */
+	struct Capture {
+		std::wstring query;
+		std::vector<std::wstring> names;
+		std::vector<CimType> types;
+		std::vector<std::vector<Value>> rows;
+	};
+
+	namespace detail
+	{
+		inline constexpr std::string_view kCaptureHeader = "wmipp-capture 1";
+
+		inline void AppendEscaped(std::string& line, const std::wstring_view text, const bool in_array) {
+			std::string utf8;
+			wmipp::detail::AppendUtf8(utf8, text);
+			for (const auto c : utf8) {
+				switch (c) {
+				case '\\': line += "\\\\"; break;
+				case '\t': line += "\\t"; break;
+				case '\r': line += "\\r"; break;
+				case '\n': line += "\\n"; break;
+				case ',':
+					if (in_array) line += "\\,";
+					else line += c;
+					break;
+				default: line += c;
+				}
+			}
+		}
+
+		inline void AppendScalar(std::string& line, const Value& value, const bool in_array) {
+			if (const auto text = value.AsString()) {
+				AppendEscaped(line, *text, in_array);
+			}
+			else if (value.GetElementType() == CimType::Boolean) {
+				line += value.AsBool().value_or(false) ? "1" : "0";
+			}
+			else if (value.GetElementType() == CimType::Real32 || value.GetElementType() == CimType::Real64) {
+				char number[32];
+				std::snprintf(number, sizeof(number), "%.17g", value.AsDouble().value_or(0.0));
+				line += number;
+			}
+			else if (const auto integer = value.AsInt64()) {
+				line += std::to_string(*integer);
+			}
+			else if (const auto unsigned_integer = value.AsUInt64()) {
+				line += std::to_string(*unsigned_integer);
+			}
+		}
+
+		inline void AppendField(std::string& line, const Value& value) {
+			if (value.IsNull()) {
+				line += "\\N";
+			}
+			else if (value.IsArray()) {
+				if (value.Size() == 0) line += "\\E";
+				for (std::size_t i = 0; i < value.Size(); ++i) {
+					if (i > 0) line += ',';
+					AppendScalar(line, value[i], true);
+				}
+			}
+			else {
+				AppendScalar(line, value, false);
+			}
+		}
+
+		/**
+		 * \brief Splits a line on its unescaped separators, leaving the escapes in place.
+		 */
+		inline std::vector<std::string_view> SplitEscaped(const std::string_view line, const char separator) {
+			std::vector<std::string_view> parts;
+			std::size_t start = 0;
+			for (std::size_t i = 0; i < line.size(); ++i) {
+				if (line[i] == '\\') {
+					++i;
+				}
+				else if (line[i] == separator) {
+					parts.push_back(line.substr(start, i - start));
+					start = i + 1;
+				}
+			}
+
+			parts.push_back(line.substr(start));
+			return parts;
+		}
+
+		inline std::wstring Unescape(const std::string_view field) {
+			std::string utf8;
+			for (std::size_t i = 0; i < field.size(); ++i) {
+				if (field[i] != '\\' || i + 1 == field.size()) {
+					utf8 += field[i];
+					continue;
+				}
+
+				switch (field[++i]) {
+				case 't': utf8 += '\t'; break;
+				case 'r': utf8 += '\r'; break;
+				case 'n': utf8 += '\n'; break;
+				default: utf8 += field[i];
+				}
+			}
+
+			return wmipp::detail::FromUtf8(utf8);
+		}
+
+		/**
+		 * \brief Parses a scalar as a value of the given type, as wmipp::MakeValue would have converted it.
+		 */
+		inline Value ParseScalar(const std::string_view field, const CimType type) {
+			const std::string text(field);
+			switch (type) {
+			case CimType::Boolean: return text == "1";
+			case CimType::Real32: return static_cast<float>(std::strtod(text.c_str(), nullptr));
+			case CimType::Real64: return std::strtod(text.c_str(), nullptr);
+			case CimType::SInt8: return static_cast<std::int8_t>(std::strtoll(text.c_str(), nullptr, 10));
+			case CimType::SInt16: return static_cast<std::int16_t>(std::strtoll(text.c_str(), nullptr, 10));
+			case CimType::SInt32: return static_cast<std::int32_t>(std::strtoll(text.c_str(), nullptr, 10));
+			case CimType::SInt64: return static_cast<std::int64_t>(std::strtoll(text.c_str(), nullptr, 10));
+			case CimType::UInt8: return static_cast<std::uint8_t>(std::strtoull(text.c_str(), nullptr, 10));
+			case CimType::UInt16:
+			case CimType::Char16: return static_cast<std::uint16_t>(std::strtoull(text.c_str(), nullptr, 10));
+			case CimType::UInt32: return static_cast<std::uint32_t>(std::strtoull(text.c_str(), nullptr, 10));
+			case CimType::UInt64: return static_cast<std::uint64_t>(std::strtoull(text.c_str(), nullptr, 10));
+			default: return Value(Unescape(field), type);
+			}
+		}
+
+		inline Value ParseField(const std::string_view field, const CimType type) {
+			const auto element_type = static_cast<CimType>(
+				static_cast<std::uint16_t>(type) & ~static_cast<std::uint16_t>(CimType::FlagArray));
+			if (field == "\\N") return Value::Null(type);
+			if (element_type == type) return ParseScalar(field, type);
+			if (field == "\\E") return Value::Array({}, element_type);
+
+			std::vector<Value> elements;
+			for (const auto element : SplitEscaped(field, ',')) elements.push_back(ParseScalar(element, element_type));
+			return Value::Array(std::move(elements), element_type);
+		}
+	} // namespace detail
+
+	inline void WriteCapture(std::ostream& output, const Capture& capture) {
+		std::string line(detail::kCaptureHeader);
+		line += "\nquery\t";
+		detail::AppendEscaped(line, capture.query, false);
+
+		line += "\ncolumns";
+		for (std::size_t i = 0; i < capture.names.size(); ++i) {
+			line += '\t';
+			detail::AppendEscaped(line, capture.names[i], false);
+			line += ':' + std::to_string(static_cast<unsigned>(capture.types[i]));
+		}
+
+		output << line << '\n';
+		for (const auto& row : capture.rows) {
+			line.clear();
+			for (std::size_t i = 0; i < row.size(); ++i) {
+				if (i > 0) line += '\t';
+				detail::AppendField(line, row[i]);
+			}
+
+			output << line << '\n';
+		}
+	}
+
+	/**
+	 * \return The capture, or std::nullopt if the input is not a capture.
+	 */
+	inline std::optional<Capture> ReadCapture(std::istream& input) {
+		std::string line;
+		if (!std::getline(input, line) || line != detail::kCaptureHeader) return std::nullopt;
+
+		Capture capture;
+		if (!std::getline(input, line) || line.rfind("query\t", 0) != 0) return std::nullopt;
+		capture.query = detail::Unescape(std::string_view(line).substr(6));
+
+		if (!std::getline(input, line) || line.rfind("columns", 0) != 0) return std::nullopt;
+		const auto columns = detail::SplitEscaped(line, '\t');
+		for (std::size_t i = 1; i < columns.size(); ++i) {
+			const auto colon = columns[i].rfind(':');
+			if (colon == std::string_view::npos) return std::nullopt;
+
+			capture.names.push_back(detail::Unescape(columns[i].substr(0, colon)));
+			const std::string type(columns[i].substr(colon + 1));
+			capture.types.push_back(static_cast<CimType>(std::strtoul(type.c_str(), nullptr, 10)));
+		}
+
+		while (std::getline(input, line)) {
+			const auto fields = detail::SplitEscaped(line, '\t');
+			if (fields.size() != capture.names.size()) return std::nullopt;
+
+			auto& row = capture.rows.emplace_back();
+			row.reserve(fields.size());
+			for (std::size_t i = 0; i < fields.size(); ++i) row.push_back(detail::ParseField(fields[i], capture.types[i]));
+		}
+
+		return capture;
+	}
+} // namespace wmipp::bench
+
+#endif // SD_WMIPP_BENCH_CAPTURE_HXX
@@ -0,0 +1,800 @@
+/**
+ * WMI++ takes away the pain from interfacing with
+ * the Windows Management Instrumentation in C++.
+ *
+ * This file is part of WMI++ and is distributed under
+ * the same MIT license, see wmipp.hxx for the full text.
+ *
+ * wmipp-bench runs a WQL query repeatedly with a choice of execution strategies and batch
+ * sizes, and reports percentiles of its connect, execute, first-row and total times.
+ * With --rewindable, it also measures a second pass over every result, to compare rewinding a cursor
+ * against iterating a materialized result again. With --parse-paths, it also measures how fast the
+ * object paths of the result are parsed.
+ *
+ * On Windows, the query runs against WMI, and --capture saves its result to a file. With --replay,
+ * a captured result is replayed instead, on any platform, which measures the client-side costs of
+ * the strategies (materializing, streaming and converting to columns) without WMI.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#include <wmipp/wmipp.hxx>
+#else
+#include <wmipp/columnar.hxx>
+#include <wmipp/object_path.hxx>
+#include <wmipp/value.hxx>
+#endif
+
+#include "capture.hxx"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum class Mode {
+		/**
+		 * \brief Interface::ExecuteQuery, which always materializes a QueryResult.
+		 */
+		Result,
+		Materialize,
+		Stream,
+		Auto,
+
+		/**
+		 * \brief QueryCursor::ToColumnar, which converts a streamed result to columns.
+		 */
+		Columnar,
+	};
+
+	struct Configuration {
+		Mode mode = Mode::Result;
+		std::uint32_t batch_size = 32;
+	};
+
+	struct Arguments {
+		std::wstring query;
+		std::string path = "cimv2";
+		std::vector<Mode> modes{Mode::Result};
+		std::vector<std::uint32_t> batch_sizes{32};
+		std::size_t iterations = 20;
+		std::size_t warmup = 2;
+		std::size_t path_parses = 0;
+		bool reuse_connection = false;
+		bool rewindable = false;
+		bool json = false;
+
+		/**
+		 * \brief The capture to replay instead of querying WMI, if any.
+		 */
+		std::wstring replay;
+
+		/**
+		 * \brief The file to capture the result of the query to, if any.
+		 */
+		std::wstring capture;
+	};
+
+	/**
+	 * \brief The measurements of a single execution of the query, in seconds.
+	 */
+	struct Sample {
+		double connect = 0.0;
+		double execute = 0.0;
+		double first_row = 0.0;
+		double total = 0.0;
+
+		/**
+		 * \brief The time of the second pass over the result, with --rewindable.
+		 */
+		double second_pass = 0.0;
+		std::size_t rows = 0;
+		std::size_t bytes = 0;
+	};
+
+	struct Summary {
+		double p50 = 0.0;
+		double p90 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	const char* ModeName(const Mode mode) {
+		switch (mode) {
+		case Mode::Result: return "result";
+		case Mode::Materialize: return "materialize";
+		case Mode::Stream: return "stream";
+		case Mode::Auto: return "auto";
+		case Mode::Columnar: return "columnar";
+		}
+
+		return "";
+	}
+
+	std::optional<Mode> ParseMode(const std::wstring_view text) {
+		if (text == L"result") return Mode::Result;
+		if (text == L"materialize") return Mode::Materialize;
+		if (text == L"stream") return Mode::Stream;
+		if (text == L"auto") return Mode::Auto;
+		if (text == L"columnar") return Mode::Columnar;
+		return std::nullopt;
+	}
+
+	std::vector<std::wstring_view> Split(std::wstring_view text) {
+		std::vector<std::wstring_view> parts;
+		while (true) {
+			const auto comma = text.find(L',');
+			parts.push_back(text.substr(0, comma));
+			if (comma == std::wstring_view::npos) return parts;
+			text.remove_prefix(comma + 1);
+		}
+	}
+
+	std::string ToUtf8(const std::wstring_view text) {
+		std::string result;
+		wmipp::detail::AppendUtf8(result, text);
+		return result;
+	}
+
+	std::string JsonString(const std::string_view text) {
+		std::string result = "\"";
+		for (const auto c : text) {
+			switch (c) {
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+					result += escaped;
+				}
+				else {
+					result += c;
+				}
+			}
+		}
+
+		return result + "\"";
+	}
+
+	void PrintUsage() {
+		std::fprintf(stderr,
+			"usage: wmipp-bench [options] <query>\n"
+			"       wmipp-bench [options] --replay <file> [<query>]\n"
+			"\n"
+			"options:\n"
+			"  --namespace <path>       the namespace to connect to (default: cimv2)\n"
+			"  --strategy <list>        comma-separated strategies among result, materialize,\n"
+			"                           stream, auto and columnar (default: result); auto only\n"
+			"                           plans from past executions with --reuse-connection\n"
+			"  --batch-size <list>      comma-separated batch sizes (default: 32)\n"
+			"  --iterations <count>     the number of measured executions (default: 20)\n"
+			"  --warmup <count>         the number of unmeasured executions (default: 2)\n"
+			"  --reuse-connection       connect once instead of on every execution\n"
+			"  --rewindable             make a second pass over every result: cursors are\n"
+			"                           rewindable and rewound, and materialized results are\n"
+			"                           iterated again (rewindable cursors never materialize)\n"
+			"  --parse-paths <count>    parse the object paths of the result <count> times\n"
+			"  --capture <file>         save the result of the query to <file>, and exit\n"
+			"  --replay <file>          replay the result captured in <file> instead of\n"
+			"                           querying WMI, which also works off Windows\n"
+			"  --json                   print the results as JSON\n");
+	}
+
+	std::optional<Arguments> ParseArguments(const std::vector<std::wstring>& argv) {
+		Arguments arguments;
+		for (std::size_t i = 1; i < argv.size(); ++i) {
+			const std::wstring_view argument = argv[i];
+			const auto value = [&]() -> std::optional<std::wstring_view> {
+				if (i + 1 >= argv.size()) return std::nullopt;
+				return argv[++i];
+			};
+
+			if (argument == L"--json") {
+				arguments.json = true;
+			}
+			else if (argument == L"--reuse-connection") {
+				arguments.reuse_connection = true;
+			}
+			else if (argument == L"--rewindable") {
+				arguments.rewindable = true;
+			}
+			else if (argument == L"--namespace") {
+				const auto path = value();
+				if (!path) return std::nullopt;
+				arguments.path = ToUtf8(*path);
+			}
+			else if (argument == L"--replay" || argument == L"--capture") {
+				const auto file = value();
+				if (!file || file->empty()) return std::nullopt;
+				(argument == L"--replay" ? arguments.replay : arguments.capture) = *file;
+			}
+			else if (argument == L"--strategy") {
+				const auto list = value();
+				if (!list) return std::nullopt;
+
+				arguments.modes.clear();
+				for (const auto part : Split(*list)) {
+					const auto mode = ParseMode(part);
+					if (!mode) return std::nullopt;
+					arguments.modes.push_back(*mode);
+				}
+			}
+			else if (argument == L"--batch-size") {
+				const auto list = value();
+				if (!list) return std::nullopt;
+
+				arguments.batch_sizes.clear();
+				for (const auto part : Split(*list)) {
+					const auto batch_size = std::wcstoul(std::wstring(part).c_str(), nullptr, 10);
+					if (batch_size == 0) return std::nullopt;
+					arguments.batch_sizes.push_back(static_cast<std::uint32_t>(batch_size));
+				}
+			}
+			else if (argument == L"--iterations" || argument == L"--warmup") {
+				const auto count = value();
+				if (!count) return std::nullopt;
+
+				const auto parsed = std::wcstoul(std::wstring(*count).c_str(), nullptr, 10);
+				(argument == L"--iterations" ? arguments.iterations : arguments.warmup) = parsed;
+			}
+			else if (argument == L"--parse-paths") {
+				const auto count = value();
+				if (!count) return std::nullopt;
+
+				arguments.path_parses = std::wcstoul(std::wstring(*count).c_str(), nullptr, 10);
+				if (arguments.path_parses == 0) return std::nullopt;
+			}
+			else if (argument.substr(0, 2) == L"--" || !arguments.query.empty()) {
+				return std::nullopt;
+			}
+			else {
+				arguments.query = argument;
+			}
+		}
+
+		// A replay takes its query from the capture, and only replays can run off Windows.
+		if (!arguments.replay.empty() && !arguments.capture.empty()) return std::nullopt;
+		if ((arguments.query.empty() && arguments.replay.empty()) || arguments.iterations == 0) return std::nullopt;
+#if !defined(_WIN32)
+		if (arguments.replay.empty()) return std::nullopt;
+#endif
+
+		return arguments;
+	}
+
+	double Seconds(const Clock::duration duration) {
+		return std::chrono::duration<double>(duration).count();
+	}
+
+	/**
+	 * \brief Approximates the number of bytes held by a value, including the text and elements it owns.
+	 */
+	std::size_t ValueSize(const wmipp::Value& value) {
+		auto size = sizeof(wmipp::Value);
+		if (const auto text = value.AsString()) size += text->size() * sizeof(wchar_t);
+		if (value.IsArray()) {
+			for (const auto& element : value) size += ValueSize(element);
+		}
+
+		return size;
+	}
+
+	std::size_t RowSize(const std::vector<wmipp::Value>& row) {
+		std::size_t size = 0;
+		for (const auto& value : row) size += ValueSize(value);
+		return size;
+	}
+
+	/**
+	 * \brief Collects the measurements of a single execution into a Sample.
+	 * Sizing the rows and the second pass over the result are kept out of the first-row and total times.
+	 */
+	class Meter {
+	public:
+		explicit Meter(Sample& sample) : sample_(sample), start_(Clock::now()), connected_(start_) {}
+
+		void Connected() {
+			connected_ = Clock::now();
+			sample_.connect = Seconds(connected_ - start_);
+		}
+
+		/**
+		 * \brief Counts a row of the result.
+		 * \param size Computes the size of the row, out of the measured times.
+		 */
+		template <typename F>
+		void Count(F&& size) {
+			if (!first_row_) first_row_ = Clock::now();
+
+			const auto sizing_start = Clock::now();
+			sample_.bytes += size();
+			++sample_.rows;
+			sizing_ += Clock::now() - sizing_start;
+		}
+
+		/**
+		 * \brief Counts the rows of a table, whose first row is only available once the table is complete.
+		 */
+		void CountTable(const wmipp::ColumnarTable& table) {
+			std::vector<wmipp::Value> row(table.ColumnCount());
+			for (std::size_t i = 0; i < table.RowCount(); ++i) {
+				Count([&] {
+					for (std::size_t column = 0; column < row.size(); ++column) row[column] = table.GetColumn(column).GetAt(i);
+					return RowSize(row);
+				});
+			}
+		}
+
+		template <typename F>
+		void SecondPass(F&& pass) {
+			const auto pass_start = Clock::now();
+			pass();
+			second_pass_ += Clock::now() - pass_start;
+		}
+
+		void Finish(const Clock::duration execute = {}) {
+			const auto end = Clock::now() - sizing_ - second_pass_;
+			sample_.execute = Seconds(execute);
+			sample_.second_pass = Seconds(second_pass_);
+			sample_.first_row = Seconds((first_row_ ? *first_row_ : end) - connected_);
+			sample_.total = Seconds(end - start_);
+		}
+
+	private:
+		Sample& sample_;
+		Clock::time_point start_;
+		Clock::time_point connected_;
+		std::optional<Clock::time_point> first_row_;
+		Clock::duration sizing_{};
+		Clock::duration second_pass_{};
+	};
+
+	/**
+	 * \brief The source of the results that are measured.
+	 */
+	class Backend {
+	public:
+		virtual ~Backend() = default;
+
+		/**
+		 * \brief Executes the query once and enumerates its whole result, twice with --rewindable.
+		 */
+		virtual Sample Run(const Configuration& configuration) = 0;
+
+		/**
+		 * \brief Returns the object paths of the query's result.
+		 */
+		virtual std::vector<std::wstring> GetPaths() = 0;
+
+		/**
+		 * \brief Returns the JSON member that describes the source, such as its namespace.
+		 */
+		[[nodiscard]] virtual std::string DescribeJson() const = 0;
+	};
+
+	/**
+	 * \brief Replays a captured result. Every execution copies the captured rows the way its strategy
+	 * retrieves objects from WMI: all at once, a batch at a time, or into a ColumnarTable. It connects
+	 * and executes nothing, so it measures the client-side costs of the strategies alone.
+	 */
+	class ReplayBackend final : public Backend {
+	public:
+		ReplayBackend(const Arguments& arguments, wmipp::bench::Capture capture)
+			: arguments_(arguments), capture_(std::move(capture)) {}
+
+		Sample Run(const Configuration& configuration) override {
+			Sample sample;
+			Meter meter(sample);
+			meter.Connected();
+
+			// Counting the values visited by the second pass keeps it from being elided.
+			volatile std::size_t visited = 0;
+			const auto& rows = capture_.rows;
+			if (configuration.mode == Mode::Result || configuration.mode == Mode::Materialize) {
+				const std::vector<std::vector<wmipp::Value>> result(rows.begin(), rows.end());
+				for (const auto& row : result) meter.Count([&] { return RowSize(row); });
+
+				if (arguments_.rewindable) {
+					meter.SecondPass([&] {
+						for (const auto& row : result) visited = visited + row.size();
+					});
+				}
+			}
+			else if (configuration.mode == Mode::Columnar) {
+				wmipp::ColumnarTable table(capture_.names);
+				for (const auto& row : rows) table.AppendRow(row);
+				meter.CountTable(table);
+
+				if (arguments_.rewindable) {
+					meter.SecondPass([&] {
+						for (std::size_t column = 0; column < table.ColumnCount(); ++column) {
+							const auto& values = table.GetColumn(column);
+							for (std::size_t i = 0; i < values.size(); ++i) visited = visited + !values.GetAt(i).IsNull();
+						}
+					});
+				}
+			}
+			else {
+				// Only a batch of rows is alive at any time, as with a cursor, and rewinding reads them again.
+				const auto stream = [&](const bool count) {
+					std::vector<std::vector<wmipp::Value>> batch;
+					for (std::size_t offset = 0; offset < rows.size(); offset += configuration.batch_size) {
+						const auto first = rows.begin() + static_cast<std::ptrdiff_t>(offset);
+						const auto last = rows.begin() + static_cast<std::ptrdiff_t>((std::min)(rows.size(), offset + configuration.batch_size));
+						batch.assign(first, last);
+
+						for (const auto& row : batch) {
+							if (count) meter.Count([&] { return RowSize(row); });
+							else visited = visited + row.size();
+						}
+					}
+				};
+
+				stream(true);
+				if (arguments_.rewindable) meter.SecondPass([&] { stream(false); });
+			}
+
+			meter.Finish();
+			return sample;
+		}
+
+		std::vector<std::wstring> GetPaths() override {
+			std::vector<std::wstring> paths;
+			for (std::size_t column = 0; column < capture_.names.size(); ++column) {
+				if (!wmipp::wql::EqualsIgnoreCase(capture_.names[column], L"__PATH")) continue;
+
+				for (const auto& row : capture_.rows) {
+					if (const auto path = row[column].AsString()) paths.emplace_back(*path);
+				}
+			}
+
+			return paths;
+		}
+
+		[[nodiscard]] std::string DescribeJson() const override {
+			return "\"replay\": " + JsonString(ToUtf8(arguments_.replay));
+		}
+
+	private:
+		const Arguments& arguments_;
+		wmipp::bench::Capture capture_;
+	};
+
+#if defined(_WIN32)
+	/**
+	 * \brief Executes the query against WMI.
+	 */
+	class WmiBackend final : public Backend {
+	public:
+		// A shared Interface also keeps COM initialized between the executions of fresh ones.
+		explicit WmiBackend(const Arguments& arguments)
+			: arguments_(arguments), shared_(wmipp::Interface::Create(arguments.path)) {}
+
+		Sample Run(const Configuration& configuration) override {
+			Sample sample;
+			Meter meter(sample);
+			const auto iface = arguments_.reuse_connection ? shared_ : wmipp::Interface::Create(arguments_.path);
+			meter.Connected();
+
+			wmipp::QueryOptions options;
+			options.batch_size = static_cast<ULONG>(configuration.batch_size);
+			options.report = true;
+			options.rewindable = arguments_.rewindable;
+
+			// The second pass does not size the objects, so that it measures their retrieval alone.
+			const auto count = [&](const wmipp::Object& object) {
+				meter.Count([&] { return object.EstimatedSize(); });
+			};
+
+			std::optional<wmipp::ExecutionReport> report;
+			if (configuration.mode == Mode::Result) {
+				const auto result = iface->ExecuteQuery(arguments_.query, options);
+				for (const auto& object : result) count(object);
+				report = result.GetReport();
+
+				if (arguments_.rewindable) {
+					meter.SecondPass([&] {
+						for (const auto& object : result) static_cast<void>(object);
+					});
+				}
+			}
+			else if (configuration.mode == Mode::Columnar) {
+				options.strategy = wmipp::Strategy::Stream;
+				auto cursor = iface->StreamQuery(arguments_.query, options);
+				meter.CountTable(cursor.ToColumnar());
+				report = cursor.GetReport();
+
+				if (arguments_.rewindable) {
+					meter.SecondPass([&] {
+						cursor.Reset();
+						static_cast<void>(cursor.ToColumnar());
+					});
+				}
+			}
+			else {
+				options.strategy = configuration.mode == Mode::Materialize
+					? wmipp::Strategy::Materialize
+					: configuration.mode == Mode::Stream ? wmipp::Strategy::Stream : wmipp::Strategy::Auto;
+
+				auto cursor = iface->StreamQuery(arguments_.query, options);
+				for (const auto& object : cursor) count(object);
+				report = cursor.GetReport();
+
+				if (arguments_.rewindable) {
+					meter.SecondPass([&] {
+						cursor.Reset();
+						for (const auto& object : cursor) static_cast<void>(object);
+					});
+				}
+			}
+
+			meter.Finish(report ? report->execute_time : Clock::duration{});
+			return sample;
+		}
+
+		std::vector<std::wstring> GetPaths() override {
+			std::vector<std::wstring> paths;
+			for (const auto& object : shared_->ExecuteQuery(arguments_.query)) {
+				if (auto path = object.GetPath()) paths.push_back(std::move(*path));
+			}
+
+			return paths;
+		}
+
+		[[nodiscard]] std::string DescribeJson() const override {
+			return "\"namespace\": " + JsonString(arguments_.path);
+		}
+
+		/**
+		 * \brief Executes the query once, and captures the properties of its objects, followed by their paths.
+		 * The properties and their types are those of the first object.
+		 */
+		[[nodiscard]] wmipp::bench::Capture Capture() const {
+			wmipp::bench::Capture capture;
+			capture.query = arguments_.query;
+
+			const auto result = shared_->ExecuteQuery(arguments_.query);
+			if (result.Count() != 0) {
+				capture.names = result[0].GetPropertyNames();
+				for (const auto& name : capture.names) {
+					capture.types.push_back(result[0].GetProperty<wmipp::Value>(name).value_or(wmipp::Value()).GetType());
+				}
+			}
+
+			capture.names.emplace_back(L"__PATH");
+			capture.types.push_back(wmipp::CimType::String);
+
+			for (const auto& object : result) {
+				auto& row = capture.rows.emplace_back();
+				for (std::size_t i = 0; i + 1 < capture.names.size(); ++i) {
+					row.push_back(object.GetProperty<wmipp::Value>(capture.names[i]).value_or(wmipp::Value::Null(capture.types[i])));
+				}
+
+				const auto path = object.GetPath();
+				row.push_back(path ? wmipp::Value(*path, wmipp::CimType::String) : wmipp::Value::Null(wmipp::CimType::String));
+			}
+
+			return capture;
+		}
+
+	private:
+		const Arguments& arguments_;
+		std::shared_ptr<wmipp::Interface> shared_;
+	};
+#endif
+
+	/**
+	 * \brief Parses the given object paths, round-robin, until the given number of parses.
+	 * \return The number of seconds per parse, or std::nullopt if there are no paths.
+	 */
+	std::optional<double> ParsePaths(const Arguments& arguments, const std::vector<std::wstring>& paths) {
+		if (paths.empty()) return std::nullopt;
+
+		// Counting the keys makes their parsing part of the measurement, and keeps the loop from being elided.
+		volatile std::size_t keys = 0;
+		const auto start = Clock::now();
+		for (std::size_t i = 0; i < arguments.path_parses; ++i) {
+			if (const auto path = wmipp::ObjectPath::Parse(paths[i % paths.size()])) keys = keys + path->KeyCount();
+		}
+
+		return Seconds(Clock::now() - start) / static_cast<double>(arguments.path_parses);
+	}
+
+	Summary Summarize(std::vector<double> values) {
+		std::sort(values.begin(), values.end());
+		const auto percentile = [&](const double p) {
+			const auto index = static_cast<std::size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+			return values[index];
+		};
+
+		return {percentile(0.50), percentile(0.90), percentile(0.99), values.back()};
+	}
+
+	void PrintText(const Arguments& arguments, const Configuration& configuration, const std::vector<Sample>& samples) {
+		const auto print = [&](const char* name, double Sample::* field) {
+			std::vector<double> values;
+			for (const auto& sample : samples) values.push_back(sample.*field);
+			const auto summary = Summarize(values);
+			std::printf("  %-10s p50 %10.3f ms   p90 %10.3f ms   p99 %10.3f ms   max %10.3f ms\n",
+				name, summary.p50 * 1e3, summary.p90 * 1e3, summary.p99 * 1e3, summary.max * 1e3);
+		};
+
+		double rows = 0.0, bytes = 0.0, seconds = 0.0;
+		for (const auto& sample : samples) {
+			rows += static_cast<double>(sample.rows);
+			bytes += static_cast<double>(sample.bytes);
+			seconds += sample.total;
+		}
+
+		std::printf("%s, batch size %lu\n", ModeName(configuration.mode), static_cast<unsigned long>(configuration.batch_size));
+		print("connect", &Sample::connect);
+		print("execute", &Sample::execute);
+		print("first row", &Sample::first_row);
+		print("total", &Sample::total);
+		if (arguments.rewindable) print("2nd pass", &Sample::second_pass);
+		std::printf("  rows %.0f, bytes %.0f, %.1f rows/s\n\n",
+			rows / static_cast<double>(samples.size()),
+			bytes / static_cast<double>(samples.size()),
+			seconds > 0.0 ? rows / seconds : 0.0);
+	}
+
+	std::string Json(const Arguments& arguments, const Configuration& configuration, const std::vector<Sample>& samples) {
+		const auto summary = [&](double Sample::* field) {
+			std::vector<double> values;
+			for (const auto& sample : samples) values.push_back(sample.*field);
+			const auto result = Summarize(values);
+
+			char text[160];
+			std::snprintf(text, sizeof(text), "{\"p50\": %.9f, \"p90\": %.9f, \"p99\": %.9f, \"max\": %.9f}",
+				result.p50, result.p90, result.p99, result.max);
+			return std::string(text);
+		};
+
+		double rows = 0.0, bytes = 0.0, seconds = 0.0;
+		for (const auto& sample : samples) {
+			rows += static_cast<double>(sample.rows);
+			bytes += static_cast<double>(sample.bytes);
+			seconds += sample.total;
+		}
+
+		char totals[160];
+		std::snprintf(totals, sizeof(totals), "\"rows\": %.1f, \"bytes\": %.1f, \"rows_per_second\": %.3f",
+			rows / static_cast<double>(samples.size()),
+			bytes / static_cast<double>(samples.size()),
+			seconds > 0.0 ? rows / seconds : 0.0);
+
+		return std::string("{\"strategy\": ") + JsonString(ModeName(configuration.mode)) +
+			", \"batch_size\": " + std::to_string(configuration.batch_size) +
+			", \"iterations\": " + std::to_string(samples.size()) +
+			", \"connect\": " + summary(&Sample::connect) +
+			", \"execute\": " + summary(&Sample::execute) +
+			", \"first_row\": " + summary(&Sample::first_row) +
+			", \"total\": " + summary(&Sample::total) +
+			(arguments.rewindable ? ", \"second_pass\": " + summary(&Sample::second_pass) : std::string()) +
+			", " + totals + "}";
+	}
+
+	void Measure(const Arguments& arguments, Backend& backend) {
+		std::vector<Configuration> configurations;
+		for (const auto mode : arguments.modes) {
+			for (const auto batch_size : arguments.batch_sizes) {
+				configurations.push_back({mode, batch_size});
+			}
+		}
+
+		std::vector<std::string> results;
+		for (const auto& configuration : configurations) {
+			for (std::size_t i = 0; i < arguments.warmup; ++i) backend.Run(configuration);
+
+			std::vector<Sample> samples;
+			samples.reserve(arguments.iterations);
+			for (std::size_t i = 0; i < arguments.iterations; ++i) {
+				samples.push_back(backend.Run(configuration));
+			}
+
+			if (arguments.json) results.push_back(Json(arguments, configuration, samples));
+			else PrintText(arguments, configuration, samples);
+		}
+
+		std::optional<double> parse_time;
+		if (arguments.path_parses != 0) {
+			parse_time = ParsePaths(arguments, backend.GetPaths());
+			if (parse_time && !arguments.json) {
+				std::printf("object paths: %zu parses, %.1f ns/parse\n", arguments.path_parses, *parse_time * 1e9);
+			}
+		}
+
+		if (arguments.json) {
+			std::printf("{\"query\": %s, %s, ",
+				JsonString(ToUtf8(arguments.query)).c_str(),
+				backend.DescribeJson().c_str());
+			if (parse_time) {
+				std::printf("\"path_parses\": %zu, \"seconds_per_parse\": %.12f, ", arguments.path_parses, *parse_time);
+			}
+
+			std::printf("\"results\": [");
+			for (std::size_t i = 0; i < results.size(); ++i) {
+				std::printf("%s\n  %s", i == 0 ? "" : ",", results[i].c_str());
+			}
+			std::printf("\n]}\n");
+		}
+	}
+
+	int Main(const std::vector<std::wstring>& argv) {
+		auto arguments = ParseArguments(argv);
+		if (!arguments) {
+			PrintUsage();
+			return 2;
+		}
+
+		if (!arguments->replay.empty()) {
+			std::ifstream input(std::filesystem::path(arguments->replay), std::ios::binary);
+			auto capture = input ? wmipp::bench::ReadCapture(input) : std::nullopt;
+			if (!capture) {
+				std::fprintf(stderr, "wmipp-bench: %s is not a capture\n", ToUtf8(arguments->replay).c_str());
+				return 1;
+			}
+
+			if (arguments->query.empty()) arguments->query = capture->query;
+			ReplayBackend backend(*arguments, std::move(*capture));
+			Measure(*arguments, backend);
+			return 0;
+		}
+
+#if defined(_WIN32)
+		try {
+			WmiBackend backend(*arguments);
+			if (arguments->capture.empty()) {
+				Measure(*arguments, backend);
+				return 0;
+			}
+
+			const auto capture = backend.Capture();
+			std::ofstream output(std::filesystem::path(arguments->capture), std::ios::binary);
+			wmipp::bench::WriteCapture(output, capture);
+			if (!output) {
+				std::fprintf(stderr, "wmipp-bench: cannot write %s\n", ToUtf8(arguments->capture).c_str());
+				return 1;
+			}
+
+			std::printf("captured %zu objects\n", capture.rows.size());
+			return 0;
+		}
+		catch (const wmipp::Exception& exception) {
+			std::fprintf(stderr, "wmipp-bench: %s\n", exception.what());
+			return 1;
+		}
+#else
+		return 2;
+#endif
+	}
+} // namespace
+
+#if defined(_WIN32)
+int wmain(const int argc, wchar_t* argv[]) {
+	return Main(std::vector<std::wstring>(argv, argv + argc));
+}
+#else
+int main(const int argc, char* argv[]) {
+	// The arguments are UTF-8, like the captures.
+	std::vector<std::wstring> arguments;
+	for (auto i = 0; i < argc; ++i) arguments.push_back(wmipp::detail::FromUtf8(argv[i]));
+	return Main(arguments);
+}
+#endif